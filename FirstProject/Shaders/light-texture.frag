@@ -24,11 +24,12 @@ struct Light {
 	vec3 specular;
 };
 
-// Material details
+// Material details. The maps are layers of texture arrays (see Texture_Arrays)
 struct Material {
-	sampler2D diffuse;
-	sampler2D specular;
-	sampler2D normal;
+	sampler2DArray diffuse;
+	sampler2DArray specular;
+	sampler2DArray normal;
+	ivec3 layers; // Layer of the diffuse, specular and normal map
 	vec3 diffuse_color;
 	float shininess;
 	bool loaded;
@@ -84,7 +85,7 @@ void main()
 	{
 		if(material[mat_idx].loaded)
 		{
-			float alpha = (texture(material[mat_idx].diffuse, vs_out.TexCoord)).a;
+			float alpha = (texture(material[mat_idx].diffuse, vec3(vs_out.TexCoord, material[mat_idx].layers.x))).a;
 			if(alpha >= 0.01)
 			{
 				will_discard = false;
@@ -103,7 +104,11 @@ void main()
 
 
 	// Fragment Specific Values
-	vec3 norm = normalize(texture(material[0].normal, vs_out.TexCoord).rgb * 2 - 1.0);
+	vec3 norm = texture(material[0].normal, vec3(vs_out.TexCoord, material[0].layers.z)).rgb * 2 - 1.0;
+	// BC5 normal maps only store X and Y (blue reads 0), so rebuild Z for those
+	if(norm.z < -0.99 && dot(norm.xy, norm.xy) <= 1.0)
+		norm.z = sqrt(1.0 - dot(norm.xy, norm.xy));
+	norm = normalize(norm);
 
 	vec3 viewDir = normalize(vs_out.TangentViewPos - vs_out.TangentFragPos);
 
@@ -129,13 +134,13 @@ void main()
 		float tier_1_scale = 1 - tier_0_scale - tier_2_scale;
 
 		// Combine materials into a single mixed material
-		mixed_material.diffuse = tier_0_scale * vec3(texture(material[0].diffuse, vs_out.TexCoord)) +
-				tier_1_scale * vec3(texture(material[1].diffuse, vs_out.TexCoord)) +
-				tier_2_scale * vec3(texture(material[2].diffuse, vs_out.TexCoord));
+		mixed_material.diffuse = tier_0_scale * vec3(texture(material[0].diffuse, vec3(vs_out.TexCoord, material[0].layers.x))) +
+				tier_1_scale * vec3(texture(material[1].diffuse, vec3(vs_out.TexCoord, material[1].layers.x))) +
+				tier_2_scale * vec3(texture(material[2].diffuse, vec3(vs_out.TexCoord, material[2].layers.x)));
 
-		mixed_material.specular = tier_0_scale * vec3(texture(material[0].specular, vs_out.TexCoord)) +
-			tier_1_scale * vec3(texture(material[1].specular, vs_out.TexCoord)) +
-			tier_2_scale * vec3(texture(material[2].specular, vs_out.TexCoord));
+		mixed_material.specular = tier_0_scale * vec3(texture(material[0].specular, vec3(vs_out.TexCoord, material[0].layers.y))) +
+			tier_1_scale * vec3(texture(material[1].specular, vec3(vs_out.TexCoord, material[1].layers.y))) +
+			tier_2_scale * vec3(texture(material[2].specular, vec3(vs_out.TexCoord, material[2].layers.y)));
 
 		mixed_material.shininess = tier_0_scale * material[0].shininess +
 			tier_1_scale * material[1].shininess +
@@ -200,9 +205,9 @@ vec3 CalcDirLight(Light light, vec3 normal, vec3 viewDir, Material material)
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, vs_out.TexCoord));
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, vec3(vs_out.TexCoord, material.layers.y)));
     return (ambient + diffuse + specular);
 }
 
@@ -219,9 +224,9 @@ vec3 CalcPointLight(Light light, vec3 normal, vec3 lightPos, vec3 viewDir, Mater
     float distance = length(lightPos - vs_out.TangentFragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, vs_out.TexCoord));
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, vec3(vs_out.TexCoord, material.layers.y)));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -245,9 +250,9 @@ vec3 CalcSpotLight(Light light, vec3 normal, vec3 lightPos, vec3 viewDir, Materi
     float epsilon = light.cut_off - light.outer_cut_off;
     float intensity = clamp((theta - light.outer_cut_off) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vs_out.TexCoord));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, vs_out.TexCoord));
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vec3(vs_out.TexCoord, material.layers.x)));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, vec3(vs_out.TexCoord, material.layers.y)));
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
@@ -24,9 +24,9 @@ struct Light {
 	vec3 specular;
 };
 
+// Final model matrix (object * component * mesh) and its inverse transpose, built on the CPU per draw
 uniform mat4 model;
-uniform mat4 component;
-uniform mat4 object;
+uniform mat3 normal_matrix;
 
 uniform mat4 view;
 uniform mat4 projection;
@@ -52,16 +52,16 @@ out Vert {
 void main()
 {
 	vs_out.TexCoord = vec2(texCoord.x, texCoord.y);
-	vs_out.Normal = mat3(transpose(inverse(object * component * model))) * normal;
-	vs_out.FragPos = vec3(object * component * model * vec4(position, 1.0f));
+	vec4 world_position = model * vec4(position, 1.0f);
+	vs_out.Normal = normal_matrix * normal;
+	vs_out.FragPos = vec3(world_position);
 
 	// https://learnopengl.com/#!Advanced-Lighting/Normal-Mapping
-	mat3 normalMatrix = transpose(inverse(mat3(object * component * model)));
-    vec3 T = normalize(normalMatrix * tangent);
-    vec3 N = normalize(normalMatrix * normal);
+    vec3 T = normalize(normal_matrix * tangent);
+    vec3 N = normalize(normal_matrix * normal);
     // T = normalize(T - dot(T, N) * N);
     // vec3 B = cross(N, T);
-    vec3 B = normalize(normalMatrix * bitangent);
+    vec3 B = normalize(normal_matrix * bitangent);
 
     vs_out.TBN = transpose(mat3(T, B, N));    
     vs_out.TangentViewPos  = vs_out.TBN * viewPos;
@@ -72,5 +72,5 @@ void main()
 		vs_out.TangentLightPos[i] = vs_out.TBN * light[i].position;
 	}
 
-	gl_Position = projection * view * object * component * model * vec4(position, 1);
+	gl_Position = projection * view * world_position;
 }
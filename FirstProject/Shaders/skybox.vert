@@ -1,15 +1,18 @@
 #version 330
 
-layout (location = 0) in vec3 tex_ver;
-
-uniform mat4 projection;
-uniform mat4 view;
+// Inverse of projection * the camera's rotation: clip space back to world directions
+uniform mat4 sky_matrix;
 
 out vec3 texCoords;
 
 void main(void) {
-    texCoords = tex_ver;
-    vec4 pos = projection * view * vec4(tex_ver, 1.0);
-    gl_Position = pos.xyww;
+    // One triangle over the whole screen: (-1,-1), (3,-1), (-1,3)
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    // The direction through this corner; interpolates correctly as the triangle is flat at w = 1
+    vec4 world = sky_matrix * vec4(corner, 1.0, 1.0);
+    texCoords = world.xyz / world.w;
 
+    // z = w puts it on the far plane (depth 1.0)
+    gl_Position = vec4(corner, 1.0, 1.0);
 }
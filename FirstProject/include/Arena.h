@@ -0,0 +1,97 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Linear (bump pointer) allocator for short lived memory. Allocations are carved out of
+ * large blocks and never freed one by one; reset() forgets everything at once and keeps the blocks,
+ * so an arena that is reset every frame (or every loaded shape) stops touching the heap after warm up.
+ * Arena_Allocator plugs an arena into standard containers (Arena_Vector, Arena_String) the way a
+ * std::pmr::monotonic_buffer_resource would, without needing C++17. Not thread safe: one arena per thread.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT alignof(std::max_align_t)
+
+class Arena {
+public:
+	explicit Arena(size_t block_size = ARENA_BLOCK_SIZE);
+	~Arena();
+
+	// Uninitialised memory valid until the next reset(). Requests larger than a block get their own block
+	void* allocate(size_t bytes, size_t alignment = ARENA_ALIGNMENT);
+
+	template <typename T>
+	T* allocate_array(size_t count)
+	{
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// Copy of a string that lives in the arena
+	const char* copy(const char* text, size_t length);
+
+	// Release every allocation at once. Blocks are kept for reuse
+	void reset();
+
+	// Bytes handed out / allocations made since the last reset
+	size_t used();
+	uint64_t allocations();
+	// Bytes held in blocks
+	size_t capacity();
+
+private:
+	Arena(const Arena &) = delete;
+	Arena& operator=(const Arena &) = delete;
+
+	struct Block {
+		char* data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t block_size;
+	size_t current;		// Block being filled
+	size_t offset;		// Next free byte in it
+	size_t bytes_used;
+	uint64_t allocation_count;
+};
+
+// Standard allocator over an Arena. deallocate() is a no-op; memory comes back on Arena::reset()
+template <typename T>
+class Arena_Allocator {
+public:
+	typedef T value_type;
+
+	explicit Arena_Allocator(Arena* arena) : arena(arena) {}
+
+	template <typename U>
+	Arena_Allocator(const Arena_Allocator<U> &other) : arena(other.arena) {}
+
+	T* allocate(size_t count)
+	{
+		return arena->allocate_array<T>(count);
+	}
+
+	void deallocate(T*, size_t) {}
+
+	Arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const Arena_Allocator<T> &lhs, const Arena_Allocator<U> &rhs)
+{
+	return lhs.arena == rhs.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const Arena_Allocator<T> &lhs, const Arena_Allocator<U> &rhs)
+{
+	return lhs.arena != rhs.arena;
+}
+
+template <typename T>
+using Arena_Vector = std::vector<T, Arena_Allocator<T>>;
+
+typedef std::basic_string<char, std::char_traits<char>, Arena_Allocator<char>> Arena_String;
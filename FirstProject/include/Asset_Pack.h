@@ -0,0 +1,79 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Asset pack archive. Many small asset files (meshes, materials, statics, scenes,
+ * shaders, cooked textures) stored in one file that is opened with a single memory mapping, instead
+ * of each being opened, read and closed on its own at start up.
+ *
+ * Layout: an Asset_Pack_Header, the table of contents (one Asset_Pack_Entry per file, sorted by the
+ * XXH64 of its path so find() is a binary search), the paths, then every file's bytes starting on an
+ * ASSET_PACK_ALIGNMENT boundary. Paths are stored as VFS::normalise gives them ("Meshes/Tree.obj").
+ * Each entry keeps the source file's modification time, so cache staleness checks (Texture_Cache)
+ * work inside a pack as they do on disk.
+ *
+ * Build one with "make asset_pack"; the game mounts it through the VFS.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/Mapped_File.h"
+
+#define ASSET_PACK_MAGIC 0x4b415041	// "APAK"
+#define ASSET_PACK_VERSION 1
+// File contents start on multiples of this (a cache line), so loaders can read them in place
+#define ASSET_PACK_ALIGNMENT 64
+
+struct Asset_Pack_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t reserved;
+	// From the start of the pack
+	uint64_t names_offset;
+	uint64_t names_bytes;
+};
+
+struct Asset_Pack_Entry {
+	uint64_t path_hash;
+	uint64_t offset;
+	uint64_t size;
+	int64_t modified;
+	// Into the paths block; not NUL terminated
+	uint32_t name_offset;
+	uint32_t name_length;
+};
+
+class Asset_Pack {
+public:
+	Asset_Pack();
+
+	// Maps the pack and checks its table. False (and a message on std::cerr) if it is not a valid pack
+	bool open(const std::string &pack_file);
+	void close();
+	bool is_open();
+
+	// The entry for a normalised path, or nullptr
+	const Asset_Pack_Entry* find(const std::string &path);
+	const unsigned char* contents(const Asset_Pack_Entry &entry);
+	std::string name(const Asset_Pack_Entry &entry);
+	uint32_t entry_count();
+	const Asset_Pack_Entry &entry(uint32_t index);
+	size_t size();
+	const std::string &file_name();
+
+	// Writes files (paths relative to the working directory) into a new pack at pack_file. Thread safe.
+	// False (and a message on std::cerr) if a file could not be read or the pack written
+	static bool write(const std::string &pack_file, const std::vector<std::string> &files);
+
+private:
+	Asset_Pack(const Asset_Pack &) = delete;
+	Asset_Pack& operator=(const Asset_Pack &) = delete;
+
+	Mapped_File m_file;
+	std::string m_file_name;
+	const Asset_Pack_Entry* m_entries;
+	uint32_t m_entry_count;
+	const char* m_names;
+};
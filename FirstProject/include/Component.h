@@ -20,21 +20,37 @@
 #include <sstream>
 
 #include "../include/Mesh.h"
+#include "../include/Render_Snapshot.h"
 
 class Component {
 public:
     Component();
-	Component(std::string name, std::string static_details, loadedComponents* scene_tracker);
-	Component(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, loadedComponents* scene_tracker);
+	Component(std::string name, std::string static_details, Resource_Manager* scene_tracker);
+	Component(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, Resource_Manager* scene_tracker);
+	// Copy of a loaded component: shares its mesh (one more reference) and local transform, reads no files
+	Component(const Component &prototype);
+	Component& operator=(const Component &) = delete;
 	~Component();
 
-	void draw(GLuint shader);
+	// Appends this component's mesh with the model and normal matrices built by Transforms->update_world()
+	void snapshot(std::vector<Draw_Item> &draw_list);
+
+	// Place this component inside its owner's transform (Object or Player_Controller)
+	void set_parent(Transform_Handle parent);
+
+	// Local transform changes; the world matrices follow on the next Transforms->update_world()
+	void set_location(glm::vec3 location);
+	void set_rotation(glm::quat rotation);
+	void set_scale(glm::vec3 scale);
+	// Scene bounds are cached on the first collision test; call when the owner moves
+	void invalidate_scene_bounds();
 
 	glm::vec3 get_lower_bounds();
 	glm::vec3 get_upper_bounds();
 	bool is_collision(glm::vec3 lower_bound, glm::vec3 upper_bound, glm::mat4 &scene_transform);
 
 private:
+	void acquire_mesh();
 	void build_component_transform();
 
 	void compute_bounds();
@@ -42,15 +58,12 @@ private:
 
 	std::string m_name;
 	std::string m_mesh_name;
+	// Reference held on the shared mesh; m_Mesh stays valid while we hold it
+	Mesh_Handle m_mesh_handle;
 	Mesh* m_Mesh;
 
-	glm::quat* m_rotation;
-	glm::vec3* m_location;
-	glm::vec3* m_scale;
-	glm::mat4 m_transform;
-
-	glm::vec3 m_lower_bounds;
-	glm::vec3 m_upper_bounds;
+	// Local location, rotation, scale, matrix and bounds (within the object) live in scene_tracker->Transforms
+	Transform_Handle m_handle;
 
 	glm::vec3 m_scene_lower_bounds = glm::vec3(0);
 	glm::vec3 m_scene_upper_bounds = glm::vec3(0);
@@ -58,5 +71,5 @@ private:
 	std::vector<std::pair<std::string, GLuint>> textures;
 
 	// Carry so we can update and remove components as needed
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
 };
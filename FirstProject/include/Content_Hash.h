@@ -0,0 +1,15 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: 64-bit content hashes (XXH64) for spotting files with identical bytes under different
+ * names. A different seed gives an unrelated hash of the same bytes, so callers can keep the same
+ * file loaded two ways (e.g. as a colour and as a normal map) apart.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+uint64_t content_hash(const void* data, size_t bytes, uint64_t seed = 0);
+
+// Hash of the whole file, read in place through the VFS (packed or mapped). 0 when it can't be opened
+uint64_t file_content_hash(const std::string &file_name, uint64_t seed = 0);
@@ -10,13 +10,23 @@
 	#include <dirent.h>
 #endif // _WIN32 || _WIN64
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <iostream>
 
 std::vector<std::string> DirectoryContents(std::string dir);
 
+// Every file below dir, sub directories included, as paths relative to dir ("a.png", "sub/b.png")
+std::vector<std::string> DirectoryTree(std::string dir);
+
 // Taken from viewer.cc (in interest of time)
 std::string GetBaseDir(const std::string &filepath);
 
 bool FileExists(const std::string &abs_filename);
+
+// Last modification time in seconds since the epoch, or -1 if the file is missing
+int64_t FileModifiedTime(const std::string &filename);
+
+// Creates the directory (one level) if it is not already there
+bool MakeDirectory(const std::string &dir);
@@ -0,0 +1,160 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Open addressing hash map keyed by String_ID. Keys and values sit in one flat array
+ * (linear probing, power of two capacity, erase by backward shift), so a lookup is a hash, a mask
+ * and usually one cache line. Slots expose first / second like std::map so range-for loops read the
+ * same. Pointers and references into the map are invalidated by any insert that grows it.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "../include/String_ID.h"
+
+#define FLAT_MAP_MIN_CAPACITY 16
+
+template <typename Value>
+class Flat_Map {
+public:
+	struct Slot {
+		String_ID first;
+		Value second;
+	};
+
+	class iterator {
+	public:
+		iterator(Flat_Map* map, size_t index) : map(map), index(index) { skip(); }
+		Slot& operator*() { return map->slots[index]; }
+		Slot* operator->() { return &map->slots[index]; }
+		iterator& operator++() { ++index; skip(); return *this; }
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+	private:
+		void skip() { while (index < map->used.size() && !map->used[index]) ++index; }
+		Flat_Map* map;
+		size_t index;
+	};
+
+	Flat_Map() : count(0) {}
+
+	// nullptr when the key is missing
+	Value* find(String_ID key)
+	{
+		if (count == 0)
+			return nullptr;
+
+		for (size_t index = home(key); used[index]; index = (index + 1) & mask())
+		{
+			if (slots[index].first == key)
+				return &slots[index].second;
+		}
+		return nullptr;
+	}
+
+	bool contains(String_ID key) { return find(key) != nullptr; }
+
+	// Key must be present
+	Value& at(String_ID key) { return *find(key); }
+
+	// Inserts a default constructed value if the key is missing
+	Value& operator[](String_ID key)
+	{
+		Value* found = find(key);
+		if (found)
+			return *found;
+
+		if ((count + 1) * 4 > slots.size() * 3)
+			rehash(slots.empty() ? FLAT_MAP_MIN_CAPACITY : slots.size() * 2);
+
+		size_t index = home(key);
+		while (used[index])
+			index = (index + 1) & mask();
+
+		used[index] = 1;
+		slots[index].first = key;
+		slots[index].second = Value();
+		count++;
+		return slots[index].second;
+	}
+
+	bool erase(String_ID key)
+	{
+		if (count == 0)
+			return false;
+
+		size_t index = home(key);
+		while (used[index] && slots[index].first != key)
+			index = (index + 1) & mask();
+		if (!used[index])
+			return false;
+
+		// Shift later members of the probe run back so lookups never hit a hole
+		size_t next = (index + 1) & mask();
+		while (used[next])
+		{
+			size_t ideal = home(slots[next].first);
+			if (((next - ideal) & mask()) >= ((next - index) & mask()))
+			{
+				slots[index] = slots[next];
+				index = next;
+			}
+			next = (next + 1) & mask();
+		}
+
+		used[index] = 0;
+		slots[index].second = Value();
+		count--;
+		return true;
+	}
+
+	void reserve(size_t entries)
+	{
+		size_t capacity = FLAT_MAP_MIN_CAPACITY;
+		while (capacity * 3 < entries * 4)
+			capacity *= 2;
+		if (capacity > slots.size())
+			rehash(capacity);
+	}
+
+	void clear()
+	{
+		slots.clear();
+		used.clear();
+		count = 0;
+	}
+
+	size_t size() { return count; }
+	bool empty() { return count == 0; }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, used.size()); }
+
+private:
+	// IDs are already hashes; fold the high bits in so small tables use them too
+	size_t home(String_ID key) { return (key ^ (key >> 16)) & mask(); }
+	size_t mask() { return slots.size() - 1; }
+
+	void rehash(size_t capacity)
+	{
+		std::vector<Slot> old_slots(capacity);
+		std::vector<uint8_t> old_used(capacity, 0);
+		old_slots.swap(slots);
+		old_used.swap(used);
+
+		for (size_t index = 0; index < old_slots.size(); ++index)
+		{
+			if (!old_used[index])
+				continue;
+
+			size_t target = home(old_slots[index].first);
+			while (used[target])
+				target = (target + 1) & mask();
+			used[target] = 1;
+			slots[target] = old_slots[index];
+		}
+	}
+
+	std::vector<Slot> slots;
+	std::vector<uint8_t> used;
+	size_t count;
+};
@@ -0,0 +1,32 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Per frame scratch memory and heap allocation counts. The scratch arena is rewound by
+ * new_frame(), so anything the frame needs only until it is drawn (uniform names, temporary lists)
+ * costs a pointer bump instead of a malloc. Every global operator new is counted (relaxed atomics),
+ * which is how we check that a steady state frame makes no heap allocations at all.
+*/
+
+#include <cstdint>
+#include <string>
+
+#include "../include/Arena.h"
+
+class Frame_Memory {
+public:
+	// Call once at the top of every frame: closes the previous frame's counts and rewinds the scratch arena
+	static void new_frame();
+
+	// Memory valid until the next new_frame(). Main (GL) thread only
+	static Arena& scratch();
+
+	// printf into the scratch arena
+	static const char* format(const char* format, ...);
+
+	// Heap allocations (all threads) since new_frame()
+	static uint64_t frame_allocations();
+	static uint64_t frame_allocated_bytes();
+	static uint64_t total_allocations();
+
+	// Mean and worst allocations per completed frame
+	static std::string report();
+};
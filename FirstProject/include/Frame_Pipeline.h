@@ -0,0 +1,86 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Two stage frame pipeline. Each frame the caller submits a simulation step, which
+ * advances the world and fills a Render_Snapshot, then draws front() and calls present() and sync().
+ *
+ * Serial mode runs the step immediately into the one snapshot, so front() is the frame just
+ * simulated. Threaded mode ("--pipeline") runs the step on a worker thread into the back snapshot
+ * while the caller draws the front one (the previous step's result); sync() is the only point the
+ * two meet: it waits for the worker and swaps the snapshots. Anything that changes the scene's
+ * structure (attaching / removing objects, loading meshes) must happen between sync() and the next
+ * submit(), when the worker is idle, and the renderer reads nothing but the snapshot.
+ *
+ * Both modes measure latency (input applied to frame presented), frames per second and the time
+ * spent simulating, rendering and waiting at the sync point, so they can be compared directly.
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../include/Render_Snapshot.h"
+#include "../include/Seconds_Per_Frame_Counter.h"
+
+class Frame_Pipeline {
+public:
+	typedef std::function<void(Render_Snapshot &snapshot)> Step;
+
+	Frame_Pipeline(bool threaded);
+	~Frame_Pipeline();
+
+	bool threaded();
+
+	// Start the simulation step for the next frame. The step fills the snapshot it is given and
+	// must outlive the following sync(); keep it in one variable so no frame copies a std::function
+	void submit(const Step &step);
+	// The snapshot to draw this frame
+	Render_Snapshot& front();
+	// Call once front() is on screen (after the buffer swap): records its latency
+	void present();
+	// Sync point: waits for the step in flight, then makes its snapshot the next front()
+	void sync();
+
+	// Presented frames per second of wall time, from the first present() to the last
+	double frames_per_second();
+	// Milliseconds per presented frame
+	Frame_Histogram* latency_times();
+	Frame_Histogram* simulation_times();
+	Frame_Histogram* render_times();
+	Frame_Histogram* wait_times();
+
+	// Forget the frames measured so far (e.g. after a warm up)
+	void clear_stats();
+
+	// Frames per second, latency and per stage times for every presented frame
+	std::string report();
+
+private:
+	void worker_loop();
+
+	bool m_threaded;
+	Render_Snapshot snapshots[2];
+	uint32_t front_index;
+	uint64_t submitted;
+
+	// Worker hand off, guarded by lock
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const Step* pending;
+	bool busy;
+	bool stopping;
+
+	std::chrono::steady_clock::time_point first_present;
+	std::chrono::steady_clock::time_point render_start;
+	std::chrono::steady_clock::time_point last_present;
+	Frame_Histogram latency;
+	Frame_Histogram simulation;
+	Frame_Histogram render;
+	Frame_Histogram wait;
+	Frame_Histogram interval;
+};
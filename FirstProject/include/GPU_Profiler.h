@@ -0,0 +1,72 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: GPU pass timings using GL_TIME_ELAPSED queries (core since GL 3.3, so this also
+ * works on software rasterisers such as Mesa llvmpipe).
+ * Each pass owns GPU_PROFILER_LATENCY queries used round robin, so a result is only
+ * read back once the frame that issued it is that many frames old. Results that are still
+ * not available are dropped rather than waited on; we never stall the pipeline.
+ * Resolved timings are handed to the CPU Profiler so both appear in the same report.
+ * Timer queries cannot nest, so GPU scopes must wrap sequential passes only.
+*/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "../include/Profiler.h"
+
+// Frames of queries in flight before we read a result back
+#define GPU_PROFILER_LATENCY 3
+
+#ifdef ENABLE_PROFILER
+	#define GPU_PROFILE_SCOPE(name) GPU_Profile_Scope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+	#define GPU_PROFILE_FRAME() GPU_Profiler::new_frame()
+#else
+	#define GPU_PROFILE_SCOPE(name)
+	#define GPU_PROFILE_FRAME() ((void)0)
+#endif
+
+class GPU_Profiler {
+public:
+	// Collect results from GPU_PROFILER_LATENCY frames ago, then start the next frame
+	static void new_frame();
+
+	// Returns false if the pass was not started (nested, or already timed this frame)
+	static bool begin(const char* name);
+	static void end();
+
+	// Timer queries that were still pending when their slot came round again
+	static uint64_t dropped_results();
+
+	// Delete all query objects. Call while the context is still current
+	static void release();
+
+private:
+	struct Pass {
+		const char* name;
+		GLuint queries[GPU_PROFILER_LATENCY];
+		bool issued[GPU_PROFILER_LATENCY];
+		uint64_t submitted[GPU_PROFILER_LATENCY];	// CPU time the query began
+		uint32_t frame[GPU_PROFILER_LATENCY];
+	};
+
+	static Pass* find_pass(const char* name);
+
+	static std::vector<Pass> passes;
+	static int active_pass;
+	static uint32_t slot;
+	static uint64_t dropped;
+	static bool warned_nesting;
+};
+
+class GPU_Profile_Scope {
+public:
+	explicit GPU_Profile_Scope(const char* name);
+	~GPU_Profile_Scope();
+private:
+	bool m_active;
+};
@@ -12,7 +12,6 @@ to use multiple layers of textures with transitions between them.
 #define IMAGE_DEPTH 255.0
 #define NORMAL_UP_DEPTH 64.0
 
-#define TEXTURE_MAPS 3
 #include <string>
 // GLEW
 #define GLEW_STATIC
@@ -25,6 +24,8 @@ to use multiple layers of textures with transitions between them.
 
 #include "../include/Mesh.h"
 
+class Image_Future;
+
 typedef struct {
 	GLuint va;
 	GLuint vb[6];  // vertex buffer
@@ -36,7 +37,7 @@ glm::vec3 calculate_surface_normal(glm::vec3 const vertex_1, glm::vec3 const ver
 class Heightmap
 {
 public:
-	Heightmap(std::string name, std::string height_map_file, loadedComponents* scene_tracker);
+	Heightmap(std::string name, std::string height_map_file, Resource_Manager* scene_tracker);
 	~Heightmap();
 
 	void ReleaseHeightmap();
@@ -73,8 +74,11 @@ private:
 	void build_transform();
 
 	void setupTextures(std::string);
-	void loadTexture(std::string, std::string);
-	bool LoadHeightMapFromImage(std::string sImagePath);
+	void loadTexture(std::string, std::string, Texture_Usage usage = TEXTURE_COLOUR);
+	void resolveTextures();
+	Texture_Slot resolveTexture(const std::string &texture_name);
+	// decoding is the image's Image_Decoder::decode, queued early so it runs while the materials load
+	bool LoadHeightMapFromImage(std::string sImagePath, Image_Future &decoding);
 
 	std::string m_name;
 	std::string m_height_file;
@@ -82,7 +86,7 @@ private:
 	glm::mat4 m_transform;
 	int indices_count;
 
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
 
 	DrawMap m_map;
 
@@ -94,10 +98,20 @@ private:
 	uint32_t composition;
 
 	unsigned char* map_image;
+	// Accounted with Memory_Stats, released with the buffers / image
+	uint64_t m_buffer_bytes;
+	uint64_t m_image_bytes;
 
 	glm::vec3 m_mesh_scale;
 	glm::vec2 m_texture_scale;
 	glm::vec3 m_location;
 
 	std::vector<tinyobj::material_t>* materials;
+	// GL names resolved once textures are loaded, one per material
+	std::vector<Material_Textures> material_textures;
+	GLuint m_height_texture;
+	// One reference per loadTexture() call, released with the heightmap
+	std::vector<Texture_Handle> texture_handles;
+	// While setupTextures() gathers them: the textures loadTexture() was asked for, loaded afterwards
+	std::vector<std::pair<std::string, Texture_Usage>>* gathering_textures;
 };
@@ -0,0 +1,79 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Decodes image files (stb_image) on the job system's workers, so loading several
+ * textures costs about the slowest decode rather than their sum. decode() and prepare() queue the
+ * work and hand back an Image_Future; the GL thread calls get() when it is ready to upload, which
+ * waits (running other jobs meanwhile) only if the decode has not finished yet.
+ *
+ * At most IMAGE_DECODE_QUEUE decodes are in flight: queueing another first waits for the oldest, so
+ * a long list of files can't hold every decoded image in memory at once. Without workers (tools that
+ * never start the job system) the work runs on the caller inside decode() / prepare().
+*/
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/Texture_Cache.h"
+
+// Decodes queued or running at once
+#define IMAGE_DECODE_QUEUE 8
+
+// Pixels from stb_image, rows top to bottom. Free with Image_Decoder::free
+struct Decoded_Image {
+	unsigned char* pixels;
+	int width;
+	int height;
+	// Channels in pixels (the file's own count when decode() was asked for 0)
+	int channels;
+};
+
+struct Decode_State;
+
+// One queued decode. Movable, not copyable; dropping it before get() frees the pixels when they arrive
+class Image_Future {
+public:
+	Image_Future();
+	Image_Future(Image_Future &&other);
+	Image_Future& operator=(Image_Future &&other);
+	~Image_Future();
+
+	bool valid() const;
+	// True once get() would not wait
+	bool ready() const;
+	// Waits for the work, then hands over the image. pixels is nullptr (and there was a message on
+	// std::cerr) if the file could not be read, and always for prepare(). Call once
+	Decoded_Image get();
+	// As get(), for prepare(): false if the cache could not be written
+	bool wait();
+
+private:
+	friend class Image_Decoder;
+	Image_Future(const Image_Future &) = delete;
+	Image_Future& operator=(const Image_Future &) = delete;
+
+	Decode_State* state;
+};
+
+class Image_Decoder {
+public:
+	// Decodes file_name to channels per pixel (0 keeps the file's)
+	static Image_Future decode(const std::string &file_name, int channels = 0);
+	// Cooks file_name into the texture cache if that is stale, so the GL thread's Texture_Cache /
+	// Texture_Streamer load afterwards only maps the cooked file
+	static Image_Future prepare(const std::string &file_name, Texture_Usage usage);
+	// prepare() for a cube map (Texture_Cache::cook_cube)
+	static Image_Future prepare_cube(const std::vector<std::string> &faces);
+	// prepare() for each (file, usage), each file once, returning when all are done. Failures are
+	// left for the load to report
+	static void prepare_all(const std::vector<std::pair<std::string, Texture_Usage>> &files);
+
+	static void free(Decoded_Image &image);
+
+	// Images decoded and cooked, and the time spent in them summed over every thread
+	static std::string report();
+
+private:
+	static Image_Future queue(Decode_State* state);
+};
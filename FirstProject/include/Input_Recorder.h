@@ -0,0 +1,90 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Records player input to a compact binary file and plays it back, so a play session
+ * (movement, collisions, painting) can be reproduced exactly for profiling comparisons.
+ * While recording or replaying the simulation runs on a fixed timestep. Input events are stored in
+ * the order they arrived, each simulation step is closed by a STEP marker, and every rendered
+ * frame writes a FRAME marker with its real delta (kept for reference, ignored on replay).
+ * A frame longer than INPUT_MAX_CATCH_UP steps (the brush prompt, a window drag, a breakpoint) only
+ * runs that many, so a stall is not recorded as a burst of catch-up steps.
+ *
+ * File layout (native byte order):
+ *	"BEIR"  uint32 version  double timestep
+ *	then a stream of events, one type byte followed by its payload:
+ *		KEY				int16 key, uint8 action
+ *		MOUSE_BUTTON	uint8 button, uint8 action
+ *		CURSOR			double x, double y
+ *		BRUSH			uint32 brush, uint32 scale, float y_offset (answers to the brush prompt)
+ *		FRAME			float delta
+ *		STEP			(none)
+*/
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define INPUT_RECORDING_VERSION 1
+
+// Default simulation step while recording
+#define INPUT_TIMESTEP (1.0 / 60.0)
+// Most steps one rendered frame runs while recording; the rest of a longer frame is dropped
+#define INPUT_MAX_CATCH_UP 4
+
+enum input_event_types {
+	iKEY = 1,
+	iMOUSE_BUTTON,
+	iCURSOR,
+	iBRUSH,
+	iFRAME,
+	iSTEP
+};
+
+struct Input_Event {
+	uint8_t type;
+	int32_t code;		// Key, button or brush index
+	int32_t action;		// GLFW action or brush scale
+	double x;			// Cursor x, brush y offset or frame delta
+	double y;			// Cursor y
+};
+
+class Input_Recorder {
+public:
+	Input_Recorder();
+	~Input_Recorder();
+
+	bool start_recording(std::string file_name, double timestep = INPUT_TIMESTEP);
+	bool start_replay(std::string file_name);
+	// Flushes and closes a recording
+	void stop();
+
+	bool recording();
+	bool replaying();
+	double get_timestep();
+	uint64_t get_steps();
+
+	// -- Recording --
+	void key(int key, int action);
+	void mouse_button(int button, int action);
+	void cursor(double x, double y);
+	void brush(uint32_t brush, uint32_t scale, float y_offset);
+	void frame(double delta);
+	void step();
+
+	// -- Replay --
+	// Next event in the stream; returns false once the recording is exhausted
+	bool next(Input_Event &event);
+
+private:
+	template <typename T> void write(T value);
+	template <typename T> bool read(T &value);
+
+	std::ofstream out;
+	std::vector<uint8_t> data;
+	size_t cursor_pos;
+
+	bool is_recording;
+	bool is_replaying;
+	double timestep;
+	uint64_t steps;
+};
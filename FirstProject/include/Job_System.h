@@ -0,0 +1,114 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Work-stealing job scheduler. One worker per spare hardware thread; every thread that
+ * submits jobs gets its own deque (Chase-Lev: the owner pushes and pops the newest job at the bottom
+ * without locking, idle threads steal the oldest from the top), so fan-out work stays on the thread
+ * that made it until someone is free to take it.
+ *
+ * Jobs are a function pointer plus a small inline copy of their arguments, taken from a per-thread
+ * ring so creating one never touches the heap. Dependencies come two ways: a child job keeps its
+ * parent unfinished until the child completes (wait() on the parent waits for the whole tree), and
+ * a continuation is run as soon as the job it follows has finished. wait() runs other jobs while it
+ * waits, so it is safe to call from inside a job. parallel_for() splits an index range in halves
+ * down to a batch size and hands the halves out.
+ *
+ * Until start() is called (tools, tests) there are no workers and parallel_for runs on the caller.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Worker threads at most, and threads that may create jobs (workers plus the main thread, the
+// pipeline worker and anything else that submits; any beyond that run their jobs unshared)
+#define JOB_MAX_WORKERS 16
+#define JOB_MAX_THREADS 32
+// Jobs each thread can have alive at once, and its deque capacity (powers of two)
+#define JOB_POOL_SIZE 1024
+#define JOB_DEQUE_SIZE 1024
+#define JOB_MAX_CONTINUATIONS 4
+// Argument bytes stored in the job itself
+#define JOB_DATA_SIZE 48
+
+struct Job;
+typedef void (*Job_Function)(Job* job, const void* data);
+
+struct Job {
+	Job_Function function;
+	Job* parent;
+	// This job plus its unfinished children; 0 once it and every child have run
+	std::atomic<int32_t> unfinished;
+	std::atomic<int32_t> continuation_count;
+	Job* continuations[JOB_MAX_CONTINUATIONS];
+	alignas(16) unsigned char data[JOB_DATA_SIZE];
+};
+
+class Job_System {
+public:
+	// workers = 0 uses one per hardware thread beyond the caller's. Safe to call again after stop()
+	static void start(uint32_t workers = 0);
+	static void stop();
+	static bool running();
+	// Workers plus the calling thread
+	static uint32_t thread_count();
+
+	// New job with a copy of bytes of data (at most JOB_DATA_SIZE). Not scheduled until run()
+	static Job* create(Job_Function function, const void* data = nullptr, size_t bytes = 0);
+	// As create(), but parent stays unfinished until this job has run. Call before run(parent) returns
+	static Job* create_child(Job* parent, Job_Function function, const void* data = nullptr, size_t bytes = 0);
+	// Schedule continuation once job has finished. Both must not have been run yet
+	static bool add_continuation(Job* job, Job* continuation);
+
+	static void run(Job* job);
+	// Runs other jobs until job (and its children) have finished
+	static void wait(Job* job);
+	static bool finished(const Job* job);
+
+	// function(begin, end) over [0, count) in ranges of at most batch, spread over every thread.
+	// Returns once all of it has run
+	template <typename Function>
+	static void parallel_for(uint32_t count, uint32_t batch, const Function &function)
+	{
+		if (count == 0)
+			return;
+		if (batch == 0)
+			batch = 1;
+		if (count <= batch || !running())
+		{
+			function(0, count);
+			return;
+		}
+
+		Range<Function> range = { &function, 0, count, batch };
+		Job* root = create(&range_job<Function>, &range, sizeof(range));
+		run(root);
+		wait(root);
+	}
+
+private:
+	template <typename Function>
+	struct Range {
+		const Function* function;
+		uint32_t begin;
+		uint32_t end;
+		uint32_t batch;
+	};
+
+	template <typename Function>
+	static void range_job(Job* job, const void* data)
+	{
+		Range<Function> range;
+		memcpy(&range, data, sizeof(range));
+
+		// Give away the upper half until what is left fits a batch; idle threads steal the halves
+		while (range.end - range.begin > range.batch)
+		{
+			uint32_t middle = range.begin + (range.end - range.begin) / 2;
+			Range<Function> upper = { range.function, middle, range.end, range.batch };
+			run(create_child(job, &range_job<Function>, &upper, sizeof(upper)));
+			range.end = middle;
+		}
+		(*range.function)(range.begin, range.end);
+	}
+};
@@ -0,0 +1,34 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Read only memory mapping of a whole file. The OS pages the contents in as they are
+ * touched, so loaders can hand pointers straight into the file to GL (or parse it in place) with no
+ * read() copy and no heap buffer. The mapping lives until close() or the destructor.
+*/
+
+#include <cstddef>
+#include <string>
+
+class Mapped_File {
+public:
+	Mapped_File();
+	~Mapped_File();
+
+	// Maps the file, closing any previous mapping. False (and a message on std::cerr) on failure
+	bool open(const std::string &file_name);
+	void close();
+
+	bool is_open();
+	const unsigned char* data();
+	size_t size();
+
+private:
+	Mapped_File(const Mapped_File &) = delete;
+	Mapped_File& operator=(const Mapped_File &) = delete;
+
+	const unsigned char* m_data;
+	size_t m_size;
+#if _WIN32 || _WIN64
+	void* m_file;
+	void* m_mapping;
+#endif
+};
@@ -0,0 +1,45 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Bytes allocated per resource category, on the GPU (buffers, textures) and on the
+ * host (copies kept after upload). Loaders report every allocation and release here so the totals
+ * can be queried at runtime, written into benchmark results and dumped with the scene report.
+ * Counters are atomic; textures may be loaded off the GL thread.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum memory_categories {
+	mMESH_BUFFERS = 0,		// GPU: mesh vertex buffers
+	mHEIGHTMAP_BUFFERS,		// GPU: heightmap vertex and index buffers
+	mTEXTURES,				// GPU: 2D textures in the resource manager
+	mSKYBOX,				// GPU: cubemap and cube vertices
+	mMESH_GEOMETRY,			// CPU: tinyobj attrib / shapes kept after upload
+	mHEIGHTMAP_IMAGE,		// CPU: heightmap image kept for GetFloor()
+	MEMORY_CATEGORIES
+};
+
+class Memory_Stats {
+public:
+	static void allocate(uint32_t category, uint64_t bytes);
+	static void release(uint32_t category, uint64_t bytes);
+
+	static uint64_t current(uint32_t category);
+	// Largest value current() has reached
+	static uint64_t peak(uint32_t category);
+
+	// Sums of current() over the GPU / CPU categories
+	static uint64_t gpu_bytes();
+	static uint64_t cpu_bytes();
+
+	static const char* name(uint32_t category);
+	static bool on_gpu(uint32_t category);
+
+	// One tab indented line per category: name, GPU / CPU, current and peak
+	static std::string report();
+
+private:
+	static std::atomic<uint64_t> bytes[MEMORY_CATEGORIES];
+	static std::atomic<uint64_t> peak_bytes[MEMORY_CATEGORIES];
+};
@@ -18,8 +18,7 @@
 
 #include "../include/tiny_obj_loader.h"
 #include "../include/File_IO.h"
-
-class Mesh;
+#include "../include/Resource_Manager.h"
 
 typedef struct {
 	GLuint va;
@@ -28,27 +27,11 @@ typedef struct {
 	size_t material_id;
 } DrawObject;
 
-struct loadedComponents {
-	std::map<std::string, std::pair<Mesh*, int>>* Meshes;
-	std::map<std::string, std::pair<GLuint, int>>* Textures;
-	std::map<std::string, GLuint>* Shaders;
-	loadedComponents()
-	{
-		Meshes = new std::map<std::string, std::pair<Mesh*, int>>;
-		Textures = new std::map<std::string, std::pair<GLuint, int>>;
-		Shaders = new std::map<std::string, GLuint>;
-	};
-	~loadedComponents()
-	{
-		for (auto mesh : *Meshes)
-		{
-			mesh.second.second = 0;
-			delete mesh.second.first;
-		}
-		delete Meshes;
-		delete Textures;
-		delete Shaders;
-	}
+// Texture array slots for one material, resolved once at load so draws never look textures up by name
+struct Material_Textures {
+	Texture_Slot diffuse;
+	Texture_Slot specular;
+	Texture_Slot normal;
 };
 
 void calculate_surface_normal(float Normal[3], float const vertex_1[3], float const vertex_2[3], float const vertex_3[3]);
@@ -56,29 +39,55 @@ void calculate_tangent_and_bitangent(float Tangent[3], float Bitangent[3], float
 
 class Mesh {
 public:
-	Mesh(std::string filename, loadedComponents* scene_tracker, std::string base_mat_location = "./Materials/");
+	Mesh(std::string filename, Resource_Manager* scene_tracker, std::string base_mat_location = "./Materials/");
 	~Mesh();
+	// Expects the owner to have set the "model" and "normal_matrix" uniforms
 	void draw(GLuint shader);
+	// Normalises the mesh to -1 to 1 around its center; the last step of every model matrix
+	glm::mat4 get_transform();
 	glm::vec3 get_lower_bounds();
 	glm::vec3 get_upper_bounds();
 	std::string get_scale();
 	bool loaded_successfully = true;
-	void remove_instance();
+	// Size of the vertex buffers uploaded for this mesh
+	uint64_t get_gpu_bytes();
+	// Size of the tinyobj geometry still held on the host (0 once dropped)
+	uint64_t get_cpu_bytes();
+
+	// Whether meshes loaded from now on keep their tinyobj attrib / shapes after upload (default true).
+	// Collision only uses the bounds, which are computed before the copies are dropped
+	static void keep_cpu_geometry(bool keep);
+	static bool keeps_cpu_geometry();
 
 private:
 	std::string name;
+	String_ID id;
 	glm::mat4 m_transform;
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
 
 	std::vector<tinyobj::material_t> materials;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<DrawObject> objects;
+	// One per entry in materials
+	std::vector<Material_Textures> material_textures;
+	// One reference per loadTexture() call, released when the mesh is destroyed
+	std::vector<Texture_Handle> texture_handles;
+	// While setupTextures() gathers them: the textures loadTexture() was asked for, loaded afterwards
+	std::vector<std::pair<std::string, Texture_Usage>>* gathering_textures;
+	uint64_t gpu_bytes;
+	uint64_t cpu_bytes;
 	
 	tinyobj::attrib_t attrib;
 
+	static bool keep_geometry;
+
+	void dropGeometry();
+
 	void setupMesh();
 	void setupTextures(std::string base_dir);
-	void loadTexture(std::string base_dir, std::string texture_name);
+	void loadTexture(std::string base_dir, std::string texture_name, Texture_Usage usage = TEXTURE_COLOUR);
+	void resolveTextures();
+	Texture_Slot resolveTexture(const std::string &texture_name, String_ID fallback);
 	void generateTransform();
 	void compute_bounds();
 
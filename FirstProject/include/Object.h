@@ -10,6 +10,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 
@@ -29,18 +30,32 @@
 
 // https://stackoverflow.com/questions/2659248/finding-minimum-value-in-a-map
 
+// A component owned by an object, allocated from scene_tracker->Components
+struct Object_Component {
+	String_ID name;
+	Component_Handle handle;
+	Component* component;	// Stable while the handle is live
+};
+
 // This does need to be heavily reviewed for rights
 // Everything is currently public as we give up our details constantly to pretty much everyone
 class Object {
 public:
-	Object(std::string name, std::string cmesh_details, loadedComponents* scene_tracker);
-	Object(std::string name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, loadedComponents* scene_tracker);
+	Object(std::string name, std::string cmesh_details, Resource_Manager* scene_tracker);
+	Object(std::string name, std::string object_file_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, Resource_Manager* scene_tracker);
+	// Same object file as the prototype at a new placement: components are cloned, no files are read
+	Object(const Object &prototype, std::string name, glm::quat rot, glm::vec3 loc, glm::vec3 scale);
+	Object& operator=(const Object &) = delete;
 	~Object();
 	void addComponent(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale);
 	void remComponent(std::string name);
-	void draw(GLuint shader);
+	void snapshot(std::vector<Draw_Item> &draw_list);
 
-	glm::vec3* getLocation();
+	glm::vec3 getLocation();
+	// Marks the object dirty; its components' world matrices follow on the next Transforms->update_world()
+	void setLocation(glm::vec3 location);
+	void setRotation(glm::quat rotation);
+	void setScale(glm::vec3 scale);
 
 	glm::vec3 get_lower_bounds();
 	glm::vec3 get_upper_bounds();
@@ -50,26 +65,28 @@ public:
 
 	std::string report();
 
+	std::string get_name();
+	std::string get_file_name();
+
 private:
+	void load_components(std::string object_file_name);
+	void add_component(String_ID name, Component_Handle handle);
+	Object_Component* find_component(String_ID name);
 	void build_static_transform();
 	void computer_bounds();
+	void transform_changed();
 
 	bool collision_check(glm::vec3 player_lower_bound, glm::vec3 player_upper_bound, glm::vec3 mesh_lower_bound, glm::vec3 mesh_upper_bound);
 
 	std::string m_name;
 	std::string m_file_name;
-	// List of all out components (by name so we can call them for local transforms if needed)
-	std::map<std::string, Component*>* components;
+	// All our components (by interned name so we can call them for local transforms if needed)
+	std::vector<Object_Component> components;
 	
-	glm::vec3* m_location;
-	glm::vec3* m_scale;
-	glm::quat* m_rotation;
-	glm::mat4 m_transform;
-
-	glm::vec3 m_lower_bounds;
-	glm::vec3 m_upper_bounds;
+	// Location, rotation, scale, matrix and world bounds live in scene_tracker->Transforms
+	Transform_Handle m_handle;
 	
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
 
 	
 
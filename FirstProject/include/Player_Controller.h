@@ -31,13 +31,13 @@ class Player_Controller
 public:
 	// Constructor
 	Player_Controller();
-	Player_Controller(Component* component_pointer, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, loadedComponents* scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap);
-	Player_Controller(std::string component_file_name, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, loadedComponents* scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap);
+	Player_Controller(Component* component_pointer, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, Resource_Manager* scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap);
+	Player_Controller(std::string component_file_name, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, Resource_Manager* scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap);
 
 	// Appearance
 	void set_model(Component* object_pointer);
 	void set_create_model(std::string object_file_name);
-	void draw(GLuint shader);
+	void snapshot(std::vector<Draw_Item> &draw_list);
 
 	// Motion
 		// Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
@@ -76,7 +76,8 @@ private:
 	// Appearance
 	Component* player_model;
 	glm::vec3 m_scale;
-	glm::mat4 m_transform;
+	// Location, rotation and scale are mirrored into scene_tracker->Transforms as the body's parent
+	Transform_Handle m_handle;
 	float m_height;
 
 	// Collision
@@ -97,7 +98,7 @@ private:
 	bool* mouse_buttons;
 
 	// Scene Components
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
 	std::map<std::string, Object*>* objects;
 	Heightmap* heightmap;
 };
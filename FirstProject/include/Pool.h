@@ -0,0 +1,172 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Fixed address object pool. Elements are constructed in place inside chunks of
+ * POOL_CHUNK_SIZE slots that never move, so pointers stay valid for an element's lifetime, and
+ * destroyed slots go on a free list to be reused by the next create(). Elements are addressed by a
+ * generational handle: a handle to a destroyed element never reaches whatever reuses its slot.
+ * Once the pool has grown to the working set, create / destroy make no heap allocations.
+ * Not thread safe.
+*/
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define POOL_CHUNK_SIZE 256
+#define POOL_NO_SLOT 0xFFFFFFFF
+
+template <typename T>
+struct Pool_Handle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+template <typename T>
+class Pool {
+public:
+	typedef Pool_Handle<T> Handle;
+
+	Pool() : free_head(POOL_NO_SLOT), count(0) {}
+
+	~Pool()
+	{
+		clear();
+		for (Slot* chunk : chunks)
+		{
+			delete[] chunk;
+		}
+	}
+
+	// Handle that never refers to an element (generations start at 1)
+	static Handle null_handle()
+	{
+		Handle handle = { POOL_NO_SLOT, 0 };
+		return handle;
+	}
+
+	template <typename... Args>
+	Handle create(Args&&... args)
+	{
+		if (free_head == POOL_NO_SLOT)
+			grow();
+
+		uint32_t index = free_head;
+		Slot &slot = at(index);
+		new (&slot.storage) T(std::forward<Args>(args)...);
+
+		free_head = slot.next_free;
+		slot.next_free = POOL_NO_SLOT;
+		slot.generation++;
+		slot.alive = true;
+		count++;
+
+		Handle handle = { index, slot.generation };
+		return handle;
+	}
+
+	void destroy(Handle handle)
+	{
+		if (!valid(handle))
+			return;
+
+		Slot &slot = at(handle.index);
+		// Dead before the destructor runs, so anything it triggers sees the handle as stale
+		slot.alive = false;
+		element(slot)->~T();
+		slot.next_free = free_head;
+		free_head = handle.index;
+		count--;
+	}
+
+	// nullptr for a stale or null handle
+	T* get(Handle handle)
+	{
+		return valid(handle) ? element(at(handle.index)) : nullptr;
+	}
+
+	bool valid(Handle handle)
+	{
+		return handle.index < chunks.size() * POOL_CHUNK_SIZE && at(handle.index).alive && at(handle.index).generation == handle.generation;
+	}
+
+	// Handle of a live element from its address, or null_handle()
+	Handle handle_of(const T* pointer)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		for (uint32_t chunk = 0; chunk < chunks.size(); ++chunk)
+		{
+			uintptr_t begin = reinterpret_cast<uintptr_t>(chunks[chunk]);
+			if (address < begin || address >= begin + POOL_CHUNK_SIZE * sizeof(Slot))
+				continue;
+
+			uint32_t index = chunk * POOL_CHUNK_SIZE + static_cast<uint32_t>((address - begin) / sizeof(Slot));
+			Slot &slot = at(index);
+			if (!slot.alive || element(slot) != pointer)
+				break;
+
+			Handle handle = { index, slot.generation };
+			return handle;
+		}
+		return null_handle();
+	}
+
+	// Make room for this many live elements so the next creates don't allocate
+	void reserve(uint32_t elements)
+	{
+		while (chunks.size() * POOL_CHUNK_SIZE < elements)
+			grow();
+	}
+
+	// Destroy every live element; chunks are kept
+	void clear()
+	{
+		for (uint32_t index = 0; index < chunks.size() * POOL_CHUNK_SIZE; ++index)
+		{
+			Slot &slot = at(index);
+			if (!slot.alive)
+				continue;
+
+			Handle handle = { index, slot.generation };
+			destroy(handle);
+		}
+	}
+
+	uint32_t size() { return count; }
+	uint32_t capacity() { return static_cast<uint32_t>(chunks.size()) * POOL_CHUNK_SIZE; }
+
+private:
+	Pool(const Pool &) = delete;
+	Pool& operator=(const Pool &) = delete;
+
+	struct Slot {
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		uint32_t generation;
+		uint32_t next_free;
+		bool alive;
+	};
+
+	Slot& at(uint32_t index) { return chunks[index / POOL_CHUNK_SIZE][index % POOL_CHUNK_SIZE]; }
+	T* element(Slot &slot) { return reinterpret_cast<T*>(&slot.storage); }
+
+	// New chunk's slots are pushed so the lowest index is handed out first
+	void grow()
+	{
+		uint32_t base = static_cast<uint32_t>(chunks.size()) * POOL_CHUNK_SIZE;
+		Slot* chunk = new Slot[POOL_CHUNK_SIZE];
+		chunks.push_back(chunk);
+
+		for (uint32_t offset = POOL_CHUNK_SIZE; offset-- > 0;)
+		{
+			chunk[offset].generation = 0;
+			chunk[offset].alive = false;
+			chunk[offset].next_free = free_head;
+			free_head = base + offset;
+		}
+	}
+
+	std::vector<Slot*> chunks;
+	uint32_t free_head;
+	uint32_t count;
+};
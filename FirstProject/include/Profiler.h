@@ -0,0 +1,79 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Lightweight scoped CPU profiler. Scopes record begin and end timestamps
+ * into a per-thread ring buffer which can be summarised per frame or written out as
+ * Chrome trace_event JSON (load in chrome://tracing or https://ui.perfetto.dev).
+ * Only compiled in when ENABLE_PROFILER is defined (make PROFILE=1), otherwise the
+ * PROFILE_* macros expand to nothing.
+*/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Events kept per thread before the oldest are overwritten
+#define PROFILER_RING_SIZE 65536
+
+#ifdef ENABLE_PROFILER
+	#define PROFILE_CONCAT_INNER(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+	// Name must be a string literal (or otherwise outlive the profiler)
+	#define PROFILE_SCOPE(name) Profile_Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+	#define PROFILE_FRAME() Profiler::new_frame()
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_FRAME() ((void)0)
+#endif
+
+struct Profile_Event {
+	const char* name;
+	uint64_t begin;		// Nanoseconds since profiler start
+	uint64_t end;
+	uint32_t frame;
+	uint32_t depth;		// Nesting level within the thread
+	bool gpu;			// Timed on the GPU (see GPU_Profiler)
+};
+
+class Profiler {
+public:
+	// True when the profiler has been compiled in
+	static bool enabled();
+
+	// Mark the start of a new frame. Events are tagged with the frame they are recorded in
+	static void new_frame();
+	static uint32_t current_frame();
+
+	// Nanoseconds since the profiler was first used
+	static uint64_t now();
+
+	// Record a completed scope for the calling thread
+	static void record(const char* name, uint64_t begin, uint64_t end, uint32_t depth);
+
+	// Record a GPU pass once its timer query has resolved. `begin` is the CPU submit time
+	static void record_gpu(const char* name, uint64_t begin, uint64_t duration, uint32_t frame);
+
+	// Average time per scope over the last `frames` complete frames
+	static std::string summary(uint32_t frames);
+
+	// Every scope recorded during the given frame, ordered by start time
+	static std::vector<Profile_Event> frame_events(uint32_t frame);
+
+	// Write every event still in the ring buffers as Chrome trace_event JSON
+	static bool write_chrome_trace(std::string file_name);
+
+	// Scope nesting for the calling thread
+	static uint32_t push_scope();
+	static void pop_scope();
+};
+
+class Profile_Scope {
+public:
+	explicit Profile_Scope(const char* name);
+	~Profile_Scope();
+private:
+	const char* m_name;
+	uint64_t m_begin;
+	uint32_t m_depth;
+};
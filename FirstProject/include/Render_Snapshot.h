@@ -0,0 +1,66 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Everything a frame needs to be drawn, copied out of the scene once simulation has
+ * finished with it: camera, lights, and one entry per component with its model and normal matrices.
+ * Scene::snapshot() fills one and Scene::draw() submits it, so the renderer never reads live scene
+ * state and simulation of the next frame can run while this one is drawn (see Frame_Pipeline).
+ * Meshes are referenced, not copied; they stay alive because removed objects are only collected
+ * by Scene::end_frame() after the frame that could still draw them.
+ * clear() keeps the vectors' capacity, so refilling a snapshot each frame does not allocate.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include "../include/Light.h"
+
+class Mesh;
+
+struct Draw_Item {
+	Mesh* mesh;
+	glm::mat4 model;
+	glm::mat3 normal;
+};
+
+// Uniform values of one light at the time of the snapshot
+struct Light_State {
+	light_types type;
+	glm::vec3 position;
+	glm::vec3 direction;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	GLfloat cut_off;
+	GLfloat outer_cut_off;
+	GLfloat constant;
+	GLfloat linear;
+	GLfloat quadratic;
+};
+
+struct Render_Snapshot {
+	uint64_t frame;
+	// When the input this frame shows was applied, and how long its simulation step took
+	std::chrono::steady_clock::time_point input_time;
+	double simulation_ms;
+
+	glm::vec3 view_position;
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	std::vector<Light_State> lights;
+	std::vector<Draw_Item> statics;
+	std::vector<Draw_Item> player;
+
+	Render_Snapshot() : frame(0), simulation_ms(0), view(1.0f), projection(1.0f) {}
+
+	void clear()
+	{
+		lights.clear();
+		statics.clear();
+		player.clear();
+	}
+};
@@ -0,0 +1,34 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Per frame draw call counters. Every glDraw* in the engine reports here so the
+ * benchmark (and anything else) can see how much work a frame submitted, as do material texture binds.
+ * Counters are plain integers; only the GL thread draws.
+*/
+
+#include <cstdint>
+
+class Render_Stats {
+public:
+	// Call once per glDraw*, with the number of vertices (or indices) it submits
+	static void draw(uint64_t vertices);
+	// Call once per glBindTexture of a material texture
+	static void texture_bind();
+
+	// Zero the per frame counters (totals keep accumulating)
+	static void new_frame();
+
+	static uint64_t frame_draw_calls();
+	static uint64_t frame_vertices();
+	static uint64_t frame_texture_binds();
+	static uint64_t total_draw_calls();
+	static uint64_t total_vertices();
+	static uint64_t total_texture_binds();
+
+private:
+	static uint64_t draw_calls;
+	static uint64_t vertices;
+	static uint64_t texture_binds;
+	static uint64_t all_draw_calls;
+	static uint64_t all_vertices;
+	static uint64_t all_texture_binds;
+};
@@ -0,0 +1,521 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Reference counted ownership of everything a scene loads once and shares: meshes,
+ * textures and shader programs. Each kind lives in its own Resource_Pool, addressed by a typed
+ * generational handle (a stale handle can never reach a recycled slot) and found by interned name.
+ * Holders acquire / release with an atomic count and their own name, so the report can say who
+ * keeps a resource resident. A resource whose count reaches zero is queued, and destroyed for real
+ * (delete / glDelete*) by collect() at the end of the frame, unless something re-acquires it first.
+ * A pool given a memory category reports its resident bytes to Memory_Stats as entries come and go.
+ * An entry may answer to more names than the one it was added under (alias); textures loaded from
+ * files with identical bytes share one GL texture that way.
+ * A pool told to keep_unreferenced() holds on to such resources instead (idle, so a later find picks
+ * them up without a reload) until evict_unreferenced() destroys the longest idle. The texture pool
+ * does, and the manager evicts its idle textures when texture VRAM goes over budget.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "../include/String_ID.h"
+#include "../include/Flat_Map.h"
+#include "../include/Transform_Store.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Pool.h"
+#include "../include/Texture_Arrays.h"
+
+class Mesh;
+class Object;
+class Component;
+
+typedef Pool_Handle<Object> Object_Handle;
+typedef Pool_Handle<Component> Component_Handle;
+
+template <typename T>
+struct Resource_Handle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// GL objects get their own types so texture and program handles can't be mixed up. Material textures
+// are a slot in the texture arrays; anything else (the heightmap image) is a plain GL texture
+struct Texture_Resource {
+	GLuint id;
+	Texture_Slot slot;
+	Texture_Info info;
+};
+
+struct Program_Resource {
+	GLuint id;
+};
+
+typedef Resource_Handle<Mesh*> Mesh_Handle;
+typedef Resource_Handle<Texture_Resource> Texture_Handle;
+typedef Resource_Handle<Program_Resource> Program_Handle;
+
+// "1.50 MB" style sizes for reports
+std::string format_bytes(uint64_t bytes);
+
+template <typename T>
+class Resource_Pool {
+public:
+	typedef Resource_Handle<T> Handle;
+	typedef void (*Destroy_Function)(T &resource);
+
+	// memory_category is a memory_categories value, or MEMORY_CATEGORIES when the owner accounts for itself
+	Resource_Pool(std::string category, Destroy_Function destroy_function, uint32_t memory_category = MEMORY_CATEGORIES)
+	{
+		this->category = category;
+		this->destroy_function = destroy_function;
+		this->memory_category = memory_category;
+		this->keep = false;
+		this->idle_sequence = 0;
+	}
+
+	~Resource_Pool()
+	{
+		destroy_all();
+	}
+
+	// Handle that never refers to a resource (generations start at 1)
+	static Handle null_handle()
+	{
+		Handle handle = { 0, 0 };
+		return handle;
+	}
+
+	// Resident resource with this name (including one queued for destruction), or null_handle(). Takes no reference
+	Handle find(String_ID name)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		uint32_t* index = names.find(name);
+		if (!index)
+			return null_handle();
+
+		Handle handle = { *index, entries[*index].generation };
+		return handle;
+	}
+
+	// Take ownership of a freshly loaded resource. The holder gets the first reference
+	Handle add(String_ID name, T resource, uint64_t bytes, String_ID holder)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		uint32_t index;
+		if (!free_slots.empty())
+		{
+			index = free_slots.back();
+			free_slots.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(entries.size());
+			entries.emplace_back();
+			entries[index].generation = 0;
+		}
+
+		Entry &entry = entries[index];
+		entry.resource = resource;
+		entry.name = name;
+		entry.bytes = bytes;
+		entry.generation++;
+		entry.alive = true;
+		entry.queued = false;
+		entry.idle = false;
+		entry.references.store(1);
+		entry.holders.clear();
+		entry.holders.push_back(std::make_pair(holder, 1));
+		entry.aliases.clear();
+		Memory_Stats::allocate(memory_category, bytes);
+
+		// A re-added name replaces any resident resource of the same name; that one lives on until released
+		names[name] = index;
+
+		Handle handle = { index, entry.generation };
+		return handle;
+	}
+
+	// name finds the resource as well from now on, until it is destroyed. False for a stale handle
+	bool alias(String_ID name, Handle handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!is_valid(handle))
+			return false;
+
+		names[name] = handle.index;
+		entries[handle.index].aliases.push_back(name);
+		return true;
+	}
+
+	bool acquire(Handle handle, String_ID holder)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!is_valid(handle))
+			return false;
+
+		Entry &entry = entries[handle.index];
+		entry.references.fetch_add(1);
+		entry.idle = false;
+		for (auto &held : entry.holders)
+		{
+			if (held.first == holder)
+			{
+				held.second++;
+				return true;
+			}
+		}
+		entry.holders.push_back(std::make_pair(holder, 1));
+		return true;
+	}
+
+	void release(Handle handle, String_ID holder)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!is_valid(handle))
+			return;
+
+		Entry &entry = entries[handle.index];
+		for (size_t idx = 0; idx < entry.holders.size(); ++idx)
+		{
+			if (entry.holders[idx].first == holder && --entry.holders[idx].second == 0)
+			{
+				entry.holders.erase(entry.holders.begin() + idx);
+				break;
+			}
+		}
+
+		if (entry.references.fetch_sub(1) == 1 && !entry.queued)
+		{
+			entry.queued = true;
+			pending.push_back(handle.index);
+		}
+	}
+
+	bool valid(Handle handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return is_valid(handle);
+	}
+
+	// The resource itself, or a value initialised T for a stale handle
+	T get(Handle handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return is_valid(handle) ? entries[handle.index].resource : T();
+	}
+
+	int32_t references(Handle handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return is_valid(handle) ? entries[handle.index].references.load() : 0;
+	}
+
+	// Resources whose count reaches zero stay resident (idle) until evicted, instead of going at collect()
+	void keep_unreferenced(bool keep)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		this->keep = keep;
+	}
+
+	// Destroy everything released since the last collect that nobody picked back up (or mark it idle,
+	// when keeping unreferenced resources). Returns the count destroyed
+	uint32_t collect()
+	{
+		std::vector<T> doomed;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			for (uint32_t index : pending)
+			{
+				Entry &entry = entries[index];
+				entry.queued = false;
+				if (!entry.alive || entry.references.load() > 0)
+					continue;
+
+				if (keep)
+				{
+					entry.idle = true;
+					entry.idle_since = ++idle_sequence;
+					idle.push_back(std::make_pair(index, entry.idle_since));
+					continue;
+				}
+				doomed.push_back(entry.resource);
+				retire(index);
+			}
+			pending.clear();
+		}
+
+		// Outside the lock: destroying a mesh releases its textures, which may be in another pool
+		for (T &resource : doomed)
+		{
+			destroy_function(resource);
+		}
+		return static_cast<uint32_t>(doomed.size());
+	}
+
+	// Destroy up to count idle resources, longest idle first. Returns the count destroyed
+	uint32_t evict_unreferenced(uint32_t count)
+	{
+		std::vector<T> doomed;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			while (doomed.size() < count && !idle.empty())
+			{
+				std::pair<uint32_t, uint64_t> oldest = idle.front();
+				idle.pop_front();
+
+				// Picked up (and maybe released again, further back in the queue) since it went idle
+				Entry &entry = entries[oldest.first];
+				if (!entry.alive || !entry.idle || entry.idle_since != oldest.second)
+					continue;
+
+				doomed.push_back(entry.resource);
+				retire(oldest.first);
+			}
+		}
+
+		for (T &resource : doomed)
+		{
+			destroy_function(resource);
+		}
+		return static_cast<uint32_t>(doomed.size());
+	}
+
+	uint32_t unreferenced()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		uint32_t count = 0;
+		for (auto &entry : entries)
+			count += entry.alive && entry.idle;
+		return count;
+	}
+
+	uint64_t unreferenced_bytes()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		uint64_t total = 0;
+		for (auto &entry : entries)
+		{
+			if (entry.alive && entry.idle)
+				total += entry.bytes;
+		}
+		return total;
+	}
+
+	// Destroy every resident resource, referenced or not (scene teardown)
+	void destroy_all()
+	{
+		std::vector<T> doomed;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			for (uint32_t index = 0; index < entries.size(); ++index)
+			{
+				if (!entries[index].alive)
+					continue;
+
+				doomed.push_back(entries[index].resource);
+				retire(index);
+			}
+			pending.clear();
+			idle.clear();
+		}
+
+		for (T &resource : doomed)
+		{
+			destroy_function(resource);
+		}
+	}
+
+	uint32_t size()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		// Not names.size(): aliases would count twice
+		return static_cast<uint32_t>(entries.size() - free_slots.size());
+	}
+
+	uint64_t resident_bytes()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		uint64_t total = 0;
+		for (auto &entry : entries)
+		{
+			if (entry.alive)
+				total += entry.bytes;
+		}
+		return total;
+	}
+
+	// function(name, resource, bytes) for every resident resource, under the pool's lock
+	template <typename Function>
+	void for_each(Function function)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (auto &entry : entries)
+		{
+			if (entry.alive)
+				function(entry.name, entry.resource, entry.bytes);
+		}
+	}
+
+	// One line per resident resource: name, references, size and holders
+	std::string report()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		std::ostringstream out;
+		uint64_t total = 0;
+		uint32_t resident = 0;
+
+		for (auto &entry : entries)
+		{
+			if (!entry.alive)
+				continue;
+			total += entry.bytes;
+			resident++;
+		}
+		out << category << ": " << resident << " resident, " << format_bytes(total) << "\n";
+
+		for (auto &entry : entries)
+		{
+			if (!entry.alive)
+				continue;
+
+			out << "\t" << String_Table::lookup(entry.name) << "\trefs " << entry.references.load() << "\t" << format_bytes(entry.bytes);
+			if (entry.queued)
+				out << "\t(releasing)";
+			if (entry.idle)
+				out << "\t(idle)";
+			for (String_ID alias : entry.aliases)
+				out << "\talso " << String_Table::lookup(alias);
+			out << "\theld by";
+			for (auto &held : entry.holders)
+			{
+				out << " " << String_Table::lookup(held.first);
+				if (held.second > 1)
+					out << " x" << held.second;
+			}
+			out << "\n";
+		}
+
+		return out.str();
+	}
+
+private:
+	struct Entry {
+		T resource;
+		String_ID name;
+		uint64_t bytes;
+		uint32_t generation;
+		bool alive;
+		bool queued;
+		// Unreferenced but kept; idle_since orders it in the idle queue
+		bool idle;
+		uint64_t idle_since;
+		std::atomic<int32_t> references;
+		std::vector<std::pair<String_ID, int32_t>> holders;
+		std::vector<String_ID> aliases;
+
+		Entry() : resource(), name(0), bytes(0), generation(0), alive(false), queued(false), idle(false), idle_since(0), references(0) {}
+	};
+
+	bool is_valid(Handle handle)
+	{
+		return handle.index < entries.size() && entries[handle.index].alive && entries[handle.index].generation == handle.generation;
+	}
+
+	void retire(uint32_t index)
+	{
+		Entry &entry = entries[index];
+		uint32_t* named = names.find(entry.name);
+		if (named && *named == index)
+			names.erase(entry.name);
+		for (String_ID alias : entry.aliases)
+		{
+			named = names.find(alias);
+			if (named && *named == index)
+				names.erase(alias);
+		}
+
+		Memory_Stats::release(memory_category, entry.bytes);
+		entry.alive = false;
+		entry.idle = false;
+		entry.resource = T();
+		entry.holders.clear();
+		entry.aliases.clear();
+		free_slots.push_back(index);
+	}
+
+	// Deque so entries (and their atomics) never move
+	std::deque<Entry> entries;
+	std::vector<uint32_t> free_slots;
+	std::vector<uint32_t> pending;
+	// (index, idle_since) of entries as they went idle, oldest first; stale pairs are skipped
+	std::deque<std::pair<uint32_t, uint64_t>> idle;
+	Flat_Map<uint32_t> names;
+	std::mutex lock;
+
+	std::string category;
+	Destroy_Function destroy_function;
+	uint32_t memory_category;
+	bool keep;
+	uint64_t idle_sequence;
+};
+
+// Material texture VRAM the manager aims to stay under (see set_texture_budget)
+#define TEXTURE_VRAM_BUDGET (256ull * 1024 * 1024)
+// Frames a texture array goes unbound before its larger levels may be dropped
+#define TEXTURE_IDLE_FRAMES 300
+
+// Everything a scene shares between its objects (formerly the loadedComponents maps)
+class Resource_Manager {
+public:
+	Resource_Manager();
+	~Resource_Manager();
+
+	// Call once per frame, after the last draw: destroys resources released during the frame
+	void collect();
+
+	// What is resident, how large it is and who holds it, followed by the Memory_Stats totals
+	std::string report();
+	// Texture VRAM against the same textures uncompressed, and the block compression error
+	std::string texture_report();
+
+	// If a texture was already loaded from a file with these contents (file_content_hash, seeded with
+	// the usage), name becomes another name for it and holder acquires it. Otherwise null_handle().
+	// GL thread only, like texture loading
+	Texture_Handle share_texture(String_ID name, uint64_t contents, String_ID holder);
+	// Remembers texture as the one loaded from contents, for later share_texture calls
+	void add_texture_contents(uint64_t contents, Texture_Handle texture);
+	// Textures found to be copies of another and the GPU bytes not uploaded for them
+	std::string texture_sharing_report();
+
+	// Texture VRAM to stay under, for every scene. Over it, collect() evicts textures no object holds
+	// (longest unused first), then drops the larger levels of textures not drawn lately
+	static void set_texture_budget(uint64_t bytes);
+	static uint64_t texture_budget();
+	uint32_t texture_evictions();
+	// Resident, idle and evicted textures against the budget
+	std::string texture_residency_report();
+
+	Resource_Pool<Mesh*> Meshes;
+	Resource_Pool<Texture_Resource> Textures;
+	Resource_Pool<Program_Resource> Programs;
+	Transform_Store* Transforms;
+	// Storage for scene objects and their components; painting and undo reuse slots instead of new / delete
+	Pool<Object>* Objects;
+	Pool<Component>* Components;
+
+private:
+	std::unordered_map<uint64_t, Texture_Handle> texture_contents;
+	uint32_t shared_textures;
+	uint64_t shared_texture_bytes;
+	uint32_t evicted_textures;
+};
@@ -0,0 +1,76 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Procedural scatter brush. Fills a circle or polygon on the heightmap with up to N
+ * copies of one object, spaced by Poisson-disc sampling so no two are closer than the minimum
+ * distance. Points on a barrier (blue channel of the heightmap image) are rejected, survivors are
+ * snapped to Heightmap::GetFloor and given a random yaw and scale.
+ *
+ * Sampling runs Bridson's algorithm (with candidates on a ring rather than random) per tile. Tiles
+ * are at least the minimum distance wide and are processed in four phases (by tile x / z parity), so
+ * tiles sharing a phase never touch and run on separate jobs against one shared acceleration grid.
+ * Every tile has its own seeded generator, so the same seed gives the same placements whatever the
+ * thread count (recordings replay exactly).
+ * The result goes to Scene::attachObjects as one batch.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../include/Heightmap.h"
+#include "../include/Scene.h"
+
+// Candidates tried around each active point before it is retired (Bridson's k), and the radius
+// they are tried at as a multiple of the minimum distance
+#define SCATTER_CANDIDATES 12
+#define SCATTER_RING 1.0001f
+// Fresh random seeds tried per tile, so areas cut off by barriers still get filled
+#define SCATTER_TILE_SEEDS 8
+// With no distance given it is picked so the area fits count * 0.7 / SCATTER_PACKING points (a
+// filled set holds about 0.7 / distance^2 per unit area); the spare points are dropped at random
+#define SCATTER_PACKING 0.6f
+
+struct Scatter_Settings {
+	uint32_t count;			// Instances wanted; fewer are placed if the area fills up first
+	GLfloat min_distance;	// Closest two instances may be; 0 derives it from count and area
+	GLfloat min_scale;		// Uniform scale picked in [min_scale, max_scale]
+	GLfloat max_scale;
+	GLfloat y_offset;		// Added to the floor height
+	uint32_t seed;
+};
+
+// Circle (centre / radius) when polygon is empty, otherwise the polygon (x / z corners, either winding)
+struct Scatter_Region {
+	glm::vec2 centre;
+	GLfloat radius;
+	std::vector<glm::vec2> polygon;
+};
+
+class Scatter_Brush {
+public:
+	// heightmap may be nullptr: no snapping (y is y_offset) and no barrier mask
+	Scatter_Brush(Heightmap* heightmap);
+
+	// Placements named name_prefix + "_" + number, numbered from first_number. Does not touch a scene
+	std::vector<Object_Placement> sample(const Scatter_Region &region, const Scatter_Settings &settings, const std::string &name_prefix, uint32_t first_number = 0);
+
+	// sample() followed by one Scene::attachObjects. Returns the number placed
+	uint32_t scatter(Scene* scene, std::string file_name, const Scatter_Region &region, const Scatter_Settings &settings,
+		const std::string &name_prefix, uint32_t first_number = 0, std::vector<Object_Handle>* handles = nullptr);
+
+	// Timings of the last call, in milliseconds
+	double last_sample_ms();
+	double last_attach_ms();
+
+private:
+	bool inside(const Scatter_Region &region, glm::vec2 point);
+	bool blocked(glm::vec2 point);
+
+	Heightmap* heightmap;
+	double sample_ms;
+	double attach_ms;
+};
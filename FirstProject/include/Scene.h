@@ -28,11 +28,22 @@
 #include "../include/Mesh.h"
 #include "../include/Heightmap.h"
 #include "../include/Player_Controller.h"
+#include "../include/Render_Snapshot.h"
 
 //TODO going to add height and width values for window. This is a poor choice! 
 // Intend to fix in long run
 const GLuint s_WIDTH = 1024, s_HEIGHT = 768;
 
+// Where attachObjects() puts one copy of an object
+struct Object_Placement {
+	std::string name;
+	glm::quat rotation;
+	glm::vec3 location;
+	glm::vec3 scale;
+};
+
+class Skybox;
+
 class Scene {
 
 public:
@@ -51,14 +62,34 @@ public:
 	void attachObject(std::string object_scene_name, std::string object_details);
 	void removeObject(std::string object_scene_name);
 
+	// Bulk painting: many copies of one object file in one call. Components are cloned from an object
+	// already using the file (it is only read when none is) and pool space is reserved up front.
+	// Handles of the new objects are appended to handles when given; names already in use are skipped
+	void attachObjects(std::string file_name, const std::vector<Object_Placement> &placements, std::vector<Object_Handle>* handles = nullptr);
+	void removeObject(Object_Handle object);
+	void removeObjects(const std::vector<Object_Handle> &objects);
+
 	void attachShader(std::string shader_scene_name, std::string vertex_file, std::string fragment_file);
 
-	void draw();
-	void rendSky();
+	// Simulation side: rebuild world matrices and copy camera, lights and draw list into snapshot
+	void snapshot(Render_Snapshot &snapshot);
+	// Render side: submit a snapshot, the sky last. Reads no live object, light or camera state
+	void draw(const Render_Snapshot &snapshot);
 	
 	void tick(GLfloat delta); // Update All Actors
 
+	// After the frame is submitted: frees meshes, textures and programs released during it
+	void end_frame();
+	// Resident meshes, textures and programs with their sizes and holders, then bytes per memory category
+	std::string resource_report();
+	// Textures loaded once for several names because their files were identical
+	std::string texture_sharing_report();
+	// Texture VRAM against the budget, and how many textures have been evicted to stay under it
+	std::string texture_residency_report();
+
 	void setActiveShader(std::string);
+	// Per frame callers should pass SID("Name") so no string is built or hashed at runtime
+	void setActiveShader(String_ID);
 	
 	Light* getLight(std::string);
 
@@ -78,6 +109,8 @@ public:
 
 	bool hasObject(std::string);
 	Object* getObject(std::string);
+	// nullptr once the object has been removed
+	Object* getObject(Object_Handle);
 
 	void attachPlayer(Component* object_pointer, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
 	void attachPlayer(std::string component_file_name, bool* keyboard_input, bool* mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
@@ -86,22 +119,31 @@ public:
 	bool hasPlayer();
 	Player_Controller* getPlayer();
 
-	// TODO
-	// void setSkybox(void); // Pass texture?
+	// Six cube map faces, or one cooked DDS cube map (see Skybox). A new sky shows once it has loaded
+	void setSkybox(std::vector<std::string>);
+	Skybox* getSkybox();
+
+	// Scene file text (see docs/SceneDefinition.txt), ending with the current Memory_Stats
 	std::string report();
 
 	void save_level(std::string);
 
 private:
 	void update_projection();
+	void draw_items(const std::vector<Draw_Item> &draw_list);
+	Object_Handle createObject(std::string object_scene_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, std::string file_name);
 
 	std::string scene_name;
 	std::map<std::string, Object*>* objects;
+	// Per object file: a live object to clone painted copies from
+	std::map<std::string, Object_Handle> prototypes;
 	std::map<std::string, Light*>* lights;
 	std::map<std::string, Camera*>* cameras;
 
 	Heightmap* heightmap;
 	Player_Controller* player;
+	std::vector<std::string> skybox_files;
+	Skybox* skybox;
 
 	glm::mat4 m_transform;
 
@@ -115,7 +157,11 @@ private:
 	GLuint view_mode;
 
 
-	loadedComponents* scene_tracker;
+	Resource_Manager* scene_tracker;
+	// Programs attached by name, with the GL name cached for setActiveShader
+	Flat_Map<std::pair<Program_Handle, GLuint>> programs;
+	// The "Skybox" program's GL name, kept up to date by attachShader
+	GLuint sky_program;
 	
 	ShaderLoader* shader_loader;
 
@@ -123,7 +169,6 @@ private:
 	// std::vector< Actor*>* scene_tick_list;
 	
 	// TODO: Create the following
-	// SkyBox
 	// Ambient Lighting
 	// Lights Vector
 	// std::vector<Actor> Actors;
@@ -26,11 +26,11 @@ private:
 	Scene * scene;
 	ShaderLoader * scene_shader_loader;
 
-	bool BuildActors(std::ifstream* fb, std::string* LineBuf);
-	bool BuildAnimations(std::ifstream* fb, std::string* LineBuf);
-	bool BuildCamera(std::ifstream* fb, std::string* LineBuf);
-	bool BuildLights(std::ifstream* fb, std::string* LineBuf);
-	bool BuildSceneName(std::ifstream* fb, std::string* LineBuf);
-	bool BuildSkybox(std::ifstream* fb, std::string* LineBuf);
-	bool BuildStatics(std::ifstream* fb, std::string* LineBuf);
+	bool BuildActors(std::istream* fb, std::string* LineBuf);
+	bool BuildAnimations(std::istream* fb, std::string* LineBuf);
+	bool BuildCamera(std::istream* fb, std::string* LineBuf);
+	bool BuildLights(std::istream* fb, std::string* LineBuf);
+	bool BuildSceneName(std::istream* fb, std::string* LineBuf);
+	bool BuildSkybox(std::istream* fb, std::string* LineBuf);
+	bool BuildStatics(std::istream* fb, std::string* LineBuf);
 };
@@ -2,18 +2,84 @@
 /* Author: Ben Weatherall (a1617712)
  * Description: Class to report how long the last frame took to build. Use to optimise scene and engine
  * Based upon (Measure speed (http://www.opengl-tutorial.org/miscellaneous/an-fps-counter/))
+ * Also collects frame time statistics: every frame goes into an HDR style (log-linear) histogram
+ * for percentiles, and frames over budget are logged with the profiler scopes active at the time.
 */
 #include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <GLFW/glfw3.h>
 
+// Default hitch threshold (two frames at 60Hz)
+#define DEFAULT_FRAME_BUDGET_MS 33.3
+
+// Histogram resolution: values below 2^FRAME_HISTOGRAM_SUB_BITS microseconds are exact, above that
+// each power of two is split into 2^(FRAME_HISTOGRAM_SUB_BITS - 1) linear buckets (~3% error)
+#define FRAME_HISTOGRAM_SUB_BITS 6
+#define FRAME_HISTOGRAM_MAX_BITS 32
+
+class Frame_Histogram {
+public:
+	Frame_Histogram();
+
+	void add(double milliseconds);
+	void clear();
+
+	uint64_t count();
+	double max();
+	double mean();
+	// p in [0, 1]. Returns the upper edge of the bucket holding that percentile
+	double percentile(double p);
+
+	uint32_t bucket_count();
+	uint64_t bucket_value(uint32_t bucket);
+	// Bucket edges in milliseconds
+	double bucket_lower(uint32_t bucket);
+	double bucket_upper(uint32_t bucket);
+
+private:
+	uint32_t bucket_index(uint64_t microseconds);
+
+	std::vector<uint64_t> buckets;
+	uint64_t total;
+	double sum;
+	double largest;
+};
+
 class SPF_Counter {
 public:
-	SPF_Counter(bool report);
+	SPF_Counter(bool report, double budget_ms = DEFAULT_FRAME_BUDGET_MS);
 	void tick();
 	double delta();
+
+	// Add a frame measured elsewhere (e.g. with a fixed or offscreen clock)
+	void record(double frame_seconds);
+
+	void set_budget(double budget_ms);
+	double get_budget();
+	// Hitches are always counted; this only controls printing each one
+	void set_hitch_logging(bool enabled);
+	uint64_t hitches();
+
+	Frame_Histogram* histogram();
+
+	// p50/p95/p99/max summary of every frame recorded so far
+	std::string report();
+	// One row per non-empty histogram bucket: lower_ms,upper_ms,count,cumulative_percent
+	bool export_csv(std::string file_name);
+
 private:
+	void log_hitch(double frame_ms);
+
 	double currentTime;
 	double lastTime;
+	double lastTick;
 	int nbFrames;
-	bool report;
+	bool report_fps;
+
+	double budget;
+	uint64_t hitch_count;
+	bool log_hitches;
+	Frame_Histogram frame_times;
 };
@@ -50,6 +50,6 @@ private:
 	bool is_shader_built(std::string);
 	bool is_program_built(std::pair<std::string, std::string>);
 
-	GLuint build_shader(GLchar** SourceCode, GLuint type);
+	GLuint build_shader(const GLchar* SourceCode, GLint length, GLuint type);
 	void build_shader_program(std::pair<std::string, std::string> shaders);
 };
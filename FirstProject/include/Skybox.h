@@ -1,6 +1,7 @@
 #ifndef SKYBOX_H
 #define SKYBOX_H
 
+#include <string>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -8,15 +9,57 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "../include/Image_Decoder.h"
+#include "../include/Texture_Cache.h"
+#include "../include/VFS.h"
+
+// One triangle covering the screen
+#define SKYBOX_VERTICES 3
+// The sky of a scene with no Skybox: section (+X, -X, +Y, -Y, +Z, -Z)
+#define SKYBOX_DEFAULT_FACES { "./Materials/posx.tga", "./Materials/negx.tga", "./Materials/posy.png", \
+	"./Materials/negy.tga", "./Materials/posz.tga", "./Materials/negz.tga" }
+
+// The cube map is cooked into the texture cache (one DDS holding every face's compressed mip chain,
+// see Texture_Cache::cook_cube) on the job system when its cache is stale, so constructing a Skybox
+// never waits on it. Once the cooked file is ready draw() uploads it one level (of all six faces) a
+// frame, smallest first, and the sky sharpens as they arrive. Until then nothing is drawn.
+//
+// The sky is a single triangle covering the screen at the far plane; the skybox shader turns each
+// pixel back into a view direction to sample the cube map with. Scene draws it after everything else
 class Skybox {
 public:
 
-	Skybox();
-	GLuint loadCubeTex(std::vector<const GLchar*> faces);
+	// Six face images, or one cooked DDS cube map (see Texture_Cache::open_cached_cube)
+	Skybox(const std::vector<std::string> &faces);
+	~Skybox();
 	GLuint CreateVao();
 
+	// Draw behind everything already in the depth buffer with the skybox program
+	void draw(GLuint program, const glm::mat4 &view, const glm::mat4 &projection);
+	// Waits for the cook and uploads every level before returning (benchmarks)
+	void flush();
+	// True once every level of the cube map is on the GPU
+	bool loaded();
+
 	GLuint skyVaoId;
+	// 0 until the cube map is ready
 	GLuint skyTexId;
+
+private:
+	// Opens the cooked cube map once the cook has finished (waiting for it if block) and uploads its next level
+	void stream(bool block);
+
+	std::vector<std::string> m_faces;
+	Image_Future m_cooking;
+	File_View m_file;
+	Texture_Cube m_cube;
+	// Levels still to upload; the next is m_levels_left - 1
+	uint32_t m_levels_left;
+	uint64_t m_gpu_bytes;
+	bool m_failed;
+	// The program the uniform location was looked up in
+	GLuint m_program;
+	GLint m_sky_matrix;
 };
 
 #endif
@@ -0,0 +1,37 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Interned string IDs. Names (shaders, textures, meshes) are hashed to a 32-bit ID
+ * with FNV-1a so hot paths compare and look up integers instead of strings. SID("literal") is
+ * hashed by the compiler; String_Table::intern() hashes runtime strings to the same value and
+ * remembers the text so IDs can be turned back into names for messages and reports.
+ * Two different names hashing to the same ID is reported on std::cerr when interned.
+*/
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+typedef uint32_t String_ID;
+
+#define STRING_ID_OFFSET 2166136261u
+#define STRING_ID_PRIME 16777619u
+
+// Single return statement so it stays constexpr under C++11
+constexpr String_ID string_id_hash(const char* str, String_ID hash = STRING_ID_OFFSET)
+{
+	return *str ? string_id_hash(str + 1, (hash ^ static_cast<uint8_t>(*str)) * STRING_ID_PRIME) : hash;
+}
+
+// Forces the hash of a string literal to be evaluated at compile time
+#define SID(literal) (std::integral_constant<String_ID, string_id_hash(literal)>::value)
+
+class String_Table {
+public:
+	// Hash a runtime string and remember its text. Safe to call from any thread
+	static String_ID intern(const std::string &name);
+
+	// Text of an interned ID, or its hex value if it was never interned
+	static std::string lookup(String_ID id);
+
+	static uint32_t size();
+};
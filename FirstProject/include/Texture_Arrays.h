@@ -0,0 +1,74 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Material textures live as layers of GL_TEXTURE_2D_ARRAYs, so draws of different
+ * materials can share one bound texture and only change the layer they sample. Each texture is
+ * loaded (and streamed, see Texture_Streamer) into an array of its own; once streaming has settled,
+ * pack() moves every texture that is alone in its array into a shared array holding all the others
+ * of the same size, format and mip count (GPU to GPU with glCopyImageSubData where the driver has
+ * ARB_copy_image, otherwise uploaded again from the cache file).
+ *
+ * Materials hold a Texture_Slot rather than a GL name. A slot stays valid when pack() moves its
+ * texture, so nothing has to resolve its textures again. bind() keeps the array bound to each unit
+ * and skips the glBindTexture when it is already there.
+ *
+ * Under memory pressure trim() drops the largest levels of the arrays bound least recently. Binding
+ * one of them again queues its levels to be loaded back from the cache, one a frame in update().
+ *
+ * The light-texture shader's samplers are fixed to units once per program (assign_units): the
+ * heightmap image on HEIGHTMAP_TEXTURE_UNIT and material m's diffuse, specular and normal maps on
+ * MATERIAL_TEXTURE_UNIT(m, 0..2). GL thread only.
+*/
+
+#include <cstdint>
+#include <string>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "../include/Texture_Cache.h"
+
+// Materials the shader mixes at most, and the maps each has
+#define MATERIAL_SLOTS 4
+#define MATERIAL_TEXTURE_MAPS 3
+#define HEIGHTMAP_TEXTURE_UNIT 0
+#define MATERIAL_TEXTURE_UNIT(material, map) (1 + (material) * MATERIAL_TEXTURE_MAPS + (map))
+// Units whose bindings are tracked (at least every unit above)
+#define TEXTURE_ARRAY_UNITS 16
+// Layers in one shared array; larger groups are split
+#define TEXTURE_ARRAY_MAX_LAYERS 64
+// trim() leaves every texture at least this large
+#define TEXTURE_TRIM_MIN 64
+
+// One texture in the arrays; 0 is no texture
+typedef uint32_t Texture_Slot;
+
+class Texture_Arrays {
+public:
+	// Streams the image into an array of its own until the next pack(). info as Texture_Cache::load.
+	// 0 (and a message on std::cerr) on failure
+	static Texture_Slot load(const std::string &file_name, Texture_Usage usage, Texture_Info* info = nullptr);
+	// The texture is deleted with the last slot in its array
+	static void release(Texture_Slot slot);
+
+	// Moves every texture alone in its array (and done streaming) into a shared array of its kind.
+	// Returns the textures moved
+	static uint32_t pack();
+	// Once a frame on the GL thread: pack()s after new loads, as soon as none is still streaming, and
+	// loads back a level of a trimmed array that has been bound since
+	static void update();
+
+	// Drops the largest level of the least recently bound array (unbound for idle_frames or more) until
+	// the arrays fit in target bytes or nothing is left to drop. Returns the levels dropped
+	static uint32_t trim(uint64_t target, uint32_t idle_frames);
+	// VRAM held by the arrays, counting unused layers of shared ones
+	static uint64_t resident_bytes();
+
+	// Binds the slot's array to unit unless it is bound there already. Returns the layer to sample
+	static GLint bind(GLuint unit, Texture_Slot slot);
+	// Forget what is bound (uploads bind textures too). Call at the start of each pass
+	static void reset_binds();
+	// Fixes the material and heightmap samplers of program to their units
+	static void assign_units(GLuint program);
+
+	static std::string report();
+};
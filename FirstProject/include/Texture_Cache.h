@@ -0,0 +1,153 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Cooked texture cache. The first time an image is loaded (or ahead of time with
+ * "make texture_cook") it is decoded once, a full mip chain is built from it with a box filter, the
+ * chain is block compressed for its usage (Texture_Compress) and the result is written to
+ * TEXTURE_CACHE_DIR as a DDS file. Every later load memory maps the DDS and uploads it one level at a
+ * time straight out of the mapping (glCompressedTexImage2D), so start up no longer decodes JPG / PNG.
+ * A cache file older than its source image, or cooked for another usage, is cooked again.
+ *
+ * Colour maps become BC1 (BC3 when any pixel is translucent), normal maps BC5 and data textures (the
+ * heightmap image, read as numbers) stay uncompressed. The RMS encode error is kept in the DDS header
+ * so reports can show it without decoding anything.
+ *
+ * Cube maps (the skybox) cook their six faces into a single DDS cube map: every face's mip chain in
+ * one file, in one compressed format, mapped and uploaded the same way.
+ *
+ * Textures are sampled trilinearly (GL_LINEAR_MIPMAP_LINEAR) with anisotropic filtering up to
+ * TEXTURE_ANISOTROPY where the driver has GL_EXT_texture_filter_anisotropic, so tiled terrain no
+ * longer aliases in the distance.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+
+#define TEXTURE_CACHE_DIR "./Materials/Cache/"
+// Upper bound on the anisotropy asked for; the driver's own limit applies when lower
+#define TEXTURE_ANISOTROPY 8.0f
+// Enough levels for a 32768 x 32768 image
+#define TEXTURE_MAX_LEVELS 16
+// Faces of a cube map, in GL order: +X, -X, +Y, -Y, +Z, -Z
+#define TEXTURE_CUBE_FACES 6
+
+enum Texture_Format {
+	TEXTURE_RGB8,
+	TEXTURE_RGBA8,
+	TEXTURE_BC1,
+	TEXTURE_BC3,
+	TEXTURE_BC5
+};
+
+// What a texture holds decides how it is cooked
+enum Texture_Usage {
+	TEXTURE_COLOUR,		// Diffuse, specular: BC1, or BC3 with alpha
+	TEXTURE_NORMAL,		// Tangent space normals: BC5 (X and Y; the shader rebuilds Z)
+	TEXTURE_DATA		// Read back as numbers: uncompressed
+};
+
+// One mip level. pixels points into memory owned elsewhere (a File_View or a build buffer)
+struct Texture_Level {
+	uint32_t width;
+	uint32_t height;
+	const unsigned char* pixels;
+	size_t bytes;
+};
+
+struct Texture_Image {
+	uint32_t width;
+	uint32_t height;
+	Texture_Format format;
+	uint32_t level_count;
+	Texture_Level levels[TEXTURE_MAX_LEVELS];
+	// RMS error of level 0 against the source image, in 8 bit steps; 0 when uncompressed
+	float error;
+
+	// Every level together, i.e. what the texture takes on the GPU
+	uint64_t bytes() const;
+	// The same chain as plain RGB8 / RGBA8
+	uint64_t uncompressed_bytes() const;
+};
+
+// Every face has the same size, format and level count
+struct Texture_Cube {
+	Texture_Image faces[TEXTURE_CUBE_FACES];
+
+	uint64_t bytes() const;
+};
+
+// What load() made, for reports
+struct Texture_Info {
+	Texture_Format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t level_count;
+	uint64_t gpu_bytes;
+	uint64_t uncompressed_bytes;
+	float error;
+};
+
+class File_View;
+
+class Texture_Cache {
+public:
+	// GL texture for an image file, cooking it into the cache first when there is no up to date copy
+	// for this usage. info describes the upload. target is GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY (one layer).
+	// 0 (and a message on std::cerr) on failure
+	static GLuint load(const std::string &file_name, Texture_Usage usage, Texture_Info* info = nullptr, GLenum target = GL_TEXTURE_2D);
+
+	// Decode, build the mips, compress and write the cache file for one image. Thread safe (no GL)
+	static bool cook(const std::string &file_name, Texture_Usage usage, Texture_Info* info = nullptr);
+	// Opens the up to date cache file (from a pack or disk, see VFS) of an image cooked for this usage
+	// and points image into it. False when it has to be cooked (again)
+	static bool open_cached(const std::string &file_name, Texture_Usage usage, File_View &cached, Texture_Image &image);
+	static void describe(const Texture_Image &image, Texture_Info* info);
+	// True when the cache file is missing or older than the image
+	static bool stale(const std::string &file_name);
+	static std::string cache_path(const std::string &file_name);
+
+	// Cooks the six face images (TEXTURE_CUBE_FACES order) into one cube map cache file: square faces of
+	// one size, BC1 (BC3 when any face is translucent). Thread safe (no GL)
+	static bool cook_cube(const std::vector<std::string> &faces, Texture_Info* info = nullptr);
+	// Opens the cube map of faces, as open_cached. A list of one file names a DDS cube map cooked elsewhere,
+	// which is used as it is
+	static bool open_cached_cube(const std::vector<std::string> &faces, File_View &cached, Texture_Cube &cube);
+	static bool cube_stale(const std::vector<std::string> &faces);
+	static std::string cube_cache_path(const std::vector<std::string> &faces);
+
+	// Decodes file_name into storage and points image at a full mip chain inside it
+	static bool decode(const std::string &file_name, std::vector<unsigned char> &storage, Texture_Image &image);
+	// Copies pixels (3 or 4 channels) into storage as level 0 followed by every smaller level
+	static void build_mips(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t channels,
+		std::vector<unsigned char> &storage, Texture_Image &image);
+
+	// The format an image is cooked to for this usage
+	static Texture_Format cooked_format(const Texture_Image &image, Texture_Usage usage);
+	// Encodes every level of an uncompressed chain as format into storage
+	static void compress(const Texture_Image &source, Texture_Format format, std::vector<unsigned char> &storage,
+		Texture_Image &compressed);
+	static size_t level_bytes(Texture_Format format, uint32_t width, uint32_t height);
+	static const char* format_name(Texture_Format format);
+
+	static bool write_dds(const std::string &file_name, const Texture_Image &image);
+	static bool write_dds(const std::string &file_name, const Texture_Cube &cube);
+	// Points image at the levels inside data (e.g. a File_View); nothing is copied. A cube map file
+	// only parses as a Texture_Cube and a 2D one only as a Texture_Image
+	static bool parse_dds(const unsigned char* data, size_t size, Texture_Image &image);
+	static bool parse_dds(const unsigned char* data, size_t size, Texture_Cube &cube);
+
+	// Falls back to decoding BC1 / BC3 on the CPU when the driver lacks S3TC
+	static GLuint upload(const Texture_Image &image, GLenum target = GL_TEXTURE_2D);
+	// One level into the texture bound to target (layer 0 of a one layer array for GL_TEXTURE_2D_ARRAY).
+	// pixels may be an offset into a bound GL_PIXEL_UNPACK_BUFFER
+	static void upload_level(GLenum target, Texture_Format format, uint32_t index, const Texture_Level &level, const void* pixels);
+	static GLenum internal_format(Texture_Format format);
+	// False for BC1 / BC3 without S3TC (upload() decodes those on the CPU)
+	static bool gpu_supports(Texture_Format format);
+	// Trilinear, anisotropic sampling over level_count levels of the texture bound to target
+	static void apply_sampling(GLenum target, uint32_t level_count);
+};
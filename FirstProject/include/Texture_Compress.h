@@ -0,0 +1,38 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: CPU encoder and decoder for the BCn block formats the texture cache cooks into. Every
+ * 4x4 block of pixels becomes 8 bytes (BC1: two RGB565 endpoints and a 2 bit index per pixel, 6:1
+ * against RGB8) or 16 bytes (BC3: a BC1 colour block after an 8 bit alpha ramp; BC5: two ramps, the
+ * X and Y of a normal map, read back as red and green).
+ *
+ * BC1 endpoints start at the extremes of the block along the principal axis of its colours and are
+ * then refined by least squares over the chosen indices; a ramp (BC4, the alpha of BC3 and each half
+ * of BC5) spans its channel's minimum to maximum. Large images are encoded in bands of block rows on
+ * the Job_System. The decoders measure the encode error and back the upload when a driver lacks S3TC.
+*/
+
+#include <cstdint>
+
+#include "../include/Texture_Cache.h"
+
+// Block rows encoded per job
+#define TEXTURE_ENCODE_ROWS 8
+
+class Texture_Compress {
+public:
+	// Bytes per 4x4 block, 0 for an uncompressed format
+	static uint32_t block_bytes(Texture_Format format);
+
+	// Encodes width x height pixels (3 or 4 channels) as format. Partial edge blocks repeat the last row / column
+	static void encode(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t channels,
+		Texture_Format format, unsigned char* blocks);
+	// Back to width x height RGBA8 (BC5 gives red, green, 0, 255)
+	static void decode(const unsigned char* blocks, uint32_t width, uint32_t height, Texture_Format format, unsigned char* rgba);
+
+	// One block of 16 RGBA pixels, row by row
+	static void encode_bc1(const unsigned char rgba[64], unsigned char block[8]);
+	static void decode_bc1(const unsigned char block[8], unsigned char rgba[64]);
+	// One block of 16 single channel values
+	static void encode_bc4(const unsigned char values[16], unsigned char block[8]);
+	static void decode_bc4(const unsigned char block[8], unsigned char values[16]);
+};
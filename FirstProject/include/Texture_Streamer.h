@@ -0,0 +1,55 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Streams cooked textures to the GPU over several frames instead of uploading a whole
+ * mip chain from client memory the moment it is asked for (a 4096 x 4096 colour map loaded by the
+ * paint brush used to stall the frame in glCompressedTexImage2D).
+ *
+ * request() maps the texture's cache file, creates the GL texture and uploads only the tail of small
+ * levels, so it can be sampled at once. The remaining levels go up smallest first through a ring of
+ * TEXTURE_STREAM_BUFFERS pixel buffer objects: update() maps a free buffer on the GL thread, a job
+ * copies the level out of the mapped file into it, and a later update() unmaps it, issues the upload
+ * from the buffer and fences it. A buffer is only reused once its fence has signalled, so mapping it
+ * never waits on the driver. At most TEXTURE_STREAM_BUDGET bytes are staged per frame (a larger level
+ * goes on its own). GL_TEXTURE_BASE_LEVEL follows the largest level uploaded, so detail sharpens from
+ * low to high as the levels arrive.
+ *
+ * Images with no up to date cache, and formats the driver can't take as they are, are loaded in one
+ * go by Texture_Cache::load as before. Everything but the copy jobs runs on the GL thread.
+*/
+
+#include <cstdint>
+#include <string>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "../include/Texture_Cache.h"
+
+// Pixel buffers in the ring
+#define TEXTURE_STREAM_BUFFERS 4
+// Bytes staged per update()
+#define TEXTURE_STREAM_BUDGET (4 * 1024 * 1024)
+// Levels no wider or taller than this are uploaded by request() itself
+#define TEXTURE_STREAM_TAIL 64
+
+class Texture_Streamer {
+public:
+	// GL texture for an image; only its smallest levels are resident until update() streams the rest.
+	// Same contract as Texture_Cache::load
+	static GLuint request(const std::string &file_name, Texture_Usage usage, Texture_Info* info = nullptr,
+		GLenum target = GL_TEXTURE_2D);
+	// Once per frame on the GL thread: recycles buffers, uploads finished copies and stages more
+	static void update(uint64_t budget = TEXTURE_STREAM_BUDGET);
+	// Streams everything requested so far before returning (loading screens, benchmarks)
+	static void flush();
+	// Stops streaming into texture. Call before deleting it
+	static void cancel(GLuint texture);
+	// Drops anything still streaming and deletes the buffers. Needs the GL context
+	static void release();
+
+	// True while texture still has levels to upload
+	static bool streaming(GLuint texture);
+	// Textures with levels still to upload
+	static uint32_t pending();
+	static std::string report();
+};
@@ -0,0 +1,121 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Structure of arrays storage for every Object and Component transform in a scene.
+ * Local location / rotation / scale, the built matrix and the bounding box each live in their own
+ * contiguous array, indexed by a handle. Objects and Components keep only the handle, so per frame
+ * passes (rebuilding matrices, collision sweeps) walk flat arrays instead of chasing pointers.
+ * Slots are recycled through a free list; the generation in each handle catches stale handles.
+ * References returned by the accessors are invalidated by create(), so never hold on to them.
+ *
+ * Transforms form a hierarchy (Object -> Component). Changing a local transform marks only that
+ * node dirty; update_world() then walks the hierarchy one depth level at a time and rebuilds the
+ * world, model (world * offset) and normal matrices of dirty nodes and everything below them.
+ * Nodes on the same level are independent, so large levels are split into batches on the Job_System.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+// Nodes per batch when a hierarchy level is split into jobs. Levels smaller than two batches
+// are updated on the calling thread, which covers every scene we currently ship.
+#define TRANSFORM_BATCH_SIZE 1024
+
+struct Transform_Handle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// Handle that never refers to a live transform (generations start at 1)
+const Transform_Handle NULL_TRANSFORM = { 0, 0 };
+
+class Transform_Store {
+public:
+	Transform_Store();
+
+	Transform_Handle create(glm::vec3 location, glm::quat rotation, glm::vec3 scale, Transform_Handle parent = NULL_TRANSFORM);
+	void destroy(Transform_Handle handle);
+	bool valid(Transform_Handle handle);
+
+	// Parent whose world matrix this node is placed in; NULL_TRANSFORM for the scene root
+	bool set_parent(Transform_Handle handle, Transform_Handle parent);
+	Transform_Handle parent(Transform_Handle handle);
+
+	// Local transform. The setters rebuild the local matrix and mark the node dirty
+	const glm::vec3& location(Transform_Handle handle);
+	const glm::quat& rotation(Transform_Handle handle);
+	const glm::vec3& scale(Transform_Handle handle);
+	void set_location(Transform_Handle handle, glm::vec3 location);
+	void set_rotation(Transform_Handle handle, glm::quat rotation);
+	void set_scale(Transform_Handle handle, glm::vec3 scale);
+	void set_local(Transform_Handle handle, glm::vec3 location, glm::quat rotation, glm::vec3 scale);
+
+	// Local matrix, built from translate * rotate * scale
+	const glm::mat4& matrix(Transform_Handle handle);
+
+	// Applied after the world matrix for drawing only, never inherited (e.g. a mesh's normalisation)
+	void set_offset(Transform_Handle handle, const glm::mat4 &offset);
+
+	// Valid after update_world(): parent world * local, world * offset, and the matching normal matrix
+	const glm::mat4& world(Transform_Handle handle);
+	const glm::mat4& model(Transform_Handle handle);
+	const glm::mat3& normal(Transform_Handle handle);
+
+	// Axis aligned bounding box, in the space the owner places it
+	glm::vec3& lower_bounds(Transform_Handle handle);
+	glm::vec3& upper_bounds(Transform_Handle handle);
+	void set_bounds(Transform_Handle handle, glm::vec3 lower, glm::vec3 upper);
+
+	// Rebuild one local matrix, or every live local matrix in a single pass over the arrays
+	void update(Transform_Handle handle);
+	void update_all();
+
+	// Rebuild world / model / normal matrices for dirty subtrees. Returns the number of nodes rebuilt
+	uint32_t update_world();
+
+	// Append every live transform whose bounds overlap the box
+	void query(glm::vec3 lower, glm::vec3 upper, std::vector<Transform_Handle> &overlapping);
+
+	uint32_t size();
+	uint32_t capacity();
+
+private:
+	void build_matrix(uint32_t index);
+	void mark_dirty(uint32_t index);
+	void build_levels();
+	uint32_t update_range(uint32_t begin, uint32_t end);
+
+	std::vector<glm::vec3> locations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec3> lowers;
+	std::vector<glm::vec3> uppers;
+
+	// Hierarchy
+	std::vector<Transform_Handle> parents;
+	std::vector<glm::mat4> offsets;
+	std::vector<glm::mat4> worlds;
+	std::vector<glm::mat4> models;
+	std::vector<glm::mat3> normals;
+	std::vector<uint8_t> dirty;
+	// Last update_world() pass that rebuilt each node; children compare against the running pass
+	std::vector<uint32_t> rebuilt_pass;
+
+	// Live nodes sorted by depth, with the offset of each level in it. Rebuilt when the hierarchy changes
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> parent_index;
+	std::vector<uint32_t> level_starts;
+	bool levels_stale;
+	uint32_t dirty_count;
+	uint32_t pass;
+
+	std::vector<uint32_t> generations;
+	std::vector<uint8_t> alive;
+	std::vector<uint32_t> free_slots;
+};
@@ -0,0 +1,88 @@
+#pragma once
+/* Author: Ben Weatherall (a1617712)
+ * Description: Virtual file system the asset loaders read through. A path is looked up in each
+ * mounted Asset_Pack (the last mounted first) and then on disk, and comes back as a File_View: a read
+ * only pointer and size straight into the pack's mapping, or into a mapping of the loose file.
+ * Nothing is copied; text loaders wrap the view in a View_Stream to read it line by line as they did
+ * an std::ifstream, binary ones (stb_image, DDS) parse the bytes in place.
+ *
+ * Paths are matched after normalise(), so "./Meshes/a/../Tree.obj" finds "Meshes/Tree.obj". A packed
+ * file hides a loose file of the same path until the pack is rebuilt.
+ *
+ * Mount packs before loading and unmount them after everything using a view is gone; lookups are
+ * safe from any thread in between.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "../include/Mapped_File.h"
+
+// Mounted by the game and benchmark at start up when it exists
+#define ASSET_PACK_DEFAULT "./Assets.pack"
+
+// The bytes of one file. Valid until close(), the destructor or (for a packed file) unmount_all()
+class File_View {
+public:
+	File_View();
+
+	bool is_open();
+	const unsigned char* data();
+	size_t size();
+	// True when the bytes are in a pack rather than a loose file
+	bool packed();
+	void close();
+
+private:
+	friend class VFS;
+	File_View(const File_View &) = delete;
+	File_View& operator=(const File_View &) = delete;
+
+	const unsigned char* m_data;
+	size_t m_size;
+	bool m_open;
+	bool m_packed;
+	// Only used for loose files
+	Mapped_File m_file;
+};
+
+// Reads memory (a File_View) as an std::istream, seeking included. The memory must outlive it
+class View_Buffer : public std::streambuf {
+public:
+	View_Buffer(const unsigned char* data, size_t size);
+
+protected:
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
+
+class View_Stream : private View_Buffer, public std::istream {
+public:
+	explicit View_Stream(File_View &view);
+	View_Stream(const unsigned char* data, size_t size);
+};
+
+class VFS {
+public:
+	// Maps a pack and searches it before everything mounted earlier. False (and a message) if it is not one
+	static bool mount(const std::string &pack_file);
+	static void unmount_all();
+
+	// The file from the packs or disk. False (and nothing on std::cerr) when it is in neither
+	static bool open(const std::string &file_name, File_View &view);
+	static bool exists(const std::string &file_name);
+	// As FileModifiedTime; a packed file has the time it had when it was packed
+	static int64_t modified_time(const std::string &file_name);
+	// Names of the files directly in dir, from the packs and disk, each once and sorted
+	static std::vector<std::string> directory_contents(const std::string &dir);
+
+	// "./Meshes//a\\..\\Tree.obj" -> "Meshes/Tree.obj": the form paths are packed and looked up in
+	static std::string normalise(const std::string &file_name);
+
+	// Packs mounted and how many opens each source served
+	static std::string report();
+};
@@ -0,0 +1,89 @@
+#include "../include/Arena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+Arena::Arena(size_t block_size)
+{
+	this->block_size = block_size;
+	current = 0;
+	offset = 0;
+	bytes_used = 0;
+	allocation_count = 0;
+}
+
+Arena::~Arena()
+{
+	for (auto &block : blocks)
+	{
+		free(block.data);
+	}
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+	// Fit in the block being filled, else the next kept block big enough, else a new block
+	while (current < blocks.size())
+	{
+		Block &block = blocks[current];
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+		size_t aligned = static_cast<size_t>(((base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base);
+		if (aligned + bytes <= block.size)
+		{
+			offset = aligned + bytes;
+			bytes_used += bytes;
+			allocation_count++;
+			return block.data + aligned;
+		}
+
+		current++;
+		offset = 0;
+	}
+
+	size_t size = bytes + alignment > block_size ? bytes + alignment : block_size;
+	Block block = { static_cast<char*>(malloc(size)), size };
+	if (!block.data)
+		throw std::bad_alloc();
+	blocks.push_back(block);
+	current = blocks.size() - 1;
+	offset = 0;
+
+	return allocate(bytes, alignment);
+}
+
+const char* Arena::copy(const char* text, size_t length)
+{
+	char* copied = allocate_array<char>(length + 1);
+	memcpy(copied, text, length);
+	copied[length] = '\0';
+	return copied;
+}
+
+void Arena::reset()
+{
+	current = 0;
+	offset = 0;
+	bytes_used = 0;
+	allocation_count = 0;
+}
+
+size_t Arena::used()
+{
+	return bytes_used;
+}
+
+uint64_t Arena::allocations()
+{
+	return allocation_count;
+}
+
+size_t Arena::capacity()
+{
+	size_t total = 0;
+	for (auto &block : blocks)
+	{
+		total += block.size;
+	}
+	return total;
+}
@@ -0,0 +1,248 @@
+#include "../include/Asset_Pack.h"
+#include "../include/Content_Hash.h"
+#include "../include/File_IO.h"
+#include "../include/VFS.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+static_assert(sizeof(Asset_Pack_Header) == 32, "Pack header must match the file layout");
+static_assert(sizeof(Asset_Pack_Entry) == 40, "Pack entry must match the file layout");
+
+static uint64_t path_hash(const std::string &path)
+{
+	return content_hash(path.data(), path.size());
+}
+
+static uint64_t align_up(uint64_t offset)
+{
+	return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+}
+
+Asset_Pack::Asset_Pack()
+{
+	m_entries = nullptr;
+	m_entry_count = 0;
+	m_names = nullptr;
+}
+
+bool Asset_Pack::open(const std::string &pack_file)
+{
+	close();
+	if (!m_file.open(pack_file))
+		return false;
+
+	// Offsets and sizes come from the file, so the range checks are written not to wrap around
+	uint64_t size = m_file.size();
+	Asset_Pack_Header header;
+	bool valid = size >= sizeof(header);
+	if (valid)
+	{
+		memcpy(&header, m_file.data(), sizeof(header));
+		uint64_t table_end = sizeof(header) + uint64_t(header.entry_count) * sizeof(Asset_Pack_Entry);
+		valid = header.magic == ASSET_PACK_MAGIC && header.version == ASSET_PACK_VERSION &&
+			table_end <= header.names_offset && header.names_offset <= size && header.names_bytes <= size - header.names_offset;
+	}
+	if (!valid)
+	{
+		std::cerr << "Not an asset pack: " << pack_file << std::endl;
+		close();
+		return false;
+	}
+
+	// The header is a multiple of 8 bytes, so the table is aligned for reading in place
+	m_entries = reinterpret_cast<const Asset_Pack_Entry*>(m_file.data() + sizeof(header));
+	m_entry_count = header.entry_count;
+	m_names = reinterpret_cast<const char*>(m_file.data() + header.names_offset);
+	for (uint32_t index = 0; index < m_entry_count; ++index)
+	{
+		const Asset_Pack_Entry &entry = m_entries[index];
+		if (entry.offset > size || entry.size > size - entry.offset ||
+			uint64_t(entry.name_offset) + entry.name_length > header.names_bytes)
+		{
+			std::cerr << "Corrupt asset pack: " << pack_file << std::endl;
+			close();
+			return false;
+		}
+	}
+	m_file_name = pack_file;
+	return true;
+}
+
+void Asset_Pack::close()
+{
+	m_file.close();
+	m_file_name.clear();
+	m_entries = nullptr;
+	m_entry_count = 0;
+	m_names = nullptr;
+}
+
+bool Asset_Pack::is_open()
+{
+	return m_entries != nullptr;
+}
+
+const Asset_Pack_Entry* Asset_Pack::find(const std::string &path)
+{
+	uint64_t hash = path_hash(path);
+	const Asset_Pack_Entry* end = m_entries + m_entry_count;
+	const Asset_Pack_Entry* entry = std::lower_bound(m_entries, end, hash,
+		[](const Asset_Pack_Entry &a, uint64_t b) { return a.path_hash < b; });
+
+	// Paths sharing a hash sit together; the name decides
+	for (; entry != end && entry->path_hash == hash; ++entry)
+	{
+		if (entry->name_length == path.size() && memcmp(m_names + entry->name_offset, path.data(), path.size()) == 0)
+			return entry;
+	}
+	return nullptr;
+}
+
+const unsigned char* Asset_Pack::contents(const Asset_Pack_Entry &entry)
+{
+	return m_file.data() + entry.offset;
+}
+
+std::string Asset_Pack::name(const Asset_Pack_Entry &entry)
+{
+	return std::string(m_names + entry.name_offset, entry.name_length);
+}
+
+uint32_t Asset_Pack::entry_count()
+{
+	return m_entry_count;
+}
+
+const Asset_Pack_Entry &Asset_Pack::entry(uint32_t index)
+{
+	return m_entries[index];
+}
+
+size_t Asset_Pack::size()
+{
+	return m_file.size();
+}
+
+const std::string &Asset_Pack::file_name()
+{
+	return m_file_name;
+}
+
+bool Asset_Pack::write(const std::string &pack_file, const std::vector<std::string> &files)
+{
+	// Lay the pack out from the file sizes first, so it is written front to back in one pass
+	struct Source {
+		std::string file;
+		std::string name;
+		Asset_Pack_Entry entry;
+	};
+	std::vector<Source> sources;
+	std::unordered_set<std::string> names;
+	for (const std::string &file : files)
+	{
+		Source source;
+		source.file = file;
+		source.name = VFS::normalise(file);
+		if (names.count(source.name))
+			continue;
+
+		std::ifstream in(file, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in)
+		{
+			std::cerr << "Unable to read: " << file << std::endl;
+			return false;
+		}
+		memset(&source.entry, 0, sizeof(source.entry));
+		source.entry.path_hash = path_hash(source.name);
+		source.entry.size = static_cast<uint64_t>(in.tellg());
+		source.entry.modified = FileModifiedTime(file);
+		names.insert(source.name);
+		sources.push_back(source);
+	}
+	std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b) {
+		return a.entry.path_hash != b.entry.path_hash ? a.entry.path_hash < b.entry.path_hash : a.name < b.name;
+	});
+
+	Asset_Pack_Header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.entry_count = static_cast<uint32_t>(sources.size());
+	header.names_offset = sizeof(header) + sources.size() * sizeof(Asset_Pack_Entry);
+
+	std::string name_block;
+	for (Source &source : sources)
+	{
+		source.entry.name_offset = static_cast<uint32_t>(name_block.size());
+		source.entry.name_length = static_cast<uint32_t>(source.name.size());
+		name_block += source.name;
+	}
+	header.names_bytes = name_block.size();
+
+	uint64_t offset = align_up(header.names_offset + header.names_bytes);
+	for (Source &source : sources)
+	{
+		source.entry.offset = offset;
+		offset = align_up(offset + source.entry.size);
+	}
+
+	// Write beside the real file and rename, so a reader never maps a half written pack
+	std::string temporary = pack_file + ".tmp";
+	FILE* out = fopen(temporary.c_str(), "wb");
+	if (!out)
+	{
+		std::cerr << "Unable to write: " << pack_file << std::endl;
+		return false;
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, out) == 1;
+	for (const Source &source : sources)
+		written = written && fwrite(&source.entry, sizeof(source.entry), 1, out) == 1;
+	written = written && fwrite(name_block.data(), 1, name_block.size(), out) == name_block.size();
+
+	std::vector<char> buffer(1 << 20);
+	const char padding[ASSET_PACK_ALIGNMENT] = {};
+	uint64_t position = header.names_offset + header.names_bytes;
+	for (const Source &source : sources)
+	{
+		if (!written)
+			break;
+		written = fwrite(padding, 1, size_t(source.entry.offset - position), out) == source.entry.offset - position;
+
+		// A file changing size while it is packed would break the layout
+		std::ifstream in(source.file, std::ios::in | std::ios::binary);
+		uint64_t left = source.entry.size;
+		while (written && left > 0)
+		{
+			size_t chunk = static_cast<size_t>(std::min<uint64_t>(left, buffer.size()));
+			written = in.read(buffer.data(), chunk) && fwrite(buffer.data(), 1, chunk, out) == chunk;
+			left -= chunk;
+		}
+		if (!written)
+			std::cerr << "Unable to pack: " << source.file << std::endl;
+		position = source.entry.offset + source.entry.size;
+	}
+	written = fclose(out) == 0 && written;
+
+	if (!written)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+#if _WIN32 || _WIN64
+	// rename won't replace an existing file on Windows (POSIX replaces it atomically)
+	remove(pack_file.c_str());
+#endif
+	if (rename(temporary.c_str(), pack_file.c_str()) != 0)
+	{
+		std::cerr << "Unable to write: " << pack_file << std::endl;
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
@@ -10,6 +10,7 @@ Camera::Camera(glm::vec3 position , glm::vec3 up , GLfloat yaw, GLfloat pitch) :
 		this->Pitch = pitch;
 		this->updateCameraVectors();
         	this->LookAtFocus = nullptr;
+        	this->CircleFocus = nullptr;
 }
 
 Camera::Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch) : Zoom(ZOOM), Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY)
@@ -20,6 +21,7 @@ Camera::Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat up
 	this->Pitch = pitch;
 	this->updateCameraVectors();
    	this->LookAtFocus = nullptr;
+   	this->CircleFocus = nullptr;
 }
 
 glm::mat4 Camera::GetViewMatrix()
@@ -2,17 +2,14 @@
 
 Component::Component() {
     m_Mesh        = nullptr;
-    m_rotation    = nullptr;
-	m_location    = nullptr;
-	m_scale       = nullptr;
+    m_mesh_handle = Resource_Pool<Mesh*>::null_handle();
+    m_handle      = NULL_TRANSFORM;
     scene_tracker = nullptr;
 }
 
-Component::Component(std::string name, std::string static_details, loadedComponents* scene_tracker) : Component()
+Component::Component(std::string name, std::string static_details, Resource_Manager* scene_tracker) : Component()
 {
-	glm::vec3 rotation;
-	this->m_location = new glm::vec3;
-	this->m_scale = new glm::vec3;
+	glm::vec3 rotation, location, scale;
 	this->scene_tracker = scene_tracker;
 	std::string mesh_file_name;
 
@@ -23,131 +20,171 @@ Component::Component(std::string name, std::string static_details, loadedCompone
 
 	// 'Component_Name' COMPONENT_FILE scale.x scale.y scale.z loc.x loc.y loc.z rot.x rot.y rot.z // Local
 	iss >> m_name >> mesh_file_name >>
-		m_scale->x >> m_scale->y >> m_scale->z >>
-		m_location->x >> m_location->y >> m_location->z >>
+		scale.x >> scale.y >> scale.z >>
+		location.x >> location.y >> location.z >>
 		rotation.x >> rotation.y >> rotation.z;
 
 	// Quaternion Rotation attempt
-	m_rotation = new glm::quat(rotation);
+	m_handle = scene_tracker->Transforms->create(location, glm::quat(rotation), scale);
 
 	std::cout << "Loading: " << m_name << " (" << mesh_file_name << ")" << std::endl;
-	std::cout << "\tScale: " << m_scale->x << " " << m_scale->y << " " << m_scale->z << std::endl;
-	std::cout << "\tLocation: " << m_location->x << " " << m_location->y << " " << m_location->z << std::endl;
+	std::cout << "\tScale: " << scale.x << " " << scale.y << " " << scale.z << std::endl;
+	std::cout << "\tLocation: " << location.x << " " << location.y << " " << location.z << std::endl;
 	std::cout << "\tRotation: " << rotation.x << " " << rotation.y << " " << rotation.z << std::endl;
 
 	this->m_mesh_name = mesh_file_name;
-
-	if (scene_tracker->Meshes->find(mesh_file_name) == scene_tracker->Meshes->end())
-	{
-		this->m_Mesh = new Mesh(mesh_file_name, scene_tracker);
-		scene_tracker->Meshes->insert(std::make_pair(mesh_file_name, std::make_pair(m_Mesh, 1)));
-	}
-	else
-	{
-		std::cout << "Loaded cached mesh.\n";
-		this->m_Mesh = scene_tracker->Meshes->at(mesh_file_name).first;
-		scene_tracker->Meshes->at(mesh_file_name).second++;
-	}
+	acquire_mesh();
 
 
+	scene_tracker->Transforms->set_offset(m_handle, m_Mesh->get_transform());
 	build_component_transform();
 	compute_bounds();
 
-	std::cerr << "Component Bounds: (" << m_lower_bounds.x << ", " << m_lower_bounds.y << ", " << m_lower_bounds.z << ") - (" << m_upper_bounds.x << ", " << m_upper_bounds.y << ", " << m_upper_bounds.z << ")\n" << std::endl;
+	std::cerr << "Component Bounds: (" << get_lower_bounds().x << ", " << get_lower_bounds().y << ", " << get_lower_bounds().z << ") - (" << get_upper_bounds().x << ", " << get_upper_bounds().y << ", " << get_upper_bounds().z << ")\n" << std::endl;
 }
 
-Component::Component(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, loadedComponents* scene_tracker) : Component()
+Component::Component(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, Resource_Manager* scene_tracker) : Component()
 {
 	this->m_name = name;
 	this->m_mesh_name = mesh_name;
-	this->m_rotation = new glm::quat(rot);
-	this->m_location = new glm::vec3(loc);
-	this->m_scale = new glm::vec3(scale);
-  
   this->scene_tracker = scene_tracker;
+	this->m_handle = scene_tracker->Transforms->create(loc, rot, scale);
   
-	if (scene_tracker->Meshes->find(m_mesh_name) == scene_tracker->Meshes->end())
-	{
-		this->m_Mesh = new Mesh(m_mesh_name, scene_tracker);
-		scene_tracker->Meshes->insert(std::make_pair(m_mesh_name, std::make_pair(m_Mesh, 1)));
-	}
-	else
-	{
-		std::cout << "Loaded cached mesh.\n";
-		this->m_Mesh = scene_tracker->Meshes->at(m_mesh_name).first;
-		scene_tracker->Meshes->at(m_mesh_name).second++;
-	}
+	acquire_mesh();
 
 
+	scene_tracker->Transforms->set_offset(m_handle, m_Mesh->get_transform());
 	build_component_transform();
 	compute_bounds();
 
-	std::cerr << "Component Bounds: (" << m_lower_bounds.x << ", " << m_lower_bounds.y << ", " << m_lower_bounds.z << ") - (" << m_upper_bounds.x << ", " << m_upper_bounds.y << ", " << m_upper_bounds.z << ")\n" << std::endl;
+	std::cerr << "Component Bounds: (" << get_lower_bounds().x << ", " << get_lower_bounds().y << ", " << get_lower_bounds().z << ") - (" << get_upper_bounds().x << ", " << get_upper_bounds().y << ", " << get_upper_bounds().z << ")\n" << std::endl;
 
 }
 
+Component::Component(const Component &prototype) : Component()
+{
+	this->m_name = prototype.m_name;
+	this->m_mesh_name = prototype.m_mesh_name;
+	this->scene_tracker = prototype.scene_tracker;
+
+	Transform_Store* transforms = scene_tracker->Transforms;
+	this->m_handle = transforms->create(transforms->location(prototype.m_handle), transforms->rotation(prototype.m_handle), transforms->scale(prototype.m_handle));
+
+	// The prototype's reference keeps the mesh resident, so this can't fail
+	this->m_mesh_handle = prototype.m_mesh_handle;
+	scene_tracker->Meshes.acquire(m_mesh_handle, String_Table::intern(m_name));
+	this->m_Mesh = prototype.m_Mesh;
+
+	transforms->set_offset(m_handle, m_Mesh->get_transform());
+	build_component_transform();
+	compute_bounds();
+}
+
 Component::~Component()
 {
-	m_Mesh->remove_instance();
-	if (scene_tracker->Meshes->at(m_mesh_name).first == 0)
+	// The mesh (and its buffers) goes at the end of the frame if this was the last component using it
+	scene_tracker->Meshes.release(m_mesh_handle, String_Table::intern(m_name));
+	m_Mesh = nullptr;
+
+	scene_tracker->Transforms->destroy(m_handle);
+}
+
+void Component::acquire_mesh()
+{
+	String_ID mesh_id = String_Table::intern(m_mesh_name);
+	String_ID holder = String_Table::intern(m_name);
+
+	m_mesh_handle = scene_tracker->Meshes.find(mesh_id);
+	if (scene_tracker->Meshes.acquire(m_mesh_handle, holder))
 	{
-		delete m_Mesh;
+		std::cout << "Loaded cached mesh.\n";
+	}
+	else
+	{
+		Mesh* mesh = new Mesh(m_mesh_name, scene_tracker);
+		m_mesh_handle = scene_tracker->Meshes.add(mesh_id, mesh, mesh->get_gpu_bytes(), holder);
 	}
 
-	delete m_location;
-	delete m_scale;
-	delete m_rotation;
+	this->m_Mesh = scene_tracker->Meshes.get(m_mesh_handle);
 }
 
-void Component::draw(GLuint shader)
+void Component::snapshot(std::vector<Draw_Item> &draw_list)
 {
-	GLuint modelLoc = glGetUniformLocation(shader, "component");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
-	m_Mesh->draw(shader);
+	// object * component * mesh normalisation, and its normal matrix, prebuilt by Transforms->update_world()
+	Draw_Item item = { m_Mesh, scene_tracker->Transforms->model(m_handle), scene_tracker->Transforms->normal(m_handle) };
+	draw_list.push_back(item);
 }
 
-glm::vec3 Component::get_lower_bounds()
+void Component::set_parent(Transform_Handle parent)
 {
-	return m_lower_bounds;
+	scene_tracker->Transforms->set_parent(m_handle, parent);
+	invalidate_scene_bounds();
+}
 
+void Component::invalidate_scene_bounds()
+{
+	m_scene_lower_bounds = glm::vec3(0);
+	m_scene_upper_bounds = glm::vec3(0);
 }
 
-glm::vec3 Component::get_upper_bounds()
+void Component::set_location(glm::vec3 location)
 {
-	return m_upper_bounds;
+	scene_tracker->Transforms->set_location(m_handle, location);
+	compute_bounds();
 }
 
-void Component::build_component_transform()
+void Component::set_rotation(glm::quat rotation)
+{
+	scene_tracker->Transforms->set_rotation(m_handle, rotation);
+	compute_bounds();
+}
+
+void Component::set_scale(glm::vec3 scale)
 {
-	m_transform = glm::mat4();
-	m_transform = glm::translate(m_transform, *m_location);
+	scene_tracker->Transforms->set_scale(m_handle, scale);
+	compute_bounds();
+}
 
-	m_transform *= glm::toMat4(*m_rotation);
+glm::vec3 Component::get_lower_bounds()
+{
+	return scene_tracker->Transforms->lower_bounds(m_handle);
 
-	m_transform = glm::scale(m_transform, *m_scale);
+}
 
+glm::vec3 Component::get_upper_bounds()
+{
+	return scene_tracker->Transforms->upper_bounds(m_handle);
+}
+
+void Component::build_component_transform()
+{
+	scene_tracker->Transforms->update(m_handle);
 }
 
 void Component::compute_bounds()
 {
 	// Shift our upper and lower bounds by transform, then reasses each vertex for the new max and min positions
+	const glm::mat4 &transform = scene_tracker->Transforms->matrix(m_handle);
+
 	glm::vec4 tmp_vec_L = glm::vec4(m_Mesh->get_lower_bounds(), 1.0);
-	tmp_vec_L = m_transform * tmp_vec_L;
+	tmp_vec_L = transform * tmp_vec_L;
 
 	glm::vec4 tmp_vec_H = glm::vec4(m_Mesh->get_upper_bounds(), 1.0);
-	tmp_vec_H = m_transform * tmp_vec_H;
+	tmp_vec_H = transform * tmp_vec_H;
 
-	m_lower_bounds = glm::vec3(glm::min(tmp_vec_L.x, tmp_vec_H.x), glm::min(tmp_vec_L.y, tmp_vec_H.y), glm::min(tmp_vec_L.z, tmp_vec_H.z));
+	scene_tracker->Transforms->set_bounds(m_handle,
+		glm::vec3(glm::min(tmp_vec_L.x, tmp_vec_H.x), glm::min(tmp_vec_L.y, tmp_vec_H.y), glm::min(tmp_vec_L.z, tmp_vec_H.z)),
+		glm::vec3(glm::max(tmp_vec_L.x, tmp_vec_H.x), glm::max(tmp_vec_L.y, tmp_vec_H.y), glm::max(tmp_vec_L.z, tmp_vec_H.z)));
 
-	m_upper_bounds = glm::vec3(glm::max(tmp_vec_L.x, tmp_vec_H.x), glm::max(tmp_vec_L.y, tmp_vec_H.y), glm::max(tmp_vec_L.z, tmp_vec_H.z));
+	invalidate_scene_bounds();
 }
 
 void Component::compute_scene_bounds(glm::mat4 & scene_transform)
 {
-	glm::vec4 tmp_vec_L = glm::vec4(m_lower_bounds, 1.0);
+	glm::vec4 tmp_vec_L = glm::vec4(get_lower_bounds(), 1.0);
 	tmp_vec_L = scene_transform * tmp_vec_L;
 
-	glm::vec4 tmp_vec_H = glm::vec4(m_upper_bounds, 1.0);
+	glm::vec4 tmp_vec_H = glm::vec4(get_upper_bounds(), 1.0);
 	tmp_vec_H = scene_transform * tmp_vec_H;
 
 	m_scene_lower_bounds = glm::vec3(glm::min(tmp_vec_L.x, tmp_vec_H.x), glm::min(tmp_vec_L.y, tmp_vec_H.y), glm::min(tmp_vec_L.z, tmp_vec_H.z));
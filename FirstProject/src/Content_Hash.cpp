@@ -0,0 +1,115 @@
+#include "../include/Content_Hash.h"
+#include "../include/VFS.h"
+
+#include <cstring>
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotate_left(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned little endian loads (every platform the game builds for is little endian)
+static inline uint64_t read64(const unsigned char* data)
+{
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const unsigned char* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static inline uint64_t lane_round(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * XXH_PRIME64_2;
+	accumulator = rotate_left(accumulator, 31);
+	return accumulator * XXH_PRIME64_1;
+}
+
+static inline uint64_t merge_round(uint64_t accumulator, uint64_t value)
+{
+	accumulator ^= lane_round(0, value);
+	return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t content_hash(const void* data, size_t bytes, uint64_t seed)
+{
+	const unsigned char* input = static_cast<const unsigned char*>(data);
+	const unsigned char* end = input + bytes;
+	uint64_t hash;
+
+	if (bytes >= 32)
+	{
+		// Four independent lanes over 32 byte stripes
+		uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = seed + XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - XXH_PRIME64_1;
+		const unsigned char* limit = end - 32;
+		do
+		{
+			v1 = lane_round(v1, read64(input));
+			v2 = lane_round(v2, read64(input + 8));
+			v3 = lane_round(v3, read64(input + 16));
+			v4 = lane_round(v4, read64(input + 24));
+			input += 32;
+		} while (input <= limit);
+
+		hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+		hash = merge_round(hash, v1);
+		hash = merge_round(hash, v2);
+		hash = merge_round(hash, v3);
+		hash = merge_round(hash, v4);
+	}
+	else
+	{
+		hash = seed + XXH_PRIME64_5;
+	}
+	hash += static_cast<uint64_t>(bytes);
+
+	// The last 0 - 31 bytes
+	while (input + 8 <= end)
+	{
+		hash ^= lane_round(0, read64(input));
+		hash = rotate_left(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		input += 8;
+	}
+	if (input + 4 <= end)
+	{
+		hash ^= static_cast<uint64_t>(read32(input)) * XXH_PRIME64_1;
+		hash = rotate_left(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		input += 4;
+	}
+	while (input < end)
+	{
+		hash ^= (*input) * XXH_PRIME64_5;
+		hash = rotate_left(hash, 11) * XXH_PRIME64_1;
+		input++;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+uint64_t file_content_hash(const std::string &file_name, uint64_t seed)
+{
+	File_View file;
+	if (!VFS::open(file_name, file))
+		return 0;
+	return content_hash(file.data(), file.size(), seed);
+}
@@ -1,5 +1,11 @@
 #include "../include/File_IO.h"
 
+#include <cerrno>
+#include <sys/stat.h>
+#if _WIN32 || _WIN64
+	#include <direct.h>
+#endif
+
 std::vector<std::string> DirectoryContents(std::string dir)
 {
 	/* TODO: Dir addresses in Windows differs to linux. will need to change how dirs are handled for each system
@@ -42,6 +48,53 @@ std::vector<std::string> DirectoryContents(std::string dir)
 	return FileList;
 }
 
+static void walk_directory(const std::string &dir, const std::string &prefix, std::vector<std::string> &files)
+{
+#if _WIN32 || _WIN64
+	WIN32_FIND_DATA fd;
+	HANDLE hFind = ::FindFirstFile((dir + prefix + "*").c_str(), &fd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+	do {
+		std::string name = fd.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			walk_directory(dir, prefix + name + "/", files);
+		else
+			files.push_back(prefix + name);
+	} while (::FindNextFile(hFind, &fd));
+	::FindClose(hFind);
+#else
+	DIR *dp = opendir((dir + prefix).c_str());
+	if (dp == NULL)
+		return;
+	struct dirent *dirp;
+	while ((dirp = readdir(dp)) != NULL) {
+		std::string name = dirp->d_name;
+		if (name == "." || name == "..")
+			continue;
+		struct stat info;
+		if (stat((dir + prefix + name).c_str(), &info) != 0)
+			continue;
+		if (S_ISDIR(info.st_mode))
+			walk_directory(dir, prefix + name + "/", files);
+		else if (S_ISREG(info.st_mode))
+			files.push_back(prefix + name);
+	}
+	closedir(dp);
+#endif
+}
+
+std::vector<std::string> DirectoryTree(std::string dir)
+{
+	if (!dir.empty() && dir.back() != '/' && dir.back() != '\\')
+		dir += "/";
+	std::vector<std::string> files;
+	walk_directory(dir, "", files);
+	return files;
+}
+
 std::string GetBaseDir(const std::string & filepath)
 {
 	if (filepath.find_last_of("/\\") != std::string::npos)
@@ -63,3 +116,21 @@ bool FileExists(const std::string &abs_filename)
 
 	return ret;
 }
+
+int64_t FileModifiedTime(const std::string &filename)
+{
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0)
+		return -1;
+	return static_cast<int64_t>(info.st_mtime);
+}
+
+bool MakeDirectory(const std::string &dir)
+{
+#if _WIN32 || _WIN64
+	int result = _mkdir(dir.c_str());
+#else
+	int result = mkdir(dir.c_str(), 0755);
+#endif
+	return result == 0 || errno == EEXIST;
+}
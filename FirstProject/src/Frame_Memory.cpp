@@ -0,0 +1,141 @@
+#include "../include/Frame_Memory.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Counted by the replacement global operator new below
+static std::atomic<uint64_t> heap_allocations(0);
+static std::atomic<uint64_t> heap_bytes(0);
+
+static uint64_t frame_start_allocations = 0;
+static uint64_t frame_start_bytes = 0;
+static uint64_t completed_frames = 0;
+static uint64_t completed_allocations = 0;
+static uint64_t worst_frame_allocations = 0;
+static bool frame_started = false;
+
+static void* counted_allocate(size_t size)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	heap_bytes.fetch_add(size, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+	void* memory = counted_allocate(size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	void* memory = counted_allocate(size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t &) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t &) noexcept
+{
+	free(memory);
+}
+
+void Frame_Memory::new_frame()
+{
+	if (frame_started)
+	{
+		uint64_t allocations = frame_allocations();
+		completed_frames++;
+		completed_allocations += allocations;
+		if (allocations > worst_frame_allocations)
+			worst_frame_allocations = allocations;
+	}
+	frame_started = true;
+
+	frame_start_allocations = heap_allocations.load(std::memory_order_relaxed);
+	frame_start_bytes = heap_bytes.load(std::memory_order_relaxed);
+	scratch().reset();
+}
+
+Arena& Frame_Memory::scratch()
+{
+	static Arena arena;
+	return arena;
+}
+
+const char* Frame_Memory::format(const char* format, ...)
+{
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (length < 0)
+		return "";
+	if (static_cast<size_t>(length) < sizeof(text))
+		return scratch().copy(text, length);
+
+	// Too long for the stack buffer: print straight into the arena
+	char* long_text = scratch().allocate_array<char>(length + 1);
+	va_start(args, format);
+	vsnprintf(long_text, length + 1, format, args);
+	va_end(args);
+	return long_text;
+}
+
+uint64_t Frame_Memory::frame_allocations()
+{
+	return heap_allocations.load(std::memory_order_relaxed) - frame_start_allocations;
+}
+
+uint64_t Frame_Memory::frame_allocated_bytes()
+{
+	return heap_bytes.load(std::memory_order_relaxed) - frame_start_bytes;
+}
+
+uint64_t Frame_Memory::total_allocations()
+{
+	return heap_allocations.load(std::memory_order_relaxed);
+}
+
+std::string Frame_Memory::report()
+{
+	char text[160];
+	snprintf(text, sizeof(text), "Heap allocations per frame: mean %.1f, max %llu (%llu frames, scratch arena %llu KB)\n",
+		completed_frames ? double(completed_allocations) / completed_frames : 0.0,
+		static_cast<unsigned long long>(worst_frame_allocations),
+		static_cast<unsigned long long>(completed_frames),
+		static_cast<unsigned long long>(scratch().capacity() / 1024));
+	return text;
+}
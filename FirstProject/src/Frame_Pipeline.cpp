@@ -0,0 +1,185 @@
+#include "../include/Frame_Pipeline.h"
+#include "../include/Profiler.h"
+
+#include <cstdio>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+Frame_Pipeline::Frame_Pipeline(bool threaded)
+{
+	m_threaded = threaded;
+	front_index = 0;
+	submitted = 0;
+	pending = nullptr;
+	busy = false;
+	stopping = false;
+
+	if (m_threaded)
+		worker = std::thread(&Frame_Pipeline::worker_loop, this);
+}
+
+Frame_Pipeline::~Frame_Pipeline()
+{
+	if (!m_threaded)
+		return;
+
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [this]() { return !busy; });
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+bool Frame_Pipeline::threaded()
+{
+	return m_threaded;
+}
+
+void Frame_Pipeline::submit(const Step &step)
+{
+	// Serial mode simulates straight into the snapshot about to be drawn
+	Render_Snapshot &target = snapshots[m_threaded ? 1 - front_index : front_index];
+	target.frame = ++submitted;
+	target.input_time = std::chrono::steady_clock::now();
+
+	if (m_threaded)
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			pending = &step;
+			busy = true;
+		}
+		wake.notify_one();
+	}
+	else
+	{
+		step(target);
+		target.simulation_ms = elapsed_ms(target.input_time, std::chrono::steady_clock::now());
+	}
+
+	render_start = std::chrono::steady_clock::now();
+}
+
+Render_Snapshot& Frame_Pipeline::front()
+{
+	return snapshots[front_index];
+}
+
+void Frame_Pipeline::present()
+{
+	Render_Snapshot &presented = snapshots[front_index];
+	// Frame 0 is whatever was captured before the first submit; it has no input to measure from
+	if (presented.frame == 0)
+		return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	latency.add(elapsed_ms(presented.input_time, now));
+	simulation.add(presented.simulation_ms);
+	render.add(elapsed_ms(render_start, now));
+
+	if (interval.count() == 0 && render.count() == 1)
+		first_present = now;
+	else
+		interval.add(elapsed_ms(last_present, now));
+	last_present = now;
+}
+
+void Frame_Pipeline::sync()
+{
+	if (!m_threaded)
+		return;
+
+	PROFILE_SCOPE("Frame_Pipeline::sync");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [this]() { return !busy; });
+	}
+	wait.add(elapsed_ms(start, std::chrono::steady_clock::now()));
+
+	front_index = 1 - front_index;
+}
+
+void Frame_Pipeline::worker_loop()
+{
+	for (;;)
+	{
+		const Step* step;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this]() { return busy || stopping; });
+			if (stopping)
+				return;
+			step = pending;
+		}
+
+		{
+			PROFILE_SCOPE("Frame_Pipeline::simulate");
+			Render_Snapshot &target = snapshots[1 - front_index];
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			(*step)(target);
+			target.simulation_ms = elapsed_ms(start, std::chrono::steady_clock::now());
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			busy = false;
+		}
+		done.notify_one();
+	}
+}
+
+double Frame_Pipeline::frames_per_second()
+{
+	double seconds = elapsed_ms(first_present, last_present) / 1000.0;
+	return seconds > 0 ? interval.count() / seconds : 0;
+}
+
+Frame_Histogram* Frame_Pipeline::latency_times()
+{
+	return &latency;
+}
+
+Frame_Histogram* Frame_Pipeline::simulation_times()
+{
+	return &simulation;
+}
+
+Frame_Histogram* Frame_Pipeline::render_times()
+{
+	return &render;
+}
+
+Frame_Histogram* Frame_Pipeline::wait_times()
+{
+	return &wait;
+}
+
+void Frame_Pipeline::clear_stats()
+{
+	latency.clear();
+	simulation.clear();
+	render.clear();
+	wait.clear();
+	interval.clear();
+}
+
+std::string Frame_Pipeline::report()
+{
+	char text[512];
+	snprintf(text, sizeof(text),
+		"Pipeline (%s): %llu frames\t%.1f fps\n"
+		"\tLatency (input to present)\tmean %.2f ms\tp50 %.2f ms\tp95 %.2f ms\tmax %.2f ms\n"
+		"\tSimulation %.2f ms\trender %.2f ms\tsync wait %.2f ms (means)\n",
+		m_threaded ? "threaded" : "serial",
+		static_cast<unsigned long long>(latency.count()),
+		frames_per_second(),
+		latency.mean(), latency.percentile(0.50), latency.percentile(0.95), latency.max(),
+		simulation.mean(), render.mean(), wait.mean());
+	return text;
+}
@@ -0,0 +1,129 @@
+#include "../include/GPU_Profiler.h"
+
+#include <cstring>
+#include <iostream>
+
+std::vector<GPU_Profiler::Pass> GPU_Profiler::passes;
+int GPU_Profiler::active_pass = -1;
+uint32_t GPU_Profiler::slot = 0;
+uint64_t GPU_Profiler::dropped = 0;
+bool GPU_Profiler::warned_nesting = false;
+
+void GPU_Profiler::new_frame()
+{
+	if (active_pass >= 0)
+	{
+		end();
+	}
+
+	slot = (slot + 1) % GPU_PROFILER_LATENCY;
+
+	// The queries in this slot were issued GPU_PROFILER_LATENCY frames ago
+	for (auto &pass : passes)
+	{
+		if (!pass.issued[slot])
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &elapsed);
+			Profiler::record_gpu(pass.name, pass.submitted[slot], elapsed, pass.frame[slot]);
+		}
+		else
+		{
+			// Reusing the query discards the pending result; better than blocking on it
+			dropped++;
+		}
+
+		pass.issued[slot] = false;
+	}
+}
+
+bool GPU_Profiler::begin(const char* name)
+{
+	if (active_pass >= 0)
+	{
+		if (!warned_nesting)
+		{
+			std::cerr << "GPU_Profiler: " << name << " nested inside " << passes[active_pass].name << ", ignoring.\n";
+			warned_nesting = true;
+		}
+		return false;
+	}
+
+	Pass* pass = find_pass(name);
+
+	// A pass drawn twice in a frame keeps only its first timing
+	if (pass->issued[slot])
+		return false;
+
+	pass->submitted[slot] = Profiler::now();
+	pass->frame[slot] = Profiler::current_frame();
+	pass->issued[slot] = true;
+
+	glBeginQuery(GL_TIME_ELAPSED, pass->queries[slot]);
+	active_pass = static_cast<int>(pass - passes.data());
+	return true;
+}
+
+void GPU_Profiler::end()
+{
+	if (active_pass < 0)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	active_pass = -1;
+}
+
+uint64_t GPU_Profiler::dropped_results()
+{
+	return dropped;
+}
+
+void GPU_Profiler::release()
+{
+	for (auto &pass : passes)
+	{
+		glDeleteQueries(GPU_PROFILER_LATENCY, pass.queries);
+	}
+	passes.clear();
+	active_pass = -1;
+}
+
+GPU_Profiler::Pass* GPU_Profiler::find_pass(const char* name)
+{
+	// Only a handful of passes; a linear scan beats hashing the name every frame
+	for (auto &pass : passes)
+	{
+		if (pass.name == name || strcmp(pass.name, name) == 0)
+			return &pass;
+	}
+
+	Pass pass;
+	pass.name = name;
+	glGenQueries(GPU_PROFILER_LATENCY, pass.queries);
+	for (uint32_t idx = 0; idx < GPU_PROFILER_LATENCY; ++idx)
+	{
+		pass.issued[idx] = false;
+		pass.submitted[idx] = 0;
+		pass.frame[idx] = 0;
+	}
+	passes.push_back(pass);
+
+	return &passes.back();
+}
+
+GPU_Profile_Scope::GPU_Profile_Scope(const char* name)
+{
+	m_active = GPU_Profiler::begin(name);
+}
+
+GPU_Profile_Scope::~GPU_Profile_Scope()
+{
+	if (m_active)
+		GPU_Profiler::end();
+}
@@ -1,27 +1,41 @@
 #include "../include/Heightmap.h"
-
-#include <fstream>
+#include "../include/Render_Stats.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Frame_Memory.h"
+#include "../include/Texture_Streamer.h"
+#include "../include/Texture_Arrays.h"
+#include "../include/Content_Hash.h"
+#include "../include/Image_Decoder.h"
+#include "../include/VFS.h"
+
+#include <cstring>
 #include <sstream>
 #include <cmath>
 #include "../include/stb_image.h"
 
-Heightmap::Heightmap(std::string name, std::string height_map_file, loadedComponents* scene_tracker)
+Heightmap::Heightmap(std::string name, std::string height_map_file, Resource_Manager* scene_tracker)
 {
 	std::cerr << "\tName: " << name;
 	std::cerr << " (" << height_map_file << ")\n";
 
 	this->scene_tracker = scene_tracker;
 	m_name = name;
+	m_height_texture = 0;
+	map_image = nullptr;
+	gathering_textures = nullptr;
+	bLoaded = false;
+	m_buffer_bytes = 0;
+	m_image_bytes = 0;
 
 	materials = new std::vector<tinyobj::material_t>;
 
 
-	std::ifstream fb; // FileBuffer
-	fb.open(height_map_file.c_str(), std::ios::in);
+	File_View file;
 	std::string LineBuf, material_file;
 	std::stringstream ss;
 
-	if (fb.is_open()) {
+	if (VFS::open(height_map_file, file)) {
+		View_Stream fb(file); // FileBuffer
 		std::getline(fb, LineBuf);
 		ss.str(LineBuf);
 
@@ -33,24 +47,26 @@ Heightmap::Heightmap(std::string name, std::string height_map_file, loadedCompon
 	{
 		std::cerr << "ERROR: " << height_map_file << " Failed to open.\n";
 		std::cerr << "Error: " << strerror(errno) << std::endl;
-		fb.close();
 		return;
 	}
-	fb.close();
+	file.close();
 	std::cout << "\tHeight Map Image: " << m_height_file << std::endl;
 	std::cout << "\tMaterial File: " << material_file << std::endl;
 	std::cout << "\tMesh Scale: " << m_mesh_scale.x  << ":" << m_mesh_scale.y << ":" << m_mesh_scale.z << std::endl;
 	std::cout << "\tTexture Scale: " << m_texture_scale.x << ":" << m_texture_scale.y << std::endl;
 
+	// The height image decodes on a worker while the materials load
+	Image_Future height_image = Image_Decoder::decode(m_height_file);
+
 	std::cerr << "\tLoading Materials" << std::endl;
 
 	// Load Heightmap Materials
 	std::map<std::string, int>* material_map = new std::map<std::string, int>;
-	std::ifstream mat_fb;
-	mat_fb.open((material_file), std::ios::in);
+	File_View mat_file;
 	std::string warn;
-	if(mat_fb.is_open())
+	if(VFS::open(material_file, mat_file))
 	{
+		View_Stream mat_fb(mat_file);
 		tinyobj::LoadMtl(material_map, materials, static_cast<std::istream*>(&mat_fb), &warn);
 
 		if(!warn.empty())
@@ -63,7 +79,7 @@ Heightmap::Heightmap(std::string name, std::string height_map_file, loadedCompon
 	{
 		std::cerr << "ERROR: " << material_file << " Failed to open.\n";
 	}
-	mat_fb.close();
+	mat_file.close();
 
 	delete material_map;
 
@@ -73,7 +89,7 @@ Heightmap::Heightmap(std::string name, std::string height_map_file, loadedCompon
 	materials->at(materials->size() - 1).diffuse_texname = "_default.png";
 
 	std::cerr << "\tLoading Map from Image" << std::endl;
-	LoadHeightMapFromImage(m_height_file);
+	LoadHeightMapFromImage(m_height_file, height_image);
 
 	std::cerr << "\tSetting up textures" << std::endl;
 	setupTextures("./Materials/");
@@ -82,15 +98,24 @@ Heightmap::Heightmap(std::string name, std::string height_map_file, loadedCompon
 	build_transform();
 
 	std::cerr << "\tLoad Interpolation texture" << std::endl;
-	loadTexture("./Materials/", m_height_file);
+	loadTexture("./Materials/", m_height_file, TEXTURE_DATA);
+
+	resolveTextures();
 }
 
 Heightmap::~Heightmap()
 {
 	ReleaseHeightmap();
 
+	String_ID holder = String_Table::intern(m_name);
+	for (auto &texture : texture_handles)
+	{
+		scene_tracker->Textures.release(texture, holder);
+	}
+
 	delete materials;
 	stbi_image_free(map_image);
+	Memory_Stats::release(mHEIGHTMAP_IMAGE, m_image_bytes);
 }
 
 void Heightmap::SetRenderSize(float fRenderX, float fHeight, float fRenderZ)
@@ -124,89 +149,37 @@ void Heightmap::draw(GLuint shader)
 	GLuint modelLoc = glGetUniformLocation(shader, "model");
 	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
 
-	GLuint componentLoc = glGetUniformLocation(shader, "component");
-	glUniformMatrix4fv(componentLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4()));
-
-	GLuint objectLoc = glGetUniformLocation(shader, "object");
-	glUniformMatrix4fv(objectLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4()));
+	GLuint normalLoc = glGetUniformLocation(shader, "normal_matrix");
+	glUniformMatrix3fv(normalLoc, 1, GL_FALSE, glm::value_ptr(glm::inverseTranspose(glm::mat3(m_transform))));
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(m_height_file).first);
-	glUniform1i(glGetUniformLocation(shader, "heightmap"), 0);
+	glActiveTexture(GL_TEXTURE0 + HEIGHTMAP_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_height_texture);
 
 	glm::vec2 shifted_scale = glm::vec2(m_mesh_scale.x, m_mesh_scale.z);
 	glUniform2fv(glGetUniformLocation(shader, "heightmap_scale"), 1, glm::value_ptr(shifted_scale));
 
-	for(uint32_t mat_idx = 0; mat_idx < materials->size(); mat_idx++)
+	for(uint32_t mat_idx = 0; mat_idx < materials->size() && mat_idx < MATERIAL_SLOTS; mat_idx++)
 	{
-		// -- Texture Uniforms --
-		std::string loc_str = "material[" + std::to_string(mat_idx) + "]";
-
-		// std::cout << "Loading " << loc_str << " : " << materials->at(mat_idx).name << std::endl;
-		// Load diffuse texture
-		glActiveTexture(GL_TEXTURE0+(mat_idx * TEXTURE_MAPS)+1);
-
-		std::string diffuse_texname = materials->at(mat_idx).diffuse_texname;
-
-		if (materials->at(mat_idx).diffuse_texname.length() > 0 && scene_tracker->Textures->find(diffuse_texname) != scene_tracker->Textures->end()) {
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(diffuse_texname).first);
-			GLuint dif = glGetUniformLocation(shader, (loc_str + ".diffuse").c_str());
-
-			glUniform1i(dif, (mat_idx * TEXTURE_MAPS)+1);
-		}
-		else
-		{
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default.png").first);
-			GLuint dif = glGetUniformLocation(shader, (loc_str + ".diffuse").c_str());
-
-			glUniform1i(dif, (mat_idx * TEXTURE_MAPS)+1);
-		}
-
-		// Load specular texture
-		glActiveTexture(GL_TEXTURE0+ (mat_idx * TEXTURE_MAPS) + 2);
-		std::string specular_texname = materials->at(mat_idx).specular_texname;
-
-		if (materials->at(mat_idx).specular_texname.length() > 0 && scene_tracker->Textures->find(specular_texname) != scene_tracker->Textures->end()) {
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(specular_texname).first);
-			GLuint spec = glGetUniformLocation(shader, (loc_str + ".specular").c_str());
-
-			glUniform1i(spec,  (mat_idx * TEXTURE_MAPS) + 2);
-		}
-		else
-		{
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default.png").first);
-			GLuint spec = glGetUniformLocation(shader, (loc_str + ".specular").c_str());
-
-			glUniform1i(spec, (mat_idx * TEXTURE_MAPS) + 2);
-		}
-
-		// Load specular texture
-		glActiveTexture(GL_TEXTURE0 + (mat_idx * TEXTURE_MAPS) + 3);
-		std::string normal_texname = materials->at(mat_idx).normal_texname;
-
-		if (materials->at(mat_idx).normal_texname.length() > 0 && scene_tracker->Textures->find(normal_texname) != scene_tracker->Textures->end()) {
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(normal_texname).first);
-			GLuint spec = glGetUniformLocation(shader, (loc_str + ".normal").c_str());
-
-			glUniform1i(spec, (mat_idx * TEXTURE_MAPS) + 3);
-		}
-		else
-		{
-			glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default.png").first);
-			GLuint spec = glGetUniformLocation(shader, (loc_str + ".normal").c_str());
-
-			glUniform1i(spec, (mat_idx * TEXTURE_MAPS) + 3);
-		}
+		// -- Texture Uniforms (names built in the frame scratch arena) --
+		// Each material's maps go on its own units; an array already there is not bound again
+		const Material_Textures &textures = material_textures[mat_idx];
+		GLint layers[MATERIAL_TEXTURE_MAPS] = {
+			Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(mat_idx, 0), textures.diffuse),
+			Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(mat_idx, 1), textures.specular),
+			Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(mat_idx, 2), textures.normal)
+		};
+		GLuint layer_loc = glGetUniformLocation(shader, Frame_Memory::format("material[%u].layers", mat_idx));
+		glUniform3iv(layer_loc, 1, layers);
 
 		// -- Material Uniforms --
 		;
-		GLuint diffuseColor = glGetUniformLocation(shader, (loc_str+ ".diffuse_color").c_str());
+		GLuint diffuseColor = glGetUniformLocation(shader, Frame_Memory::format("material[%u].diffuse_color", mat_idx));
 		glUniform3fv(diffuseColor, 1, materials->at(mat_idx).diffuse);
 
-		GLuint shininess = glGetUniformLocation(shader, (loc_str + ".shininess").c_str());
+		GLuint shininess = glGetUniformLocation(shader, Frame_Memory::format("material[%u].shininess", mat_idx));
 		glUniform1f(shininess, materials->at(mat_idx).shininess);
 
-		GLuint loaded = glGetUniformLocation(shader, (loc_str + ".loaded").c_str());
+		GLuint loaded = glGetUniformLocation(shader, Frame_Memory::format("material[%u].loaded", mat_idx));
 		glUniform1f(loaded, true);
 	}
 
@@ -217,29 +190,31 @@ void Heightmap::draw(GLuint shader)
 	glPrimitiveRestartIndex(iRows*iCols);
 
 	glDrawElements(GL_TRIANGLE_STRIP, indices_count, GL_UNSIGNED_INT, 0);
+	Render_Stats::draw(indices_count);
 
 
 	glDisable(GL_PRIMITIVE_RESTART);
 	// Unload our textures;
 	for (uint32_t mat_idx = 0; mat_idx < materials->size(); mat_idx++)
 	{
-		std::string loc_str = "material[" + std::to_string(mat_idx) + "]";
-		GLuint loaded = glGetUniformLocation(shader, (loc_str + ".loaded").c_str());
+		GLuint loaded = glGetUniformLocation(shader, Frame_Memory::format("material[%u].loaded", mat_idx));
 		glUniform1f(loaded, false);
 
 	}
 
 	glUniform1i(glGetUniformLocation(shader, "is_heightmap"), 0);
 	glBindVertexArray(0);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Heightmap::ReleaseHeightmap()
 {
 	if (!bLoaded)
 		return; // Heightmap must be loaded
+	glDeleteBuffers(6, m_map.vb);
+	glDeleteBuffers(1, &m_map.idx);
 	glDeleteVertexArrays(1, &m_map.va);
+	Memory_Stats::release(mHEIGHTMAP_BUFFERS, m_buffer_bytes);
+	m_buffer_bytes = 0;
 	bLoaded = false;
 }
 
@@ -253,7 +228,7 @@ uint32_t Heightmap::GetNumHeightmapCols()
 	return iCols;
 }
 
-bool Heightmap::LoadHeightMapFromImage(std::string sImagePath)
+bool Heightmap::LoadHeightMapFromImage(std::string sImagePath, Image_Future &decoding)
 {
 	if (bLoaded)
 	{
@@ -261,8 +236,17 @@ bool Heightmap::LoadHeightMapFromImage(std::string sImagePath)
 		ReleaseHeightmap();
 	}
 
-	int ix, iz, ic;
-	map_image = stbi_load(sImagePath.c_str(), &ix, &iz, &ic, STBI_default);
+	// The image stays resident for GetFloor(); a reload replaces it
+	if (map_image)
+	{
+		stbi_image_free(map_image);
+		Memory_Stats::release(mHEIGHTMAP_IMAGE, m_image_bytes);
+		m_image_bytes = 0;
+	}
+
+	Decoded_Image decoded = decoding.get();
+	map_image = decoded.pixels;
+	int ix = decoded.width, iz = decoded.height, ic = decoded.channels;
 	if (!map_image) {
 		std::cerr << "Unable to load texture: " << sImagePath << std::endl;
 		exit(1);
@@ -271,6 +255,8 @@ bool Heightmap::LoadHeightMapFromImage(std::string sImagePath)
 	iCols = ix;
 	iRows = iz;
 	composition = ic;
+	m_image_bytes = uint64_t(ix) * iz * ic;
+	Memory_Stats::allocate(mHEIGHTMAP_IMAGE, m_image_bytes);
 	uint32_t img_size = ix * iz;
 
 	std::cout << "\tMap Parameters\tX: " << iCols << "\tY: " << iRows << "\tDepth: " << composition << std::endl;
@@ -500,6 +486,9 @@ bool Heightmap::LoadHeightMapFromImage(std::string sImagePath)
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+	m_buffer_bytes = (vb_pos->size() + vb_norm->size() + vb_col->size() + vb_tan->size() + vb_bitan->size()) * sizeof(glm::vec3) +
+		vb_tex->size() * sizeof(glm::vec2) + indices->size() * sizeof(GLuint);
+	Memory_Stats::allocate(mHEIGHTMAP_BUFFERS, m_buffer_bytes);
 
 	bLoaded = true; // If get here, we succeeded with generating heightmap
 
@@ -514,8 +503,28 @@ bool Heightmap::LoadHeightMapFromImage(std::string sImagePath)
 
 }
 
+// Where a material's texture is: as named, ./Materials/ for the default, otherwise base_dir. Empty if
+// it is in none of them
+static std::string texture_path(const std::string &base_dir, const std::string &texture_name)
+{
+	if (VFS::exists(texture_name))
+		return texture_name;
+
+	// If desired, grab the default material (from it's default location)
+	std::string texture_filename;
+	if (texture_name == "_default.png")
+		texture_filename = "./Materials/" + texture_name;
+	else // Append base dir.
+		texture_filename = base_dir + texture_name;
+
+	return VFS::exists(texture_filename) ? texture_filename : "";
+}
+
 void Heightmap::setupTextures(std::string base_dir)
 {
+	// Gathered first, so the ones missing from the cache are cooked on the workers together
+	std::vector<std::pair<std::string, Texture_Usage>> textures;
+	gathering_textures = &textures;
 	for (size_t m = 0; m < materials->size(); m++) {
 		tinyobj::material_t* mp = &materials->at(m);
 
@@ -553,63 +562,95 @@ void Heightmap::setupTextures(std::string base_dir)
 			loadTexture(base_dir, mp->emissive_texname);
 
 		if (mp->normal_texname.length() > 0)
-			loadTexture(base_dir, mp->normal_texname);
+			loadTexture(base_dir, mp->normal_texname, TEXTURE_NORMAL);
+	}
+	gathering_textures = nullptr;
+
+	std::vector<std::pair<std::string, Texture_Usage>> files;
+	for (const auto &texture : textures)
+	{
+		std::string texture_filename = texture_path(base_dir, texture.first);
+		if (!texture_filename.empty() && !scene_tracker->Textures.valid(scene_tracker->Textures.find(String_Table::intern(texture.first))))
+			files.push_back(std::make_pair(texture_filename, texture.second));
 	}
+	Image_Decoder::prepare_all(files);
+
+	for (const auto &texture : textures)
+		loadTexture(base_dir, texture.first, texture.second);
 }
 
-void Heightmap::loadTexture(std::string base_dir, std::string texture_name)
+void Heightmap::loadTexture(std::string base_dir, std::string texture_name, Texture_Usage usage)
 {
+	if (gathering_textures)
+	{
+		gathering_textures->push_back(std::make_pair(texture_name, usage));
+		return;
+	}
 	std::cerr << "\tLoading Texture: " << texture_name << std::endl;
-	// Only load the texture if it is not already loaded
-	if (scene_tracker->Textures->find(texture_name) == scene_tracker->Textures->end()) {
-		GLuint texture_id;
-		int w, h;
-		int comp;
-
-		std::string texture_filename = texture_name;
+	String_ID texture_key = String_Table::intern(texture_name);
 
-		if (!FileExists(texture_filename)) {
+	String_ID holder = String_Table::intern(m_name);
 
-			// If desired, grab the default material (from it's default location)
-			if (texture_filename == "_default.png")
-				texture_filename = "./Materials/" + texture_name;
-			else // Append base dir.
-				texture_filename = base_dir + texture_name;
+	// Only load the texture if it is not already loaded
+	Texture_Handle texture = scene_tracker->Textures.find(texture_key);
+	if (!scene_tracker->Textures.acquire(texture, holder)) {
+		std::string texture_filename = texture_path(base_dir, texture_name);
+		if (texture_filename.empty()) {
+			std::cerr << "Unable to find file: " << texture_name << std::endl;
+			exit(1);
+		}
 
-			if (!FileExists(texture_filename)) {
-				std::cerr << "Unable to find file: " << texture_name << std::endl;
+		// Same contents as a texture already loaded (usage is part of the hash, so the heightmap image
+		// never shares with a material map)
+		uint64_t contents = file_content_hash(texture_filename, usage);
+		texture = scene_tracker->share_texture(texture_key, contents, holder);
+		if (!scene_tracker->Textures.valid(texture)) {
+			// Cooked on first use like a mesh texture; the larger levels stream in. Material maps go into the
+			// texture arrays, the heightmap image stays a texture of its own
+			Texture_Info texture_info;
+			Texture_Resource resource = { 0, 0, texture_info };
+			if (usage == TEXTURE_DATA)
+				resource.id = Texture_Streamer::request(texture_filename, usage, &texture_info);
+			else
+				resource.slot = Texture_Arrays::load(texture_filename, usage, &texture_info);
+			if (!resource.id && !resource.slot) {
+				std::cerr << "Unable to load texture: " << texture_filename << std::endl;
 				exit(1);
 			}
-		}
+			resource.info = texture_info;
 
-		unsigned char* image = stbi_load(texture_filename.c_str(), &w, &h, &comp, STBI_default);
-		if (!image) {
-			std::cerr << "Unable to load texture: " << texture_filename << std::endl;
-			exit(1);
-		}
-
-		glGenTextures(1, &texture_id);
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		if (comp == 3) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		}
-		else if (comp == 4) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+			texture = scene_tracker->Textures.add(texture_key, resource, texture_info.gpu_bytes, holder);
+			scene_tracker->add_texture_contents(contents, texture);
 		}
+	}
+	texture_handles.push_back(texture);
+}
 
-		// Unbind
-		glBindTexture(GL_TEXTURE_2D, 0);
-		stbi_image_free(image);
+void Heightmap::resolveTextures()
+{
+	m_height_texture = scene_tracker->Textures.get(scene_tracker->Textures.find(String_Table::intern(m_height_file))).id;
 
-		scene_tracker->Textures->insert(std::make_pair(texture_name, std::make_pair(texture_id, 1)));
-	}
-	else {
-		scene_tracker->Textures->at(texture_name).second++;
+	material_textures.resize(materials->size());
+	for (size_t m = 0; m < materials->size(); m++) {
+		const tinyobj::material_t &material = materials->at(m);
+		material_textures[m].diffuse = resolveTexture(material.diffuse_texname);
+		material_textures[m].specular = resolveTexture(material.specular_texname);
+		material_textures[m].normal = resolveTexture(material.normal_texname);
 	}
 }
 
+Texture_Slot Heightmap::resolveTexture(const std::string &texture_name)
+{
+	// Missing or unnamed maps fall back to the default texture, as they always have
+	Texture_Slot texture = 0;
+	if (texture_name.length() > 0)
+		texture = scene_tracker->Textures.get(scene_tracker->Textures.find(String_Table::intern(texture_name))).slot;
+	if (!texture)
+		texture = scene_tracker->Textures.get(scene_tracker->Textures.find(SID("_default.png"))).slot;
+
+	return texture;
+}
+
 glm::vec3 calculate_surface_normal(glm::vec3 const vertex_1, glm::vec3 const vertex_2, glm::vec3 const vertex_3)
 {
 	glm::vec3 normal;
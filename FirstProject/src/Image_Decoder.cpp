@@ -0,0 +1,289 @@
+#include "../include/Image_Decoder.h"
+#include "../include/Job_System.h"
+#include "../include/Profiler.h"
+#include "../include/VFS.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+
+#include "../include/stb_image.h"
+
+struct Decode_State {
+	std::string file_name;
+	int channels;
+	// Cook into the texture cache instead of returning pixels
+	bool cook;
+	Texture_Usage usage;
+	// Cook these into one cube map instead of file_name
+	std::vector<std::string> faces;
+
+	Job* job;
+	std::atomic<bool> done;
+	bool succeeded;
+	Decoded_Image image;
+	// The future and the job; the last to let go deletes it
+	std::atomic<int32_t> references;
+};
+
+struct Decode_Stats {
+	std::atomic<uint64_t> decoded;
+	std::atomic<uint64_t> cooked;
+	std::atomic<uint64_t> failed;
+	std::atomic<uint64_t> microseconds;
+};
+
+// Decodes queued, oldest first. Finished ones are dropped as new ones are queued
+static std::deque<Decode_State*> in_flight;
+static std::mutex queue_lock;
+static Decode_Stats stats;
+
+static void let_go(Decode_State* state)
+{
+	if (state->references.fetch_sub(1) == 1)
+	{
+		Image_Decoder::free(state->image);
+		delete state;
+	}
+}
+
+// Until done, run jobs (the decode itself, if no worker has taken it)
+static void wait_for(Decode_State* state)
+{
+	while (!state->done.load(std::memory_order_acquire))
+		Job_System::wait(state->job);
+}
+
+static void run_decode(Decode_State* state)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (state->cook && !state->faces.empty())
+	{
+		bool stale = Texture_Cache::cube_stale(state->faces);
+		state->succeeded = !stale || Texture_Cache::cook_cube(state->faces);
+		if (stale && state->succeeded)
+			stats.cooked++;
+	}
+	else if (state->cook)
+	{
+		bool stale = Texture_Cache::stale(state->file_name);
+		state->succeeded = !stale || Texture_Cache::cook(state->file_name, state->usage);
+		if (stale && state->succeeded)
+			stats.cooked++;
+	}
+	else
+	{
+		PROFILE_SCOPE("Image_Decoder::decode");
+		Decoded_Image &image = state->image;
+		int file_channels = 0;
+		File_View file;
+		if (VFS::open(state->file_name, file))
+			image.pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &image.width, &image.height,
+				&file_channels, state->channels);
+		image.channels = state->channels ? state->channels : file_channels;
+		state->succeeded = image.pixels != nullptr;
+		if (state->succeeded)
+		{
+			stats.decoded++;
+		}
+		else
+		{
+			image.width = image.height = image.channels = 0;
+			std::cerr << "Unable to load texture: " << state->file_name << std::endl;
+		}
+	}
+	stats.failed += !state->succeeded;
+	stats.microseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	state->done.store(true, std::memory_order_release);
+	let_go(state);
+}
+
+static void decode_job(Job*, const void* data)
+{
+	Decode_State* state;
+	memcpy(&state, data, sizeof(state));
+	run_decode(state);
+}
+
+Image_Future Image_Decoder::queue(Decode_State* state)
+{
+	state->job = nullptr;
+	state->done.store(false);
+	state->succeeded = false;
+	state->image.pixels = nullptr;
+	state->image.width = state->image.height = state->image.channels = 0;
+	state->references.store(2);
+
+	Image_Future future;
+	future.state = state;
+	if (!Job_System::running())
+	{
+		run_decode(state);
+		return future;
+	}
+
+	// Created before anyone else can see the state, since waiting on it runs the job
+	state->job = Job_System::create(decode_job, &state, sizeof(state));
+	{
+		std::unique_lock<std::mutex> guard(queue_lock);
+		while (!in_flight.empty() && in_flight.front()->done.load(std::memory_order_acquire))
+		{
+			let_go(in_flight.front());
+			in_flight.pop_front();
+		}
+
+		// Full: wait for the oldest rather than queue without bound
+		while (in_flight.size() >= IMAGE_DECODE_QUEUE)
+		{
+			Decode_State* oldest = in_flight.front();
+			in_flight.pop_front();
+			guard.unlock();
+			wait_for(oldest);
+			let_go(oldest);
+			guard.lock();
+		}
+
+		// The queue holds a reference of its own
+		state->references.fetch_add(1);
+		in_flight.push_back(state);
+	}
+
+	Job_System::run(state->job);
+	return future;
+}
+
+Image_Future::Image_Future() : state(nullptr)
+{
+}
+
+Image_Future::Image_Future(Image_Future &&other) : state(other.state)
+{
+	other.state = nullptr;
+}
+
+Image_Future& Image_Future::operator=(Image_Future &&other)
+{
+	if (this != &other)
+	{
+		if (state)
+			let_go(state);
+		state = other.state;
+		other.state = nullptr;
+	}
+	return *this;
+}
+
+Image_Future::~Image_Future()
+{
+	if (state)
+		let_go(state);
+}
+
+bool Image_Future::valid() const
+{
+	return state != nullptr;
+}
+
+bool Image_Future::ready() const
+{
+	return state && state->done.load(std::memory_order_acquire);
+}
+
+Decoded_Image Image_Future::get()
+{
+	Decoded_Image image = { nullptr, 0, 0, 0 };
+	if (!state)
+		return image;
+
+	wait_for(state);
+	// Ownership of the pixels moves to the caller
+	image = state->image;
+	state->image.pixels = nullptr;
+	let_go(state);
+	state = nullptr;
+	return image;
+}
+
+bool Image_Future::wait()
+{
+	if (!state)
+		return false;
+
+	wait_for(state);
+	bool succeeded = state->succeeded;
+	let_go(state);
+	state = nullptr;
+	return succeeded;
+}
+
+Image_Future Image_Decoder::decode(const std::string &file_name, int channels)
+{
+	Decode_State* state = new Decode_State();
+	state->file_name = file_name;
+	state->channels = channels;
+	state->cook = false;
+	state->usage = TEXTURE_COLOUR;
+	return queue(state);
+}
+
+Image_Future Image_Decoder::prepare(const std::string &file_name, Texture_Usage usage)
+{
+	Decode_State* state = new Decode_State();
+	state->file_name = file_name;
+	state->channels = 0;
+	state->cook = true;
+	state->usage = usage;
+	return queue(state);
+}
+
+Image_Future Image_Decoder::prepare_cube(const std::vector<std::string> &faces)
+{
+	Decode_State* state = new Decode_State();
+	state->file_name = faces.empty() ? std::string() : faces[0];
+	state->channels = 0;
+	state->cook = true;
+	state->usage = TEXTURE_COLOUR;
+	state->faces = faces;
+	return queue(state);
+}
+
+void Image_Decoder::prepare_all(const std::vector<std::pair<std::string, Texture_Usage>> &files)
+{
+	PROFILE_SCOPE("Image_Decoder::prepare_all");
+	// Two jobs cooking one file would both write its cache entry
+	std::vector<std::string> queued;
+	std::vector<Image_Future> cooking;
+	for (const auto &file : files)
+	{
+		if (std::find(queued.begin(), queued.end(), file.first) != queued.end())
+			continue;
+		queued.push_back(file.first);
+		cooking.push_back(prepare(file.first, file.second));
+	}
+
+	for (Image_Future &future : cooking)
+		future.wait();
+}
+
+void Image_Decoder::free(Decoded_Image &image)
+{
+	if (image.pixels)
+		stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+}
+
+std::string Image_Decoder::report()
+{
+	char text[256];
+	snprintf(text, sizeof(text), "Image decoding: %llu decoded, %llu cooked, %llu failed, %.1f ms of work\n",
+		static_cast<unsigned long long>(stats.decoded.load()),
+		static_cast<unsigned long long>(stats.cooked.load()),
+		static_cast<unsigned long long>(stats.failed.load()),
+		stats.microseconds.load() / 1000.0);
+	return text;
+}
@@ -0,0 +1,268 @@
+#include "../include/Input_Recorder.h"
+
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+static const char INPUT_MAGIC[4] = { 'B', 'E', 'I', 'R' };
+
+Input_Recorder::Input_Recorder()
+{
+	cursor_pos = 0;
+	is_recording = false;
+	is_replaying = false;
+	timestep = INPUT_TIMESTEP;
+	steps = 0;
+}
+
+Input_Recorder::~Input_Recorder()
+{
+	stop();
+}
+
+bool Input_Recorder::start_recording(std::string file_name, double p_timestep)
+{
+	stop();
+
+	out.open(file_name, std::ios::out | std::ios::binary);
+	if (!out.is_open())
+	{
+		std::cerr << "Could not open input recording: " << file_name << std::endl;
+		return false;
+	}
+
+	timestep = p_timestep;
+	steps = 0;
+	is_recording = true;
+
+	out.write(INPUT_MAGIC, sizeof(INPUT_MAGIC));
+	write<uint32_t>(INPUT_RECORDING_VERSION);
+	write<double>(timestep);
+
+	std::cout << "Recording input to: " << file_name << std::endl;
+	return true;
+}
+
+bool Input_Recorder::start_replay(std::string file_name)
+{
+	stop();
+
+	std::ifstream fs(file_name, std::ios::in | std::ios::binary);
+	if (!fs.is_open())
+	{
+		std::cerr << "Could not open input recording: " << file_name << std::endl;
+		return false;
+	}
+
+	// Recordings are small (a few bytes per event); read the lot up front
+	data.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+	cursor_pos = 0;
+
+	char magic[4];
+	uint32_t version = 0;
+	if (data.size() < sizeof(magic))
+	{
+		std::cerr << "Not an input recording: " << file_name << std::endl;
+		return false;
+	}
+	memcpy(magic, data.data(), sizeof(magic));
+	cursor_pos = sizeof(magic);
+
+	if (memcmp(magic, INPUT_MAGIC, sizeof(magic)) != 0 || !read(version) || !read(timestep))
+	{
+		std::cerr << "Not an input recording: " << file_name << std::endl;
+		return false;
+	}
+	if (version != INPUT_RECORDING_VERSION)
+	{
+		std::cerr << "Input recording " << file_name << " is version " << version << ", expected " << INPUT_RECORDING_VERSION << std::endl;
+		return false;
+	}
+
+	steps = 0;
+	is_replaying = true;
+
+	std::cout << "Replaying input from: " << file_name << " (" << data.size() << " bytes)" << std::endl;
+	return true;
+}
+
+void Input_Recorder::stop()
+{
+	if (is_recording)
+	{
+		out.close();
+		std::cout << "Input recording finished after " << steps << " steps" << std::endl;
+	}
+
+	is_recording = false;
+	is_replaying = false;
+	data.clear();
+	cursor_pos = 0;
+}
+
+bool Input_Recorder::recording()
+{
+	return is_recording;
+}
+
+bool Input_Recorder::replaying()
+{
+	return is_replaying;
+}
+
+double Input_Recorder::get_timestep()
+{
+	return timestep;
+}
+
+uint64_t Input_Recorder::get_steps()
+{
+	return steps;
+}
+
+void Input_Recorder::key(int key, int action)
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iKEY);
+	write<int16_t>(static_cast<int16_t>(key));
+	write<uint8_t>(static_cast<uint8_t>(action));
+}
+
+void Input_Recorder::mouse_button(int button, int action)
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iMOUSE_BUTTON);
+	write<uint8_t>(static_cast<uint8_t>(button));
+	write<uint8_t>(static_cast<uint8_t>(action));
+}
+
+void Input_Recorder::cursor(double x, double y)
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iCURSOR);
+	write<double>(x);
+	write<double>(y);
+}
+
+void Input_Recorder::brush(uint32_t brush, uint32_t scale, float y_offset)
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iBRUSH);
+	write<uint32_t>(brush);
+	write<uint32_t>(scale);
+	write<float>(y_offset);
+}
+
+void Input_Recorder::frame(double delta)
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iFRAME);
+	write<float>(static_cast<float>(delta));
+}
+
+void Input_Recorder::step()
+{
+	if (!is_recording)
+		return;
+
+	write<uint8_t>(iSTEP);
+	steps++;
+}
+
+bool Input_Recorder::next(Input_Event &event)
+{
+	if (!is_replaying)
+		return false;
+
+	event.code = 0;
+	event.action = 0;
+	event.x = 0.0;
+	event.y = 0.0;
+
+	if (!read(event.type))
+	{
+		is_replaying = false;
+		return false;
+	}
+
+	bool complete = true;
+	switch (event.type)
+	{
+		case iKEY:
+		{
+			int16_t key = 0;
+			uint8_t action = 0;
+			complete = read(key) && read(action);
+			event.code = key;
+			event.action = action;
+			break;
+		}
+		case iMOUSE_BUTTON:
+		{
+			uint8_t button = 0, action = 0;
+			complete = read(button) && read(action);
+			event.code = button;
+			event.action = action;
+			break;
+		}
+		case iCURSOR:
+			complete = read(event.x) && read(event.y);
+			break;
+		case iBRUSH:
+		{
+			uint32_t brush = 0, scale = 0;
+			float y_offset = 0;
+			complete = read(brush) && read(scale) && read(y_offset);
+			event.code = brush;
+			event.action = scale;
+			event.x = y_offset;
+			break;
+		}
+		case iFRAME:
+		{
+			float delta = 0;
+			complete = read(delta);
+			event.x = delta;
+			break;
+		}
+		case iSTEP:
+			steps++;
+			break;
+		default:
+			std::cerr << "Corrupt input recording (event type " << int(event.type) << ")" << std::endl;
+			complete = false;
+	}
+
+	if (!complete)
+	{
+		is_replaying = false;
+	}
+	return complete;
+}
+
+template <typename T>
+void Input_Recorder::write(T value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool Input_Recorder::read(T &value)
+{
+	if (cursor_pos + sizeof(T) > data.size())
+		return false;
+
+	memcpy(&value, data.data() + cursor_pos, sizeof(T));
+	cursor_pos += sizeof(T);
+	return true;
+}
@@ -0,0 +1,354 @@
+#include "../include/Job_System.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Failed searches for work before an idle worker goes to sleep
+#define JOB_IDLE_SPINS 64
+
+namespace
+{
+	// Chase-Lev deque over a fixed ring. Only the owning thread calls push / pop; any thread may steal.
+	// Every store to bottom is a release so a thief that sees a job also sees what was written into it
+	struct Job_Deque {
+		std::atomic<int64_t> top;
+		std::atomic<int64_t> bottom;
+		std::atomic<Job*> slots[JOB_DEQUE_SIZE];
+
+		Job_Deque() : top(0), bottom(0)
+		{
+			for (auto &slot : slots)
+				slot.store(nullptr, std::memory_order_relaxed);
+		}
+
+		bool push(Job* job)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= JOB_DEQUE_SIZE)
+				return false;
+
+			slots[b & (JOB_DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		Job* pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_release);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				bottom.store(b + 1, std::memory_order_release);
+				return nullptr;
+			}
+
+			Job* job = slots[b & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last job: a thief may be taking it at the same time
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					job = nullptr;
+				bottom.store(b + 1, std::memory_order_release);
+			}
+			return job;
+		}
+
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return nullptr;
+
+			Job* job = slots[t & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return job;
+		}
+	};
+
+	struct Thread_State {
+		Job_Deque deque;
+		Job jobs[JOB_POOL_SIZE];
+		uint32_t allocated;
+		uint32_t victim;	// Where the next steal attempt starts
+
+		Thread_State() : allocated(0), victim(0)
+		{
+			for (auto &job : jobs)
+			{
+				job.unfinished.store(0, std::memory_order_relaxed);
+				job.continuation_count.store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	// Slots [0, JOB_MAX_WORKERS) belong to workers, the rest to other threads as they first submit
+	std::atomic<Thread_State*> states[JOB_MAX_THREADS];
+	std::atomic<uint32_t> next_external(JOB_MAX_WORKERS);
+	std::mutex register_lock;
+	thread_local Thread_State* local_state = nullptr;
+
+	std::vector<std::thread> workers;
+	std::atomic<bool> workers_running(false);
+
+	// Jobs sitting in any deque; sleeping workers wake when it rises above zero
+	std::atomic<int32_t> queued(0);
+	std::atomic<uint32_t> sleeping(0);
+	std::mutex sleep_lock;
+	std::condition_variable sleep_signal;
+
+	Thread_State* this_thread_state()
+	{
+		if (local_state)
+			return local_state;
+
+		std::lock_guard<std::mutex> guard(register_lock);
+		uint32_t slot = next_external.load();
+		local_state = new Thread_State;
+		if (slot < JOB_MAX_THREADS)
+		{
+			states[slot].store(local_state, std::memory_order_release);
+			next_external.store(slot + 1);
+		}
+		else
+		{
+			// No slot left: this thread's jobs can't be stolen, it runs them itself in wait()
+			std::cerr << "Job_System: more than " << JOB_MAX_THREADS << " threads submitting jobs" << std::endl;
+		}
+		return local_state;
+	}
+
+	Job* find_job(Thread_State* state)
+	{
+		Job* job = state->deque.pop();
+		if (!job)
+		{
+			for (uint32_t attempt = 0; attempt < JOB_MAX_THREADS && !job; ++attempt)
+			{
+				Thread_State* victim = states[state->victim].load(std::memory_order_acquire);
+				state->victim = (state->victim + 1) % JOB_MAX_THREADS;
+				if (victim && victim != state)
+					job = victim->deque.steal();
+			}
+		}
+
+		if (job)
+			queued.fetch_sub(1);
+		return job;
+	}
+
+	void finish(Job* job)
+	{
+		// Read before the count drops: once it is zero the waiter may recycle the job
+		Job* parent = job->parent;
+		Job* continuations[JOB_MAX_CONTINUATIONS];
+		int32_t continuation_count = job->continuation_count.load(std::memory_order_relaxed);
+		std::copy(job->continuations, job->continuations + continuation_count, continuations);
+
+		if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		for (int32_t idx = 0; idx < continuation_count; ++idx)
+			Job_System::run(continuations[idx]);
+		if (parent)
+			finish(parent);
+	}
+
+	void execute(Job* job)
+	{
+		job->function(job, job->data);
+		finish(job);
+	}
+
+	void worker_loop(uint32_t slot)
+	{
+		local_state = states[slot].load(std::memory_order_acquire);
+		uint32_t idle = 0;
+
+		while (workers_running.load(std::memory_order_acquire))
+		{
+			Job* job = find_job(local_state);
+			if (job)
+			{
+				execute(job);
+				idle = 0;
+				continue;
+			}
+
+			if (++idle < JOB_IDLE_SPINS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// run() reads sleeping after raising queued, and we read queued after raising sleeping,
+			// so one of us always sees the other and no wake up is lost
+			std::unique_lock<std::mutex> guard(sleep_lock);
+			sleeping.fetch_add(1);
+			sleep_signal.wait(guard, []() { return queued.load() > 0 || !workers_running.load(); });
+			sleeping.fetch_sub(1);
+			idle = 0;
+		}
+	}
+
+	Job* allocate(Job_Function function, Job* parent, const void* data, size_t bytes)
+	{
+		Thread_State* state = this_thread_state();
+
+		// Take the next free job in the ring, skipping any still in flight (long lived parents such as a
+		// parallel_for root). If every one is busy, help out until one comes free
+		Job* job = nullptr;
+		while (!job)
+		{
+			for (uint32_t attempt = 0; attempt < JOB_POOL_SIZE && !job; ++attempt)
+			{
+				Job* candidate = &state->jobs[state->allocated++ & (JOB_POOL_SIZE - 1)];
+				if (candidate->unfinished.load(std::memory_order_acquire) == 0)
+					job = candidate;
+			}
+
+			if (!job)
+			{
+				Job* other = find_job(state);
+				if (other)
+					execute(other);
+				else
+					std::this_thread::yield();
+			}
+		}
+
+		if (bytes > JOB_DATA_SIZE)
+		{
+			std::cerr << "Job_System: " << bytes << " bytes of job data, the limit is " << JOB_DATA_SIZE << std::endl;
+			bytes = JOB_DATA_SIZE;
+		}
+
+		job->function = function;
+		job->parent = parent;
+		job->unfinished.store(1, std::memory_order_relaxed);
+		job->continuation_count.store(0, std::memory_order_relaxed);
+		if (data && bytes)
+			memcpy(job->data, data, bytes);
+		return job;
+	}
+}
+
+void Job_System::start(uint32_t worker_count)
+{
+	if (workers_running.load())
+		return;
+
+	if (worker_count == 0)
+		worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	worker_count = std::min<uint32_t>(worker_count, JOB_MAX_WORKERS);
+
+	// The starting thread takes part in wait(), so make its deque stealable before anything runs
+	this_thread_state();
+
+	workers_running.store(true);
+	for (uint32_t slot = 0; slot < worker_count; ++slot)
+	{
+		if (!states[slot].load())
+			states[slot].store(new Thread_State, std::memory_order_release);
+		workers.push_back(std::thread(worker_loop, slot));
+	}
+}
+
+void Job_System::stop()
+{
+	if (!workers_running.load())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock);
+		workers_running.store(false);
+	}
+	sleep_signal.notify_all();
+
+	for (auto &worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+bool Job_System::running()
+{
+	return workers_running.load(std::memory_order_relaxed);
+}
+
+uint32_t Job_System::thread_count()
+{
+	return static_cast<uint32_t>(workers.size()) + 1;
+}
+
+Job* Job_System::create(Job_Function function, const void* data, size_t bytes)
+{
+	return allocate(function, nullptr, data, bytes);
+}
+
+Job* Job_System::create_child(Job* parent, Job_Function function, const void* data, size_t bytes)
+{
+	parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+	return allocate(function, parent, data, bytes);
+}
+
+bool Job_System::add_continuation(Job* job, Job* continuation)
+{
+	int32_t count = job->continuation_count.load(std::memory_order_relaxed);
+	if (count >= JOB_MAX_CONTINUATIONS)
+	{
+		std::cerr << "Job_System: more than " << JOB_MAX_CONTINUATIONS << " continuations on one job" << std::endl;
+		return false;
+	}
+
+	job->continuations[count] = continuation;
+	job->continuation_count.store(count + 1, std::memory_order_relaxed);
+	return true;
+}
+
+void Job_System::run(Job* job)
+{
+	Thread_State* state = this_thread_state();
+
+	queued.fetch_add(1);
+	if (!state->deque.push(job))
+	{
+		// Deque full: do it now rather than drop it
+		queued.fetch_sub(1);
+		execute(job);
+		return;
+	}
+
+	if (sleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock);
+		sleep_signal.notify_one();
+	}
+}
+
+void Job_System::wait(Job* job)
+{
+	Thread_State* state = this_thread_state();
+	while (!finished(job))
+	{
+		Job* other = find_job(state);
+		if (other)
+			execute(other);
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool Job_System::finished(const Job* job)
+{
+	return job->unfinished.load(std::memory_order_acquire) == 0;
+}
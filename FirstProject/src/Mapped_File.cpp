@@ -0,0 +1,123 @@
+#include "../include/Mapped_File.h"
+
+#include <iostream>
+
+#if _WIN32 || _WIN64
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+Mapped_File::Mapped_File()
+{
+	m_data = nullptr;
+	m_size = 0;
+#if _WIN32 || _WIN64
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#endif
+}
+
+Mapped_File::~Mapped_File()
+{
+	close();
+}
+
+bool Mapped_File::open(const std::string &file_name)
+{
+	close();
+
+#if _WIN32 || _WIN64
+	m_file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Unable to open file: " << file_name << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		std::cerr << "Unable to map empty file: " << file_name << std::endl;
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping)
+		m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_data)
+	{
+		std::cerr << "Unable to map file: " << file_name << std::endl;
+		close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = ::open(file_name.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		std::cerr << "Unable to open file: " << file_name << std::endl;
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		std::cerr << "Unable to map empty file: " << file_name << std::endl;
+		::close(file);
+		return false;
+	}
+
+	// The mapping keeps the file referenced, so the descriptor can go straight away
+	void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (mapped == MAP_FAILED)
+	{
+		std::cerr << "Unable to map file: " << file_name << std::endl;
+		return false;
+	}
+	m_data = static_cast<const unsigned char*>(mapped);
+	m_size = static_cast<size_t>(info.st_size);
+#endif
+
+	return true;
+}
+
+void Mapped_File::close()
+{
+#if _WIN32 || _WIN64
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool Mapped_File::is_open()
+{
+	return m_data != nullptr;
+}
+
+const unsigned char* Mapped_File::data()
+{
+	return m_data;
+}
+
+size_t Mapped_File::size()
+{
+	return m_size;
+}
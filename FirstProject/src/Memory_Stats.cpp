@@ -0,0 +1,99 @@
+#include "../include/Memory_Stats.h"
+#include "../include/Resource_Manager.h"
+
+static const char* CATEGORY_NAMES[MEMORY_CATEGORIES] = {
+	"Mesh_Buffers",
+	"Heightmap_Buffers",
+	"Textures",
+	"Skybox",
+	"Mesh_Geometry",
+	"Heightmap_Image"
+};
+
+static const bool CATEGORY_ON_GPU[MEMORY_CATEGORIES] = {
+	true,
+	true,
+	true,
+	true,
+	false,
+	false
+};
+
+std::atomic<uint64_t> Memory_Stats::bytes[MEMORY_CATEGORIES];
+std::atomic<uint64_t> Memory_Stats::peak_bytes[MEMORY_CATEGORIES];
+
+void Memory_Stats::allocate(uint32_t category, uint64_t size)
+{
+	if (category >= MEMORY_CATEGORIES || size == 0)
+		return;
+
+	uint64_t now = bytes[category].fetch_add(size) + size;
+	uint64_t highest = peak_bytes[category].load();
+	while (now > highest && !peak_bytes[category].compare_exchange_weak(highest, now))
+	{
+	}
+}
+
+void Memory_Stats::release(uint32_t category, uint64_t size)
+{
+	if (category >= MEMORY_CATEGORIES || size == 0)
+		return;
+
+	bytes[category].fetch_sub(size);
+}
+
+uint64_t Memory_Stats::current(uint32_t category)
+{
+	return category < MEMORY_CATEGORIES ? bytes[category].load() : 0;
+}
+
+uint64_t Memory_Stats::peak(uint32_t category)
+{
+	return category < MEMORY_CATEGORIES ? peak_bytes[category].load() : 0;
+}
+
+uint64_t Memory_Stats::gpu_bytes()
+{
+	uint64_t total = 0;
+	for (uint32_t category = 0; category < MEMORY_CATEGORIES; ++category)
+	{
+		if (CATEGORY_ON_GPU[category])
+			total += bytes[category].load();
+	}
+	return total;
+}
+
+uint64_t Memory_Stats::cpu_bytes()
+{
+	uint64_t total = 0;
+	for (uint32_t category = 0; category < MEMORY_CATEGORIES; ++category)
+	{
+		if (!CATEGORY_ON_GPU[category])
+			total += bytes[category].load();
+	}
+	return total;
+}
+
+const char* Memory_Stats::name(uint32_t category)
+{
+	return category < MEMORY_CATEGORIES ? CATEGORY_NAMES[category] : "Unknown";
+}
+
+bool Memory_Stats::on_gpu(uint32_t category)
+{
+	return category < MEMORY_CATEGORIES && CATEGORY_ON_GPU[category];
+}
+
+std::string Memory_Stats::report()
+{
+	std::string report;
+	for (uint32_t category = 0; category < MEMORY_CATEGORIES; ++category)
+	{
+		report += "\t" + std::string(CATEGORY_NAMES[category]);
+		report += CATEGORY_ON_GPU[category] ? "\tGPU\t" : "\tCPU\t";
+		report += format_bytes(current(category)) + "\tpeak " + format_bytes(peak(category)) + "\n";
+	}
+	report += "\tTotal\tGPU\t" + format_bytes(gpu_bytes()) + "\n";
+	report += "\tTotal\tCPU\t" + format_bytes(cpu_bytes()) + "\n";
+	return report;
+}
@@ -1,16 +1,86 @@
 #include "../include/Mesh.h"
+#include "../include/Profiler.h"
+#include "../include/Render_Stats.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Arena.h"
+#include "../include/Texture_Arrays.h"
+#include "../include/Content_Hash.h"
+#include "../include/Image_Decoder.h"
+#include "../include/VFS.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../include/stb_image.h"
 
-Mesh::Mesh(std::string filename, loadedComponents* scene_tracker, std::string base_dir)
+bool Mesh::keep_geometry = true;
+
+// Host bytes held by tinyobj's parse of an .obj (materials excluded: draws read them)
+static uint64_t geometry_bytes(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes)
+{
+	uint64_t bytes = (attrib.vertices.size() + attrib.normals.size() + attrib.texcoords.size()) * sizeof(tinyobj::real_t);
+	for (auto &shape : shapes)
+	{
+		bytes += shape.mesh.indices.size() * sizeof(tinyobj::index_t) +
+			shape.mesh.num_face_vertices.size() * sizeof(unsigned char) +
+			shape.mesh.material_ids.size() * sizeof(int);
+	}
+	return bytes;
+}
+
+// tinyobj's MaterialFileReader, but the .mtl comes through the VFS so it can be packed
+class VFS_Material_Reader : public tinyobj::MaterialReader {
+public:
+	explicit VFS_Material_Reader(const std::string &base_dir) : m_base_dir(base_dir) {}
+
+	bool operator()(const std::string &matId, std::vector<tinyobj::material_t> *materials,
+		std::map<std::string, int> *matMap, std::string *err) override
+	{
+		std::string file_name = m_base_dir + matId;
+		File_View file;
+		if (!VFS::open(file_name, file))
+		{
+			if (err)
+				*err += "WARN: Material file [ " + file_name + " ] not found.\n";
+			return false;
+		}
+
+		View_Stream stream(file);
+		std::string warning;
+		tinyobj::LoadMtl(matMap, materials, &stream, &warning);
+		if (err)
+			*err += warning;
+		return true;
+	}
+
+private:
+	std::string m_base_dir;
+};
+
+Mesh::Mesh(std::string filename, Resource_Manager* scene_tracker, std::string base_dir)
 {
+	PROFILE_SCOPE("Mesh::Mesh");
 	this->name = filename;
+	this->id = String_Table::intern(filename);
 	this->scene_tracker = scene_tracker;
+	this->gpu_bytes = 0;
+	this->cpu_bytes = 0;
+	this->gathering_textures = nullptr;
 
 	std::string err;
 
-	tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename.c_str(), base_dir.c_str());
+	// Parsed straight out of the mapped (or packed) file
+	File_View file;
+	if (VFS::open(filename, file))
+	{
+		View_Stream stream(file);
+		VFS_Material_Reader material_reader(base_dir);
+		tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream, &material_reader);
+	}
+	else
+	{
+		err = "Cannot open file [" + filename + "]\n";
+	}
+	cpu_bytes = geometry_bytes(attrib, shapes);
+	Memory_Stats::allocate(mMESH_GEOMETRY, cpu_bytes);
 
 	if (!err.empty())
 	{
@@ -31,63 +101,47 @@ Mesh::Mesh(std::string filename, loadedComponents* scene_tracker, std::string ba
 
 	setupMesh();
 	setupTextures(base_dir);
+	resolveTextures();
 	generateTransform();
 	compute_bounds();
+	if (!keep_geometry)
+		dropGeometry();
 	std::cerr << "Mesh Loaded: " << filename << "\n" << std::endl;
 	std::cerr << "Mesh Bounds: (" << m_lower_bounds.x << ", " << m_lower_bounds.y << ", " << m_lower_bounds.z << ") - (" << m_upper_bounds.x << ", " << m_upper_bounds.y << ", " << m_upper_bounds.z << ")\n" << std::endl;
 }
 
 Mesh::~Mesh()
 {
+	for (auto &object : objects)
+	{
+		glDeleteBuffers(6, object.vb);
+		glDeleteVertexArrays(1, &object.va);
+	}
+	Memory_Stats::release(mMESH_BUFFERS, gpu_bytes);
+	Memory_Stats::release(mMESH_GEOMETRY, cpu_bytes);
+
+	// Textures are only deleted once the last mesh (or heightmap) using them lets go
+	for (auto &texture : texture_handles)
+	{
+		scene_tracker->Textures.release(texture, id);
+	}
 }
 
 void Mesh::draw(GLuint shader)
 {
 
-	for (const auto object : objects)
+	for (const auto &object : objects)
 	{
 		if ((object.material_id < materials.size())) {
 			// -- Texture Uniforms --
-			std::string loc_str = "material[0]";
-
-			// Load diffuse texture
-			glActiveTexture(GL_TEXTURE0);
-			std::string diffuse_texname = materials.at(object.material_id).diffuse_texname;
-			if (scene_tracker->Textures->find(diffuse_texname) != scene_tracker->Textures->end()) {
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(diffuse_texname).first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".diffuse").c_str()), 0);
-			}
-			else
-			{
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default.png").first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".diffuse").c_str()), 0);
-			}
-
-			// Load specular texture
-			glActiveTexture(GL_TEXTURE1);
-			std::string specular_texname = materials.at(object.material_id).specular_texname;
-			if (scene_tracker->Textures->find(specular_texname) != scene_tracker->Textures->end()) {
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(specular_texname).first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".specular").c_str()), 1);
-			}
-			else
-			{
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default.png").first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".specular").c_str()), 1);
-			}
-
-			// Load normal texture
-			glActiveTexture(GL_TEXTURE2);
-			std::string normal_texname = materials.at(object.material_id).normal_texname;
-			if (scene_tracker->Textures->find(normal_texname) != scene_tracker->Textures->end()) {
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at(normal_texname).first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".normal").c_str()), 2);
-			}
-			else
-			{
-				glBindTexture(GL_TEXTURE_2D, scene_tracker->Textures->at("_default_black.png").first);
-				glUniform1i(glGetUniformLocation(shader, (loc_str + ".normal").c_str()), 2);
-			}
+			// Materials whose maps share arrays only change the layers (samplers are fixed to their units)
+			const Material_Textures &textures = material_textures[object.material_id];
+			GLint layers[MATERIAL_TEXTURE_MAPS] = {
+				Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(0, 0), textures.diffuse),
+				Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(0, 1), textures.specular),
+				Texture_Arrays::bind(MATERIAL_TEXTURE_UNIT(0, 2), textures.normal)
+			};
+			glUniform3iv(glGetUniformLocation(shader, "material[0].layers"), 1, layers);
 
 			// -- Material Uniforms --
 
@@ -102,22 +156,23 @@ void Mesh::draw(GLuint shader)
 		}
 
 
-		// Mesh Uniforms
-		GLuint modelLoc = glGetUniformLocation(shader, "model");
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
-
 		glBindVertexArray(object.va);
 		glDrawArrays(GL_TRIANGLES, 0, object.numTriangles * 3);
+		Render_Stats::draw(object.numTriangles * 3);
 
 		// Clean up
 		GLuint loaded = glGetUniformLocation(shader, "material[0].loaded");
 		glUniform1f(loaded, false);
 		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 
 }
 
+glm::mat4 Mesh::get_transform()
+{
+	return m_transform;
+}
+
 glm::vec3 Mesh::get_lower_bounds()
 {
 	return m_lower_bounds;
@@ -128,64 +183,71 @@ glm::vec3 Mesh::get_upper_bounds()
 	return m_upper_bounds;
 }
 
-std::string Mesh::get_scale()
+uint64_t Mesh::get_gpu_bytes()
 {
-	return std::to_string(scale);
+	return gpu_bytes;
 }
 
-void Mesh::remove_instance()
+uint64_t Mesh::get_cpu_bytes()
 {
-	for (size_t m = 0; m < materials.size(); m++) {
-		tinyobj::material_t* mp = &materials.at(m);
-
-		if (mp->ambient_texname.length() > 0)
-			scene_tracker->Textures->at(mp->ambient_texname).second--;
-
-		if (mp->diffuse_texname.length() > 0)
-			scene_tracker->Textures->at(mp->diffuse_texname).second--;
-
-		if (mp->specular_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->specular_texname).second;
-
-		if (mp->specular_highlight_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->specular_highlight_texname).second;
-
-		if (mp->bump_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->bump_texname).second;
-
-		if (mp->displacement_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->displacement_texname).second;
+	return cpu_bytes;
+}
 
-		if (mp->alpha_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->alpha_texname).second;
+void Mesh::keep_cpu_geometry(bool keep)
+{
+	keep_geometry = keep;
+}
 
+bool Mesh::keeps_cpu_geometry()
+{
+	return keep_geometry;
+}
 
-		if (mp->roughness_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->roughness_texname).second;
+void Mesh::dropGeometry()
+{
+	// Swap with empties: clear() alone keeps the capacity
+	std::vector<tinyobj::real_t>().swap(attrib.vertices);
+	std::vector<tinyobj::real_t>().swap(attrib.normals);
+	std::vector<tinyobj::real_t>().swap(attrib.texcoords);
+	std::vector<tinyobj::shape_t>().swap(shapes);
+
+	Memory_Stats::release(mMESH_GEOMETRY, cpu_bytes);
+	cpu_bytes = 0;
+}
 
-		if (mp->metallic_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->metallic_texname).second;
-		if (mp->sheen_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->sheen_texname).second;
-		if (mp->emissive_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->emissive_texname).second;
-		if (mp->normal_texname.length() > 0)
-			--scene_tracker->Textures->at(mp->normal_texname).second;
-	}
-	--scene_tracker->Meshes->at(name).second;
+std::string Mesh::get_scale()
+{
+	return std::to_string(scale);
 }
 
 void Mesh::setupMesh()
 {
+	PROFILE_SCOPE("Mesh::setupMesh");
+	// Staging buffers live in a load arena that is rewound for every shape, so after the first shape
+	// building vertex data makes no heap allocations
+	Arena load_arena;
+	Arena_Allocator<glm::vec3> vec3_allocator(&load_arena);
+	Arena_Allocator<glm::vec2> vec2_allocator(&load_arena);
+
 	for (size_t s = 0; s < shapes.size(); s++) {
+		load_arena.reset();
 		DrawObject o;
-		std::vector<glm::vec3> vb_pos;  // Buffer for Position
-		std::vector<glm::vec3> vb_norm;  // Buffer for Normal
-		std::vector<glm::vec3> vb_col;  // Buffer for Color
-		std::vector<glm::vec2> vb_tex;	// Buffer for Texture Coords
-
-		std::vector<glm::vec3> vb_tan;  // Buffer for Tangent
-		std::vector<glm::vec3> vb_bitan;  // Buffer for Bitangent
+		Arena_Vector<glm::vec3> vb_pos(vec3_allocator);  // Buffer for Position
+		Arena_Vector<glm::vec3> vb_norm(vec3_allocator);  // Buffer for Normal
+		Arena_Vector<glm::vec3> vb_col(vec3_allocator);  // Buffer for Color
+		Arena_Vector<glm::vec2> vb_tex(vec2_allocator);	// Buffer for Texture Coords
+
+		Arena_Vector<glm::vec3> vb_tan(vec3_allocator);  // Buffer for Tangent
+		Arena_Vector<glm::vec3> vb_bitan(vec3_allocator);  // Buffer for Bitangent
+
+		// One vertex per index; reserving keeps growth from leaving dead copies in the arena
+		size_t vertex_count = shapes.at(s).mesh.indices.size();
+		vb_pos.reserve(vertex_count);
+		vb_norm.reserve(vertex_count);
+		vb_col.reserve(vertex_count);
+		vb_tex.reserve(vertex_count);
+		vb_tan.reserve(vertex_count);
+		vb_bitan.reserve(vertex_count);
 
 		for (size_t f = 0; f < shapes.at(s).mesh.indices.size() / 3; f++) {
 			tinyobj::index_t idx0 = shapes.at(s).mesh.indices[3 * f + 0];
@@ -374,11 +436,15 @@ void Mesh::setupMesh()
 		glBindBuffer(GL_ARRAY_BUFFER, 0); // Unbind Buffer Object
 
 		o.numTriangles = vb_pos.size() / 3;
+		gpu_bytes += (vb_pos.size() + vb_norm.size() + vb_col.size() + vb_tan.size() + vb_bitan.size()) * sizeof(glm::vec3) +
+			vb_tex.size() * sizeof(glm::vec2);
 		printf("shape[%d] # of triangles = %d\n", static_cast<int>(s),
 				o.numTriangles);
 		objects.push_back(o);
 	}
 
+	Memory_Stats::allocate(mMESH_BUFFERS, gpu_bytes);
+
 	for (unsigned int axis = 0; axis < 3; axis++)
 	{
 		float diff = fabs(bounding_maximum[axis] - bounding_minimum[axis]);
@@ -395,8 +461,29 @@ void Mesh::setupMesh()
 	);
 }
 
+// Where a material's texture is: as named, ./Materials/ for the default, otherwise next to the material.
+// Empty if it is in none of them
+static std::string texture_path(const std::string &base_dir, const std::string &texture_name)
+{
+	if (VFS::exists(texture_name))
+		return texture_name;
+
+	// If desired, grab the default material (from it's default location)
+	std::string texture_filename;
+	if (texture_name == "_default.png")
+		texture_filename = "./Materials/" + texture_name;
+	else // Append base dir.
+		texture_filename = base_dir + texture_name;
+
+	return VFS::exists(texture_filename) ? texture_filename : "";
+}
+
 void Mesh::setupTextures(std::string base_dir)
 {
+	PROFILE_SCOPE("Mesh::setupTextures");
+	// Gather every texture first, so the ones missing from the cache are cooked on the workers together
+	std::vector<std::pair<std::string, Texture_Usage>> textures;
+	gathering_textures = &textures;
 	for (size_t m = 0; m < materials.size(); m++) {
 		tinyobj::material_t* mp = &materials.at(m);
 
@@ -435,61 +522,85 @@ void Mesh::setupTextures(std::string base_dir)
 		if (mp->normal_texname.length() > 0)
 		{
 			std::cout << "Loading Normal Map (norm): " << mp->normal_texname << "\n";
-			loadTexture(base_dir, mp->normal_texname);
+			loadTexture(base_dir, mp->normal_texname, TEXTURE_NORMAL);
 		}
 	}
-}
+	gathering_textures = nullptr;
 
-void Mesh::loadTexture(std::string base_dir, std::string texture_name)
-{
-	// Only load the texture if it is not already loaded
-	if (scene_tracker->Textures->find(texture_name) == scene_tracker->Textures->end()) {
-		GLuint texture_id;
-		int w, h;
-		int comp;
+	std::vector<std::pair<std::string, Texture_Usage>> files;
+	for (const auto &texture : textures)
+	{
+		std::string texture_filename = texture_path(base_dir, texture.first);
+		if (!texture_filename.empty() && !scene_tracker->Textures.valid(scene_tracker->Textures.find(String_Table::intern(texture.first))))
+			files.push_back(std::make_pair(texture_filename, texture.second));
+	}
+	Image_Decoder::prepare_all(files);
 
-		std::string texture_filename = texture_name;
+	for (const auto &texture : textures)
+		loadTexture(base_dir, texture.first, texture.second);
+}
 
-		if (!FileExists(texture_filename)) {
+void Mesh::loadTexture(std::string base_dir, std::string texture_name, Texture_Usage usage)
+{
+	if (gathering_textures)
+	{
+		gathering_textures->push_back(std::make_pair(texture_name, usage));
+		return;
+	}
+	String_ID texture_key = String_Table::intern(texture_name);
 
-			// If desired, grab the default material (from it's default location)
-			if (texture_filename == "_default.png")
-				texture_filename = "./Materials/" + texture_name;
-			else // Append base dir.
-				texture_filename = base_dir + texture_name;
+	// Only load the texture if it is not already loaded
+	Texture_Handle texture = scene_tracker->Textures.find(texture_key);
+	if (!scene_tracker->Textures.acquire(texture, id)) {
+		Texture_Slot texture_slot;
+		std::string texture_filename = texture_path(base_dir, texture_name);
+		if (texture_filename.empty()) {
+			std::cerr << "Unable to find file: " << texture_name << std::endl;
+			exit(1);
+		}
 
-			if (!FileExists(texture_filename)) {
-				std::cerr << "Unable to find file: " << texture_name << std::endl;
+		// A copy of an image already loaded under another name shares that texture
+		uint64_t contents = file_content_hash(texture_filename, usage);
+		texture = scene_tracker->share_texture(texture_key, contents, id);
+		if (!scene_tracker->Textures.valid(texture)) {
+			// Mipmapped, block compressed copy of the image (cooked on first use); the larger levels stream in over
+			// the next frames, then it is packed into an array with the scene's other textures of its size
+			Texture_Info texture_info;
+			texture_slot = Texture_Arrays::load(texture_filename, usage, &texture_info);
+			if (!texture_slot) {
+				std::cerr << "Unable to load texture: " << texture_filename << std::endl;
 				exit(1);
 			}
-		}
 
-		unsigned char* image = stbi_load(texture_filename.c_str(), &w, &h, &comp, STBI_default);
-		if (!image) {
-			std::cerr << "Unable to load texture: " << texture_filename << std::endl;
-			exit(1);
+			Texture_Resource resource = { 0, texture_slot, texture_info };
+			texture = scene_tracker->Textures.add(texture_key, resource, texture_info.gpu_bytes, id);
+			scene_tracker->add_texture_contents(contents, texture);
 		}
-
-		glGenTextures(1, &texture_id);
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		if (comp == 3) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		}
-		else if (comp == 4) {
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		}
-		glBindTexture(GL_TEXTURE_2D, 0);
-		stbi_image_free(image);
-
-		scene_tracker->Textures->insert(std::make_pair(texture_name, std::make_pair(texture_id, 1)));
 	}
-	else {
-		scene_tracker->Textures->at(texture_name).second++;
+	texture_handles.push_back(texture);
+}
+
+void Mesh::resolveTextures()
+{
+	material_textures.resize(materials.size());
+	for (size_t m = 0; m < materials.size(); m++) {
+		material_textures[m].diffuse = resolveTexture(materials[m].diffuse_texname, SID("_default.png"));
+		material_textures[m].specular = resolveTexture(materials[m].specular_texname, SID("_default.png"));
+		material_textures[m].normal = resolveTexture(materials[m].normal_texname, SID("_default_black.png"));
 	}
 }
 
+Texture_Slot Mesh::resolveTexture(const std::string &texture_name, String_ID fallback)
+{
+	Texture_Slot texture = 0;
+	if (texture_name.length() > 0)
+		texture = scene_tracker->Textures.get(scene_tracker->Textures.find(String_Table::intern(texture_name))).slot;
+	if (!texture)
+		texture = scene_tracker->Textures.get(scene_tracker->Textures.find(fallback)).slot;
+
+	return texture;
+}
+
 void Mesh::generateTransform()
 {
 	m_transform = glm::mat4();
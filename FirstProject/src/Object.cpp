@@ -1,16 +1,13 @@
 #include "../include/Object.h"
+#include "../include/VFS.h"
 #include <algorithm>
 #include <limits>
 
-Object::Object(std::string name, std::string cmesh_details, loadedComponents* scene_tracker)
+Object::Object(std::string name, std::string cmesh_details, Resource_Manager* scene_tracker)
 {
-	glm::vec3 rotation;
-	this->m_location = new glm::vec3;
-	this->m_scale = new glm::vec3;
+	glm::vec3 rotation, location, scale;
 	this->scene_tracker = scene_tracker;
 
-	components = new std::map<std::string, Component*>;
-
 	m_name = name;
 
 	// 'Static_Name' COMPLEX_FILE scale.x scale.y scale.z loc.x loc.y loc.z rot.x rot.y rot.z // World
@@ -19,64 +16,72 @@ Object::Object(std::string name, std::string cmesh_details, loadedComponents* sc
 	std::istringstream iss(cmesh_details);
 
 	iss >> m_name >> m_file_name >>
-		m_scale->x >> m_scale->y >> m_scale->z >>
-		m_location->x >> m_location->y >> m_location->z >>
+		scale.x >> scale.y >> scale.z >>
+		location.x >> location.y >> location.z >>
 		rotation.x >> rotation.y >> rotation.z;
 
 	std::cout << "Loading: " << m_name << " (" << m_file_name << ")" << std::endl;
-	std::cout << "\tScale: " << m_scale->x << " " << m_scale->y << " " << m_scale->z << std::endl;
-	std::cout << "\tLocation: " << m_location->x << " " << m_location->y << " " << m_location->z << std::endl;
+	std::cout << "\tScale: " << scale.x << " " << scale.y << " " << scale.z << std::endl;
+	std::cout << "\tLocation: " << location.x << " " << location.y << " " << location.z << std::endl;
 	std::cout << "\tRotation: " << rotation.x << " " << rotation.y << " " << rotation.z << std::endl;
 
-	m_rotation = new glm::quat(rotation);
+	m_handle = scene_tracker->Transforms->create(location, glm::quat(rotation), scale);
+	load_components(m_file_name);
 
-	std::ifstream fb; // FileBuffer
-	fb.open((m_file_name), std::ios::in);
-	std::string LineBuf, component_name;
-	std::stringstream ss;
+	build_static_transform();
+	computer_bounds();
+	std::cerr << "Object Bounds: " << report_bounds() << "\n" << std::endl;
+}
 
+Object::Object(std::string name, std::string object_file_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, Resource_Manager * scene_tracker)
+{
+	this->m_name = name;
+	this->m_file_name = object_file_name;
+	this->scene_tracker = scene_tracker;
+	this->m_handle = scene_tracker->Transforms->create(loc, rot, scale);
 
-	if (fb.is_open()) {
-		while (std::getline(fb, LineBuf))
-		{
-			// Get component name
-			ss.clear();
-			ss.str(LineBuf);
-			std::getline(ss, component_name, ' ');
+	load_components(object_file_name);
 
-			// Create component
-			components->operator[](component_name) = new Component(component_name, LineBuf, scene_tracker);
-		}
-	}
-	else
+	build_static_transform();
+	computer_bounds();
+}
+
+Object::Object(const Object &prototype, std::string name, glm::quat rot, glm::vec3 loc, glm::vec3 scale)
+{
+	this->m_name = name;
+	this->m_file_name = prototype.m_file_name;
+	this->scene_tracker = prototype.scene_tracker;
+	this->m_handle = scene_tracker->Transforms->create(loc, rot, scale);
+
+	components.reserve(prototype.components.size());
+	for (auto &component : prototype.components)
 	{
-		std::cerr << "ERROR: " << m_file_name << " Failed to open.\n";
+		add_component(component.name, scene_tracker->Components->create(*component.component));
 	}
-	fb.close();
 
 	build_static_transform();
 	computer_bounds();
-	std::cerr << "Object Bounds: (" << m_lower_bounds.x << ", " << m_lower_bounds.y << ", " << m_lower_bounds.z << ") - (" << m_upper_bounds.x << ", " << m_upper_bounds.y << ", " << m_upper_bounds.z << ")\n" << std::endl;
 }
 
-Object::Object(std::string object_file_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, loadedComponents * scene_tracker)
+Object::~Object()
 {
-	this->m_name = "Object";
-	this->m_file_name = object_file_name;
-	this->m_rotation = new glm::quat(rot);
-	this->m_location = new glm::vec3(loc);
-	this->m_scale = new glm::vec3(scale);
-	this->scene_tracker = scene_tracker;
-
-	components = new std::map<std::string, Component*>;
+	for (auto &component : components)
+	{
+		scene_tracker->Components->destroy(component.handle);
+	}
+	components.clear();
+	scene_tracker->Transforms->destroy(m_handle);
+}
 
-	std::ifstream fb; // FileBuffer
-	fb.open((object_file_name), std::ios::in);
+void Object::load_components(std::string object_file_name)
+{
+	File_View file;
 	std::string LineBuf, component_name;
 	std::stringstream ss;
 
 
-	if (fb.is_open()) {
+	if (VFS::open(object_file_name, file)) {
+		View_Stream fb(file); // FileBuffer
 		while (std::getline(fb, LineBuf))
 		{
 			// Get component name
@@ -84,80 +89,103 @@ Object::Object(std::string object_file_name, glm::quat rot, glm::vec3 loc, glm::
 			ss.str(LineBuf);
 			std::getline(ss, component_name, ' ');
 
-			// Create component
-			components->operator[](component_name) = new Component(component_name, LineBuf, scene_tracker);
+			// Create component (a repeated name replaces the earlier one, as the old map did)
+			String_ID name = String_Table::intern(component_name);
+			remComponent(component_name);
+			add_component(name, scene_tracker->Components->create(component_name, LineBuf, scene_tracker));
 		}
 	}
 	else
 	{
 		std::cerr << "ERROR: " << object_file_name << " Failed to open.\n";
 	}
-	fb.close();
+}
 
-	build_static_transform();
-	computer_bounds();
+void Object::add_component(String_ID name, Component_Handle handle)
+{
+	Object_Component component = { name, handle, scene_tracker->Components->get(handle) };
+	component.component->set_parent(m_handle);
+	components.push_back(component);
 }
 
-Object::~Object()
+Object_Component* Object::find_component(String_ID name)
 {
-	for (auto &component : *components)
+	for (auto &component : components)
 	{
-		delete component.second;
+		if (component.name == name)
+			return &component;
 	}
-	components->clear();
-	delete components;
-	delete m_location;
-	delete m_scale;
-	delete m_rotation;
+	return nullptr;
 }
 
 void Object::addComponent(std::string name, std::string mesh_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale)
 {
-	if(components->find(name) == components->end())
-		components->operator[](name) = new Component(name, mesh_name, rot, loc, scale, scene_tracker);
+	String_ID id = String_Table::intern(name);
+	if (!find_component(id))
+	{
+		add_component(id, scene_tracker->Components->create(name, mesh_name, rot, loc, scale, scene_tracker));
+	}
 }
 
 void Object::remComponent(std::string name)
 {
-	if (components->find(name) != components->end())
+	Object_Component* component = find_component(String_Table::intern(name));
+	if (component)
 	{
-		delete components->at(name);
-		components->erase(name);
+		scene_tracker->Components->destroy(component->handle);
+		components.erase(components.begin() + (component - components.data()));
 	}
 }
 
-void Object::draw(GLuint shader)
+void Object::snapshot(std::vector<Draw_Item> &draw_list)
 {
-	//std::cout << "Object::Draw\n";
-	GLuint objLoc = glGetUniformLocation(shader, "object");
-	glUniformMatrix4fv(objLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
-
-	for (auto component : *components)
+	for (auto &component : components)
 	{
-		component.second->draw(shader);
+		component.component->snapshot(draw_list);
 	}
 }
 
-glm::vec3 * Object::getLocation()
+glm::vec3 Object::getLocation()
+{
+	return scene_tracker->Transforms->location(m_handle);
+}
+
+void Object::setLocation(glm::vec3 location)
+{
+	scene_tracker->Transforms->set_location(m_handle, location);
+	transform_changed();
+}
+
+void Object::setRotation(glm::quat rotation)
+{
+	scene_tracker->Transforms->set_rotation(m_handle, rotation);
+	transform_changed();
+}
+
+void Object::setScale(glm::vec3 scale)
 {
-	return this->m_location;
+	scene_tracker->Transforms->set_scale(m_handle, scale);
+	transform_changed();
 }
 
 glm::vec3 Object::get_lower_bounds()
 {
-	return m_lower_bounds;
+	return scene_tracker->Transforms->lower_bounds(m_handle);
 
 }
 
 glm::vec3 Object::get_upper_bounds()
 {
-	return m_upper_bounds;
+	return scene_tracker->Transforms->upper_bounds(m_handle);
 }
 
 std::string Object::report_bounds()
 {
-	std::string report = "[" + std::to_string(m_lower_bounds.x) + ":" + std::to_string(m_lower_bounds.y) + ":" + std::to_string(m_lower_bounds.z) +
-		"]-[" + std::to_string(m_upper_bounds.x) + ":" + std::to_string(m_upper_bounds.y) + ":" + std::to_string(m_upper_bounds.z) + "]";
+	glm::vec3 lower = get_lower_bounds();
+	glm::vec3 upper = get_upper_bounds();
+
+	std::string report = "[" + std::to_string(lower.x) + ":" + std::to_string(lower.y) + ":" + std::to_string(lower.z) +
+		"]-[" + std::to_string(upper.x) + ":" + std::to_string(upper.y) + ":" + std::to_string(upper.z) + "]";
 
 	return report;
 }
@@ -165,11 +193,12 @@ std::string Object::report_bounds()
 bool Object::is_collision(glm::vec3 lower_bound, glm::vec3 upper_bound)
 {
 
-	if (collision_check(lower_bound, upper_bound, m_lower_bounds, m_upper_bounds))
+	if (collision_check(lower_bound, upper_bound, get_lower_bounds(), get_upper_bounds()))
 	{
-		for (auto &component : *components)
+		glm::mat4 transform = scene_tracker->Transforms->matrix(m_handle);
+		for (auto &component : components)
 		{
-			if (component.second->is_collision(lower_bound, upper_bound, m_transform))
+			if (component.component->is_collision(lower_bound, upper_bound, transform))
 			{
 				return true;
 			}
@@ -180,64 +209,85 @@ bool Object::is_collision(glm::vec3 lower_bound, glm::vec3 upper_bound)
 
 }
 
+std::string Object::get_name()
+{
+	return m_name;
+}
+
+std::string Object::get_file_name()
+{
+	return m_file_name;
+}
+
 std::string Object::report()
 {
+	glm::quat rotation = scene_tracker->Transforms->rotation(m_handle);
+	glm::vec3 scale = scene_tracker->Transforms->scale(m_handle);
+	glm::vec3 location = scene_tracker->Transforms->location(m_handle);
 
 	glm::vec3 rot;
-	rot.y = asin(-2.0*(m_rotation->x*m_rotation->z - m_rotation->w*m_rotation->y));
-	rot.x = atan2(2.0*(m_rotation->y*m_rotation->z + m_rotation->w*m_rotation->x), m_rotation->w*m_rotation->w - m_rotation->x*m_rotation->x - m_rotation->y*m_rotation->y + m_rotation->z*m_rotation->z);
-	rot.z = atan2(2.0*(m_rotation->x*m_rotation->y + m_rotation->w*m_rotation->z), m_rotation->w*m_rotation->w + m_rotation->x*m_rotation->x - m_rotation->y*m_rotation->y - m_rotation->z*m_rotation->z);
+	rot.y = asin(-2.0*(rotation.x*rotation.z - rotation.w*rotation.y));
+	rot.x = atan2(2.0*(rotation.y*rotation.z + rotation.w*rotation.x), rotation.w*rotation.w - rotation.x*rotation.x - rotation.y*rotation.y + rotation.z*rotation.z);
+	rot.z = atan2(2.0*(rotation.x*rotation.y + rotation.w*rotation.z), rotation.w*rotation.w + rotation.x*rotation.x - rotation.y*rotation.y - rotation.z*rotation.z);
 
 	return m_file_name + "\t" +
-		std::to_string(m_scale->x) + " " + std::to_string(m_scale->y) + " " + std::to_string(m_scale->z) + "\t" +
-		std::to_string(m_location->x) + " " + std::to_string(m_location->y) + " " + std::to_string(m_location->z) + "\t" +
+		std::to_string(scale.x) + " " + std::to_string(scale.y) + " " + std::to_string(scale.z) + "\t" +
+		std::to_string(location.x) + " " + std::to_string(location.y) + " " + std::to_string(location.z) + "\t" +
 		std::to_string(rot.x) + " " + std::to_string(rot.y) + " " + std::to_string(rot.z) + "\n";
 }
 
 void Object::build_static_transform()
 {
-	m_transform = glm::mat4();
-	m_transform = glm::translate(m_transform, *m_location);
-
-	m_transform *= glm::toMat4(*m_rotation);
-
-	m_transform = glm::scale(m_transform, *m_scale);
+	scene_tracker->Transforms->update(m_handle);
+}
 
+void Object::transform_changed()
+{
+	computer_bounds();
+	for (auto &component : components)
+	{
+		component.component->invalidate_scene_bounds();
+	}
 }
 
 void Object::computer_bounds()
 {
-	m_lower_bounds = glm::vec3(std::numeric_limits<int>::max());
-	m_upper_bounds = glm::vec3(std::numeric_limits<int>::min());
+	glm::vec3 lower_bounds, upper_bounds;
 
-	for (auto component : *components)
+	lower_bounds = glm::vec3(std::numeric_limits<int>::max());
+	upper_bounds = glm::vec3(std::numeric_limits<int>::min());
+
+	for (auto &component : components)
 	{
 		// Lower Bounds
-		glm::vec3 component_low = component.second->get_lower_bounds();
+		glm::vec3 component_low = component.component->get_lower_bounds();
 
-		m_lower_bounds.x = std::min(component_low.x, m_lower_bounds.x);
-		m_lower_bounds.y = std::min(component_low.y, m_lower_bounds.y);
-		m_lower_bounds.z = std::min(component_low.z, m_lower_bounds.z);
+		lower_bounds.x = std::min(component_low.x, lower_bounds.x);
+		lower_bounds.y = std::min(component_low.y, lower_bounds.y);
+		lower_bounds.z = std::min(component_low.z, lower_bounds.z);
 
 		// Upper Bounds
-		glm::vec3 component_upper = component.second->get_upper_bounds();
+		glm::vec3 component_upper = component.component->get_upper_bounds();
 
-		m_upper_bounds.x = std::max(component_upper.x, m_upper_bounds.x);
-		m_upper_bounds.y = std::max(component_upper.y, m_upper_bounds.y);
-		m_upper_bounds.z = std::max(component_upper.z, m_upper_bounds.z);
+		upper_bounds.x = std::max(component_upper.x, upper_bounds.x);
+		upper_bounds.y = std::max(component_upper.y, upper_bounds.y);
+		upper_bounds.z = std::max(component_upper.z, upper_bounds.z);
 	}
 
 	// Shift our upper and lower bounds by transform, then reasses each vertex for the new max and min positions
-	glm::vec4 tmp_vec_L = glm::vec4(m_lower_bounds, 1.0);
-	tmp_vec_L = m_transform * tmp_vec_L;
+	const glm::mat4 &transform = scene_tracker->Transforms->matrix(m_handle);
+
+	glm::vec4 tmp_vec_L = glm::vec4(lower_bounds, 1.0);
+	tmp_vec_L = transform * tmp_vec_L;
 
-	glm::vec4 tmp_vec_H = glm::vec4(m_upper_bounds, 1.0);
-	tmp_vec_H = m_transform * tmp_vec_H;
+	glm::vec4 tmp_vec_H = glm::vec4(upper_bounds, 1.0);
+	tmp_vec_H = transform * tmp_vec_H;
 
-	m_lower_bounds = glm::vec3(glm::min(tmp_vec_L.x, tmp_vec_H.x), glm::min(tmp_vec_L.y, tmp_vec_H.y), glm::min(tmp_vec_L.z, tmp_vec_H.z));
+	lower_bounds = glm::vec3(glm::min(tmp_vec_L.x, tmp_vec_H.x), glm::min(tmp_vec_L.y, tmp_vec_H.y), glm::min(tmp_vec_L.z, tmp_vec_H.z));
 
-	m_upper_bounds = glm::vec3(glm::max(tmp_vec_L.x, tmp_vec_H.x), glm::max(tmp_vec_L.y, tmp_vec_H.y), glm::max(tmp_vec_L.z, tmp_vec_H.z));
+	upper_bounds = glm::vec3(glm::max(tmp_vec_L.x, tmp_vec_H.x), glm::max(tmp_vec_L.y, tmp_vec_H.y), glm::max(tmp_vec_L.z, tmp_vec_H.z));
 
+	scene_tracker->Transforms->set_bounds(m_handle, lower_bounds, upper_bounds);
 }
 
 bool Object::collision_check(glm::vec3 player_lower_bound, glm::vec3 player_upper_bound, glm::vec3 mesh_lower_bound, glm::vec3 mesh_upper_bound)
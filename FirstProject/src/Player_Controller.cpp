@@ -2,15 +2,18 @@
 
 #include <fstream>
 
+#include "../include/Profiler.h"
+
 
 Player_Controller::Player_Controller() {
     player_model  = nullptr;
     scene_tracker = nullptr;
     heightmap     = nullptr;
+    m_handle      = NULL_TRANSFORM;
     timer         = 0.0;
 }
 
-Player_Controller::Player_Controller(Component * component_pointer, bool * keyboard_input, bool * mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, loadedComponents * scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap) : Player_Controller()
+Player_Controller::Player_Controller(Component * component_pointer, bool * keyboard_input, bool * mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, Resource_Manager * scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap) : Player_Controller()
 {
 	// Scene Details
 	this->objects = objects;
@@ -33,6 +36,7 @@ Player_Controller::Player_Controller(Component * component_pointer, bool * keybo
 	this->m_location = position;
 	this->m_scale = scale;
 	this->m_rotation = glm::quat(rotation);
+	this->m_handle = scene_tracker->Transforms->create(m_location, m_rotation, m_scale);
 
 	set_model(component_pointer);
 
@@ -43,7 +47,7 @@ Player_Controller::Player_Controller(Component * component_pointer, bool * keybo
 	m_height = 0.5;
 }
 
-Player_Controller::Player_Controller(std::string component_file_name, bool * keyboard_input, bool * mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, loadedComponents * scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap) : Player_Controller()
+Player_Controller::Player_Controller(std::string component_file_name, bool * keyboard_input, bool * mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, Resource_Manager * scene_tracker, std::map<std::string, Object*>* objects, Heightmap* heightmap) : Player_Controller()
 {
 	// Scene Detail
 	this->objects = objects;
@@ -66,6 +70,7 @@ Player_Controller::Player_Controller(std::string component_file_name, bool * key
 	this->m_scale = scale;
 	this->m_location = position;
 	this->m_rotation = glm::quat(rotation);
+	this->m_handle = scene_tracker->Transforms->create(m_location, m_rotation, m_scale);
 
 	set_create_model(component_file_name);
 
@@ -89,6 +94,10 @@ void Player_Controller::set_model(Component * component_pointer)
 	}
 	// Any rotations, shifts, or scales can come from the player controller's values
 	player_model = component_pointer;
+	if (player_model)
+	{
+		player_model->set_parent(m_handle);
+	}
 
 	//TODO : Get our newly possessed objects location
 }
@@ -101,19 +110,15 @@ void Player_Controller::set_create_model(std::string component_file_name)
 	}
 	// Any rotations, shifts, or scales can come from the player controller's values (Default to scale 1.0)
 	player_model = new Component("Player_Body", component_file_name, glm::quat(), glm::vec3(), glm::vec3(1.0), scene_tracker);
+	player_model->set_parent(m_handle);
 }
 
-void Player_Controller::draw(GLuint shader)
+void Player_Controller::snapshot(std::vector<Draw_Item> &draw_list)
 {
-	//std::cout << "Object::Draw\n";
-	GLuint objLoc = glGetUniformLocation(shader, "object");
-	glUniformMatrix4fv(objLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
-
 	if (player_model)
 	{
-		player_model->draw(shader);
+		player_model->snapshot(draw_list);
 	}
-
 }
 
 void Player_Controller::ProcessKeyboard(GLfloat deltaTime)
@@ -198,6 +203,7 @@ void Player_Controller::ProcessMouseMovement(GLfloat xoffset, GLfloat yoffset, G
 
 void Player_Controller::tick(GLfloat delta)
 {
+	PROFILE_SCOPE("Player_Controller::tick");
 
 	ProcessKeyboard(delta);
 
@@ -315,24 +321,22 @@ void Player_Controller::clip(bool is_clipping)
 
 void Player_Controller::build_static_transform()
 {
-	m_transform = glm::mat4();
-	m_transform = glm::translate(m_transform, m_location);
-
-	m_transform *= glm::toMat4(m_rotation);
-
-	m_transform = glm::scale(m_transform, m_scale);
+	// Marks the player dirty so the body's model matrix follows on the next Transforms->update_world()
+	scene_tracker->Transforms->set_local(m_handle, m_location, m_rotation, m_scale);
 }
 
 void Player_Controller::computer_bounds()
 {
+	const glm::mat4 &transform = scene_tracker->Transforms->matrix(m_handle);
+
 	// Lower
 	glm::vec4 tmp_vec = glm::vec4(player_model->get_lower_bounds(), 1.0);
 
-	tmp_vec = m_transform * tmp_vec;
+	tmp_vec = transform * tmp_vec;
 	m_lower_bounds = glm::vec3(tmp_vec.x, tmp_vec.y, tmp_vec.z);
 
 	// Upper
 	tmp_vec = glm::vec4(player_model->get_upper_bounds(), 1.0);
-	tmp_vec = m_transform * tmp_vec;
+	tmp_vec = transform * tmp_vec;
 	m_upper_bounds = glm::vec3(tmp_vec.x, tmp_vec.y, tmp_vec.z);
 }
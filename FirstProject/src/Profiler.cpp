@@ -0,0 +1,313 @@
+#include "../include/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace {
+	// One ring buffer per thread. Buffers are owned by the registry so events
+	// survive the thread that wrote them (worker threads may exit before export).
+	struct Profile_Buffer {
+		std::vector<Profile_Event> events;
+		std::atomic<uint64_t> written; // Total events ever written; head is written % size
+		uint32_t thread_id;
+		uint32_t depth;
+		bool gpu;
+	};
+
+	std::mutex registry_mutex;
+	std::vector<Profile_Buffer*> registry;
+
+	std::atomic<uint32_t> frame_counter(0);
+	uint64_t frame_start = 0;
+
+	const std::chrono::steady_clock::time_point profiler_epoch = std::chrono::steady_clock::now();
+
+	thread_local Profile_Buffer* local_buffer = nullptr;
+
+	// GPU timings arrive a few frames late from the GL thread; kept apart so they get their own trace row
+	Profile_Buffer* gpu_buffer = nullptr;
+
+	Profile_Buffer* create_buffer(bool gpu)
+	{
+		Profile_Buffer* buffer = new Profile_Buffer;
+		buffer->events.resize(PROFILER_RING_SIZE);
+		buffer->written = 0;
+		buffer->depth = 0;
+		buffer->gpu = gpu;
+
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		buffer->thread_id = static_cast<uint32_t>(registry.size());
+		registry.push_back(buffer);
+
+		return buffer;
+	}
+
+	Profile_Buffer* get_buffer()
+	{
+		if (!local_buffer)
+		{
+			local_buffer = create_buffer(false);
+		}
+		return local_buffer;
+	}
+
+	void write_event(Profile_Buffer* buffer, const char* name, uint64_t begin, uint64_t end, uint32_t depth, uint32_t frame)
+	{
+		uint64_t slot = buffer->written.load(std::memory_order_relaxed);
+
+		Profile_Event& event = buffer->events[slot % PROFILER_RING_SIZE];
+		event.name = name;
+		event.begin = begin;
+		event.end = end;
+		event.frame = frame;
+		event.depth = depth;
+		event.gpu = buffer->gpu;
+
+		buffer->written.store(slot + 1, std::memory_order_release);
+	}
+
+	// Copy out whatever is still held in a buffer. Readers may race the owning thread
+	// on the oldest slots; this is a debugging aid so we accept the occasional torn event.
+	void collect(Profile_Buffer* buffer, std::vector<std::pair<uint32_t, Profile_Event>>& out)
+	{
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t first = written > PROFILER_RING_SIZE ? written - PROFILER_RING_SIZE : 0;
+
+		for (uint64_t idx = first; idx < written; ++idx)
+		{
+			out.push_back(std::make_pair(buffer->thread_id, buffer->events[idx % PROFILER_RING_SIZE]));
+		}
+	}
+
+	struct Scope_Total {
+		uint64_t total;
+		uint32_t calls;
+		uint32_t depth;
+	};
+
+	// One line per scope, largest first
+	std::string format_totals(const std::map<std::string, Scope_Total>& totals, uint32_t frames)
+	{
+		std::vector<std::pair<std::string, Scope_Total>> sorted(totals.begin(), totals.end());
+		std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, Scope_Total>& a, const std::pair<std::string, Scope_Total>& b) {
+			return a.second.total > b.second.total;
+		});
+
+		std::string report;
+		char line[256];
+		for (auto &scope : sorted)
+		{
+			snprintf(line, sizeof(line), "\t%-32s %8.3f ms  %6.1f calls\n",
+				(std::string(scope.second.depth, ' ') + scope.first).c_str(),
+				(scope.second.total / 1.0e6) / frames,
+				double(scope.second.calls) / frames);
+			report += line;
+		}
+		return report;
+	}
+
+	std::vector<std::pair<uint32_t, Profile_Event>> collect_all()
+	{
+		std::vector<std::pair<uint32_t, Profile_Event>> events;
+
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		for (auto buffer : registry)
+		{
+			collect(buffer, events);
+		}
+		return events;
+	}
+}
+
+bool Profiler::enabled()
+{
+#ifdef ENABLE_PROFILER
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Profiler::new_frame()
+{
+	uint64_t time = now();
+	uint32_t frame = frame_counter.load();
+
+	// Close off the previous frame so traces show frame boundaries
+	if (frame > 0)
+	{
+		write_event(get_buffer(), "Frame", frame_start, time, 0, frame);
+	}
+
+	frame_start = time;
+	frame_counter.store(frame + 1);
+}
+
+uint32_t Profiler::current_frame()
+{
+	// Frame 0 covers loading, before the first call to new_frame
+	return frame_counter.load();
+}
+
+uint64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count();
+}
+
+void Profiler::record(const char* name, uint64_t begin, uint64_t end, uint32_t depth)
+{
+	write_event(get_buffer(), name, begin, end, depth, current_frame());
+}
+
+void Profiler::record_gpu(const char* name, uint64_t begin, uint64_t duration, uint32_t frame)
+{
+	if (!gpu_buffer)
+	{
+		gpu_buffer = create_buffer(true);
+	}
+	write_event(gpu_buffer, name, begin, begin + duration, 0, frame);
+}
+
+std::string Profiler::summary(uint32_t frames)
+{
+	if (!enabled())
+	{
+		return "Profiler disabled (build with 'make PROFILE=1')\n";
+	}
+
+	// Only consider complete frames, and never the loading frame
+	uint32_t last = current_frame();
+	uint32_t first = last > frames + 1 ? last - frames : 1;
+	uint32_t counted = last > first ? last - first : 0;
+
+	if (counted == 0)
+	{
+		return "No complete frames recorded\n";
+	}
+
+	std::map<std::string, Scope_Total> cpu_totals, gpu_totals;
+	std::set<uint32_t> gpu_frames;
+
+	for (auto &entry : collect_all())
+	{
+		const Profile_Event& event = entry.second;
+		if (event.frame < first || event.frame >= last)
+			continue;
+
+		Scope_Total& scope = event.gpu ? gpu_totals[event.name] : cpu_totals[event.name];
+		scope.total += event.end - event.begin;
+		scope.calls++;
+		scope.depth = event.depth;
+
+		if (event.gpu)
+			gpu_frames.insert(event.frame);
+	}
+
+	std::string report = "CPU scopes (average over " + std::to_string(counted) + " frames):\n";
+	report += format_totals(cpu_totals, counted);
+
+	// GPU results lag a few frames behind, so average over the frames that have reported
+	if (!gpu_frames.empty())
+	{
+		report += "GPU passes (average over " + std::to_string(gpu_frames.size()) + " frames):\n";
+		report += format_totals(gpu_totals, static_cast<uint32_t>(gpu_frames.size()));
+	}
+
+	return report;
+}
+
+std::vector<Profile_Event> Profiler::frame_events(uint32_t frame)
+{
+	std::vector<Profile_Event> events;
+
+	for (auto &entry : collect_all())
+	{
+		if (entry.second.frame == frame)
+		{
+			events.push_back(entry.second);
+		}
+	}
+
+	std::sort(events.begin(), events.end(), [](const Profile_Event& a, const Profile_Event& b) {
+		return a.begin < b.begin;
+	});
+
+	return events;
+}
+
+bool Profiler::write_chrome_trace(std::string file_name)
+{
+	std::ofstream fs(file_name, std::ios::out);
+	if (!fs.is_open())
+	{
+		std::cerr << "Error saving profile to: " << file_name << std::endl;
+		return false;
+	}
+
+	// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+	// Complete ("X") events, timestamps in microseconds
+	fs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	char line[512];
+
+	// Label the GPU row; GPU passes are placed at the CPU time they were submitted
+	if (gpu_buffer)
+	{
+		snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", gpu_buffer->thread_id);
+		fs << line;
+		first = false;
+	}
+
+	for (auto &entry : collect_all())
+	{
+		const Profile_Event& event = entry.second;
+		snprintf(line, sizeof(line),
+			"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+			first ? "" : ",\n",
+			event.name,
+			event.gpu ? "gpu" : "cpu",
+			entry.first,
+			event.begin / 1000.0,
+			(event.end - event.begin) / 1000.0,
+			event.frame);
+		fs << line;
+		first = false;
+	}
+
+	fs << "\n]}\n";
+	fs.close();
+
+	std::cout << "Profile written to: " << file_name << std::endl;
+	return true;
+}
+
+uint32_t Profiler::push_scope()
+{
+	return get_buffer()->depth++;
+}
+
+void Profiler::pop_scope()
+{
+	get_buffer()->depth--;
+}
+
+Profile_Scope::Profile_Scope(const char* name)
+{
+	m_name = name;
+	m_depth = Profiler::push_scope();
+	m_begin = Profiler::now();
+}
+
+Profile_Scope::~Profile_Scope()
+{
+	Profiler::record(m_name, m_begin, Profiler::now(), m_depth);
+	Profiler::pop_scope();
+}
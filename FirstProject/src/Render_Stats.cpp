@@ -0,0 +1,59 @@
+#include "../include/Render_Stats.h"
+
+uint64_t Render_Stats::draw_calls = 0;
+uint64_t Render_Stats::vertices = 0;
+uint64_t Render_Stats::texture_binds = 0;
+uint64_t Render_Stats::all_draw_calls = 0;
+uint64_t Render_Stats::all_vertices = 0;
+uint64_t Render_Stats::all_texture_binds = 0;
+
+void Render_Stats::draw(uint64_t vertex_count)
+{
+	draw_calls++;
+	vertices += vertex_count;
+	all_draw_calls++;
+	all_vertices += vertex_count;
+}
+
+void Render_Stats::texture_bind()
+{
+	texture_binds++;
+	all_texture_binds++;
+}
+
+void Render_Stats::new_frame()
+{
+	draw_calls = 0;
+	vertices = 0;
+	texture_binds = 0;
+}
+
+uint64_t Render_Stats::frame_draw_calls()
+{
+	return draw_calls;
+}
+
+uint64_t Render_Stats::frame_vertices()
+{
+	return vertices;
+}
+
+uint64_t Render_Stats::frame_texture_binds()
+{
+	return texture_binds;
+}
+
+uint64_t Render_Stats::total_draw_calls()
+{
+	return all_draw_calls;
+}
+
+uint64_t Render_Stats::total_vertices()
+{
+	return all_vertices;
+}
+
+uint64_t Render_Stats::total_texture_binds()
+{
+	return all_texture_binds;
+}
@@ -0,0 +1,193 @@
+#include "../include/Resource_Manager.h"
+#include "../include/Mesh.h"
+#include "../include/Object.h"
+#include "../include/Texture_Streamer.h"
+
+#include <cstdio>
+#include <iostream>
+
+static void destroy_mesh(Mesh* &mesh)
+{
+	delete mesh;
+	mesh = nullptr;
+}
+
+static void destroy_texture(Texture_Resource &texture)
+{
+	if (texture.slot)
+	{
+		Texture_Arrays::release(texture.slot);
+		texture.slot = 0;
+		return;
+	}
+
+	Texture_Streamer::cancel(texture.id);
+	glDeleteTextures(1, &texture.id);
+	texture.id = 0;
+}
+
+static uint64_t budget = TEXTURE_VRAM_BUDGET;
+
+static void destroy_program(Program_Resource &program)
+{
+	glDeleteProgram(program.id);
+	program.id = 0;
+}
+
+std::string format_bytes(uint64_t bytes)
+{
+	char text[32];
+	if (bytes >= 1024 * 1024)
+		snprintf(text, sizeof(text), "%.2f MB", bytes / (1024.0 * 1024.0));
+	else if (bytes >= 1024)
+		snprintf(text, sizeof(text), "%.2f KB", bytes / 1024.0);
+	else
+		snprintf(text, sizeof(text), "%u B", static_cast<uint32_t>(bytes));
+	return text;
+}
+
+Resource_Manager::Resource_Manager() :
+	Meshes("Meshes", destroy_mesh),
+	Textures("Textures", destroy_texture, mTEXTURES),
+	Programs("Programs", destroy_program),
+	shared_textures(0),
+	shared_texture_bytes(0),
+	evicted_textures(0)
+{
+	// Released textures stay loaded until the budget needs their memory, so painting the same
+	// meshes again doesn't reload them
+	Textures.keep_unreferenced(true);
+	Transforms = new Transform_Store;
+	Objects = new Pool<Object>;
+	Components = new Pool<Component>;
+}
+
+Resource_Manager::~Resource_Manager()
+{
+	// Objects destroy their components, components release their meshes and transforms
+	delete Objects;
+	delete Components;
+
+	// Meshes first: each one releases its textures on the way out
+	Meshes.destroy_all();
+	Textures.destroy_all();
+	Programs.destroy_all();
+	delete Transforms;
+}
+
+void Resource_Manager::collect()
+{
+	// Same order as teardown so textures freed by a mesh go in the same frame
+	Meshes.collect();
+	Textures.collect();
+	Programs.collect();
+
+	// Textures nobody holds go first, longest idle first. A texture sharing an array with others only
+	// frees memory once they have all gone, so this checks the arrays again after each one
+	while (Texture_Arrays::resident_bytes() > budget && Textures.evict_unreferenced(1))
+		evicted_textures++;
+	// Then the larger levels of whatever has not been drawn for a while
+	if (Texture_Arrays::resident_bytes() > budget)
+		Texture_Arrays::trim(budget, TEXTURE_IDLE_FRAMES);
+}
+
+void Resource_Manager::set_texture_budget(uint64_t bytes)
+{
+	budget = bytes;
+}
+
+uint64_t Resource_Manager::texture_budget()
+{
+	return budget;
+}
+
+uint32_t Resource_Manager::texture_evictions()
+{
+	return evicted_textures;
+}
+
+std::string Resource_Manager::texture_residency_report()
+{
+	char text[256];
+	snprintf(text, sizeof(text), "Texture residency: %s of %s budget, %u idle textures kept (%s), %u evicted\n",
+		format_bytes(Texture_Arrays::resident_bytes()).c_str(), format_bytes(budget).c_str(),
+		Textures.unreferenced(), format_bytes(Textures.unreferenced_bytes()).c_str(), evicted_textures);
+	return text;
+}
+
+std::string Resource_Manager::report()
+{
+	uint64_t total = Meshes.resident_bytes() + Textures.resident_bytes() + Programs.resident_bytes();
+	return "Resident resources (GPU " + format_bytes(total) + ")\n" +
+		Meshes.report() + Textures.report() + Programs.report() + texture_report() +
+		"Memory:\n" + Memory_Stats::report();
+}
+
+Texture_Handle Resource_Manager::share_texture(String_ID name, uint64_t contents, String_ID holder)
+{
+	auto found = texture_contents.find(contents);
+	if (contents == 0 || found == texture_contents.end() || !Textures.acquire(found->second, holder))
+		return Textures.null_handle();
+
+	Texture_Handle texture = found->second;
+	Textures.alias(name, texture);
+	Texture_Resource resource = Textures.get(texture);
+	shared_textures++;
+	shared_texture_bytes += resource.info.gpu_bytes;
+
+	std::cout << "\t" << String_Table::lookup(name) << " has the same contents as a loaded texture; sharing it (" <<
+		format_bytes(resource.info.gpu_bytes) << " saved)\n";
+	return texture;
+}
+
+void Resource_Manager::add_texture_contents(uint64_t contents, Texture_Handle texture)
+{
+	if (contents)
+		texture_contents[contents] = texture;
+}
+
+std::string Resource_Manager::texture_sharing_report()
+{
+	char text[256];
+	snprintf(text, sizeof(text), "Texture sharing: %u duplicate textures loaded once, %s of VRAM saved\n",
+		shared_textures, format_bytes(shared_texture_bytes).c_str());
+	return text;
+}
+
+std::string Resource_Manager::texture_report()
+{
+	uint64_t gpu = 0, uncompressed = 0;
+	uint32_t count = 0, compressed = 0;
+	double error_sum = 0;
+	float worst_error = 0;
+	String_ID worst = 0;
+
+	Textures.for_each([&](String_ID name, const Texture_Resource &texture, uint64_t bytes) {
+		count++;
+		gpu += bytes;
+		uncompressed += texture.info.uncompressed_bytes;
+		if (texture.info.gpu_bytes < texture.info.uncompressed_bytes)
+		{
+			compressed++;
+			error_sum += texture.info.error;
+			if (texture.info.error >= worst_error)
+			{
+				worst_error = texture.info.error;
+				worst = name;
+			}
+		}
+	});
+
+	char text[512];
+	snprintf(text, sizeof(text), "Texture compression: %u of %u textures block compressed, %s instead of %s (%s saved)\n",
+		compressed, count, format_bytes(gpu).c_str(), format_bytes(uncompressed).c_str(),
+		format_bytes(uncompressed > gpu ? uncompressed - gpu : 0).c_str());
+	std::string report = text;
+	if (compressed)
+	{
+		snprintf(text, sizeof(text), "\tEncode error (RMS, 8 bit steps): mean %.2f, worst %.2f (%s)\n",
+			error_sum / compressed, worst_error, String_Table::lookup(worst).c_str());
+		report += text;
+	}
+	return report + texture_sharing_report() + texture_residency_report();
+}
@@ -0,0 +1,281 @@
+#include "../include/Scatter_Brush.h"
+#include "../include/Job_System.h"
+#include "../include/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// Beyond this many grid cells the minimum distance is too small for the area
+#define SCATTER_MAX_CELLS (1u << 24)
+// Placements snapped per job
+#define SCATTER_PLACE_BATCH 256
+
+static const GLfloat SCATTER_PI = 3.14159265358979f;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Scatter_Brush::Scatter_Brush(Heightmap* heightmap)
+{
+	this->heightmap = heightmap;
+	sample_ms = 0;
+	attach_ms = 0;
+}
+
+bool Scatter_Brush::inside(const Scatter_Region &region, glm::vec2 point)
+{
+	if (region.polygon.empty())
+	{
+		glm::vec2 offset = point - region.centre;
+		return glm::dot(offset, offset) <= region.radius * region.radius;
+	}
+
+	// Even-odd rule: count the edges a ray along +x crosses
+	bool odd = false;
+	size_t corners = region.polygon.size();
+	for (size_t idx = 0, prev = corners - 1; idx < corners; prev = idx++)
+	{
+		const glm::vec2 &a = region.polygon[idx];
+		const glm::vec2 &b = region.polygon[prev];
+		if ((a.y > point.y) != (b.y > point.y) &&
+			point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+		{
+			odd = !odd;
+		}
+	}
+	return odd;
+}
+
+bool Scatter_Brush::blocked(glm::vec2 point)
+{
+	// Same test as Player_Controller: anything in the blue channel is a barrier
+	return heightmap && heightmap->get_image_value(point.x, point.y, 2) != 0;
+}
+
+std::vector<Object_Placement> Scatter_Brush::sample(const Scatter_Region &region, const Scatter_Settings &settings, const std::string &name_prefix, uint32_t first_number)
+{
+	PROFILE_SCOPE("Scatter_Brush::sample");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<Object_Placement> placements;
+	sample_ms = 0;
+
+	if (settings.count == 0)
+		return placements;
+
+	// Bounds and area of the region, kept on the heightmap
+	glm::vec2 lower, upper;
+	GLfloat area;
+	if (region.polygon.empty())
+	{
+		lower = region.centre - glm::vec2(region.radius);
+		upper = region.centre + glm::vec2(region.radius);
+		area = SCATTER_PI * region.radius * region.radius;
+	}
+	else
+	{
+		lower = upper = region.polygon[0];
+		area = 0;
+		for (size_t idx = 0, prev = region.polygon.size() - 1; idx < region.polygon.size(); prev = idx++)
+		{
+			lower = glm::min(lower, region.polygon[idx]);
+			upper = glm::max(upper, region.polygon[idx]);
+			area += region.polygon[prev].x * region.polygon[idx].y - region.polygon[idx].x * region.polygon[prev].y;
+		}
+		area = std::fabs(area) / 2;
+	}
+	if (heightmap)
+	{
+		glm::vec3 extent = heightmap->get_mesh_scale();
+		lower = glm::max(lower, glm::vec2(-extent.x, -extent.z));
+		upper = glm::min(upper, glm::vec2(extent.x, extent.z));
+	}
+	if (area <= 0 || upper.x <= lower.x || upper.y <= lower.y)
+		return placements;
+
+	GLfloat distance = settings.min_distance > 0 ? settings.min_distance : std::sqrt(SCATTER_PACKING * area / settings.count);
+
+	// Acceleration grid: a cell's diagonal is the minimum distance, so each cell holds at most one point
+	GLfloat cell = distance / std::sqrt(2.0f);
+	uint32_t grid_x = static_cast<uint32_t>(std::ceil((upper.x - lower.x) / cell));
+	uint32_t grid_z = static_cast<uint32_t>(std::ceil((upper.y - lower.y) / cell));
+	if (static_cast<uint64_t>(grid_x) * grid_z > SCATTER_MAX_CELLS)
+	{
+		std::cerr << "Scatter: minimum distance " << distance << " is too small for the area" << std::endl;
+		return placements;
+	}
+
+	std::vector<glm::vec2> points(grid_x * grid_z);
+	std::vector<uint8_t> filled(grid_x * grid_z, 0);
+
+	// Neighbours within the distance are at most two cells away, so tiles three cells wide only
+	// read their direct neighbours, and tiles of the same phase never share a cell they look at
+	const uint32_t tile_cells = 3;
+	uint32_t tiles_x = (grid_x + tile_cells - 1) / tile_cells;
+	uint32_t tiles_z = (grid_z + tile_cells - 1) / tile_cells;
+
+	auto fill_tile = [&](uint32_t tile_x, uint32_t tile_z) {
+		std::minstd_rand rng(settings.seed * 2654435761u + tile_z * tiles_x + tile_x + 1);
+		std::uniform_real_distribution<GLfloat> unit(0.0f, 1.0f);
+
+		uint32_t cell_x0 = tile_x * tile_cells, cell_x1 = std::min(grid_x, cell_x0 + tile_cells);
+		uint32_t cell_z0 = tile_z * tile_cells, cell_z1 = std::min(grid_z, cell_z0 + tile_cells);
+		glm::vec2 tile_lower = lower + glm::vec2(cell_x0, cell_z0) * cell;
+		glm::vec2 tile_upper = glm::min(upper, lower + glm::vec2(cell_x1, cell_z1) * cell);
+
+		auto accept = [&](glm::vec2 point) -> bool {
+			if (point.x < tile_lower.x || point.y < tile_lower.y || point.x >= tile_upper.x || point.y >= tile_upper.y)
+				return false;
+
+			int32_t cx = std::min<int32_t>(grid_x - 1, static_cast<int32_t>((point.x - lower.x) / cell));
+			int32_t cz = std::min<int32_t>(grid_z - 1, static_cast<int32_t>((point.y - lower.y) / cell));
+			for (int32_t z = std::max(0, cz - 2); z <= std::min<int32_t>(grid_z - 1, cz + 2); ++z)
+			{
+				for (int32_t x = std::max(0, cx - 2); x <= std::min<int32_t>(grid_x - 1, cx + 2); ++x)
+				{
+					// Corner cells are at least the distance away
+					if ((x == cx - 2 || x == cx + 2) && (z == cz - 2 || z == cz + 2))
+						continue;
+
+					uint32_t index = z * grid_x + x;
+					glm::vec2 offset = points[index] - point;
+					if (filled[index] && glm::dot(offset, offset) < distance * distance)
+						return false;
+				}
+			}
+
+			if (!inside(region, point) || blocked(point))
+				return false;
+
+			uint32_t index = cz * grid_x + cx;
+			points[index] = point;
+			filled[index] = 1;
+			return true;
+		};
+
+		std::vector<glm::vec2> active;
+		for (uint32_t seed = 0; seed < SCATTER_TILE_SEEDS; ++seed)
+		{
+			glm::vec2 point = tile_lower + (tile_upper - tile_lower) * glm::vec2(unit(rng), unit(rng));
+			if (!accept(point))
+				continue;
+			active.push_back(point);
+
+			// Bridson: grow from active points, retiring each once k candidates around it fail
+			while (!active.empty())
+			{
+				size_t pick = std::min(active.size() - 1, static_cast<size_t>(unit(rng) * active.size()));
+				glm::vec2 around = active[pick];
+				bool grew = false;
+
+				// Candidates evenly spaced round a circle just past the distance (Roberts' variant of
+				// Bridson): denser than random annulus picks and needs far fewer tries per point
+				GLfloat angle = unit(rng) * 2 * SCATTER_PI;
+				for (uint32_t attempt = 0; attempt < SCATTER_CANDIDATES; ++attempt)
+				{
+					GLfloat step = angle + attempt * (2 * SCATTER_PI / SCATTER_CANDIDATES);
+					glm::vec2 candidate = around + distance * SCATTER_RING * glm::vec2(std::cos(step), std::sin(step));
+					if (accept(candidate))
+					{
+						active.push_back(candidate);
+						grew = true;
+						break;
+					}
+				}
+
+				if (!grew)
+				{
+					active[pick] = active.back();
+					active.pop_back();
+				}
+			}
+		}
+	};
+
+	for (uint32_t phase = 0; phase < 4; ++phase)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> tiles;
+		for (uint32_t tile_z = phase / 2; tile_z < tiles_z; tile_z += 2)
+		{
+			for (uint32_t tile_x = phase % 2; tile_x < tiles_x; tile_x += 2)
+				tiles.push_back(std::make_pair(tile_x, tile_z));
+		}
+
+		Job_System::parallel_for(static_cast<uint32_t>(tiles.size()), 1, [&](uint32_t first, uint32_t last) {
+			for (uint32_t item = first; item < last; ++item)
+				fill_tile(tiles[item].first, tiles[item].second);
+		});
+	}
+
+	// Grid order, so the result does not depend on which thread finished first
+	std::vector<glm::vec2> samples;
+	for (uint32_t index = 0; index < filled.size(); ++index)
+	{
+		if (filled[index])
+			samples.push_back(points[index]);
+	}
+
+	// More than asked for: keep a random subset, which stays evenly spread
+	if (samples.size() > settings.count)
+	{
+		std::minstd_rand rng(settings.seed + 1);
+		for (uint32_t idx = 0; idx < settings.count; ++idx)
+		{
+			uint32_t swap = idx + static_cast<uint32_t>(rng() % (samples.size() - idx));
+			std::swap(samples[idx], samples[swap]);
+		}
+		samples.resize(settings.count);
+	}
+
+	// Snap, rotate and scale. Each point has its own generator so threads don't change the result
+	placements.resize(samples.size());
+	Job_System::parallel_for(static_cast<uint32_t>(samples.size()), SCATTER_PLACE_BATCH, [&](uint32_t first, uint32_t last) {
+		for (uint32_t idx = first; idx < last; ++idx)
+		{
+			std::minstd_rand rng(settings.seed ^ ((idx + 1) * 2654435761u));
+			std::uniform_real_distribution<GLfloat> unit(0.0f, 1.0f);
+
+			glm::vec2 point = samples[idx];
+			GLfloat floor = heightmap ? heightmap->GetFloor(glm::vec3(point.x, 0, point.y)) : 0;
+			GLfloat scale = settings.min_scale + (settings.max_scale - settings.min_scale) * unit(rng);
+
+			Object_Placement &placement = placements[idx];
+			placement.name = name_prefix + "_" + std::to_string(first_number + idx);
+			placement.rotation = glm::angleAxis(unit(rng) * 2 * SCATTER_PI, glm::vec3(0, 1, 0));
+			placement.location = glm::vec3(point.x, floor + settings.y_offset, point.y);
+			placement.scale = glm::vec3(scale);
+		}
+	});
+
+	sample_ms = elapsed_ms(start);
+	return placements;
+}
+
+uint32_t Scatter_Brush::scatter(Scene* scene, std::string file_name, const Scatter_Region &region, const Scatter_Settings &settings,
+	const std::string &name_prefix, uint32_t first_number, std::vector<Object_Handle>* handles)
+{
+	std::vector<Object_Placement> placements = sample(region, settings, name_prefix, first_number);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<Object_Handle> placed;
+	scene->attachObjects(file_name, placements, &placed);
+	attach_ms = elapsed_ms(start);
+
+	if (handles)
+		handles->insert(handles->end(), placed.begin(), placed.end());
+	return static_cast<uint32_t>(placed.size());
+}
+
+double Scatter_Brush::last_sample_ms()
+{
+	return sample_ms;
+}
+
+double Scatter_Brush::last_attach_ms()
+{
+	return attach_ms;
+}
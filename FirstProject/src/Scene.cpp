@@ -1,4 +1,10 @@
 #include "../include/Scene.h"
+#include "../include/Profiler.h"
+#include "../include/GPU_Profiler.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Frame_Memory.h"
+#include "../include/Texture_Arrays.h"
+#include "../include/Skybox.h"
 
 Scene::Scene(std::string scene_file)
 {
@@ -6,8 +12,11 @@ Scene::Scene(std::string scene_file)
 
 	heightmap = nullptr;
     	player    = nullptr;
+	skybox_files = SKYBOX_DEFAULT_FACES;
+	skybox = nullptr;
+	sky_program = 0;
 
-	scene_tracker = new loadedComponents;
+	scene_tracker = new Resource_Manager;
 
 	objects = new std::map<std::string, Object*>;
 	cameras = new std::map<std::string, Camera*>;
@@ -28,20 +37,26 @@ Scene::Scene(std::string scene_file)
 
 	std::cerr << "Projection Updated\n";
 
+	// Cooks / loads in the background; draw() shows it once it is ready
+	attachShader("Skybox", "./Shaders/skybox.vert", "./Shaders/skybox.frag");
+	skybox = new Skybox(skybox_files);
+
 }
 
 Scene::~Scene()
 {
-	for (auto object : *objects) {
-		removeObject(object.first);
+	for (auto &object : *objects) {
+		scene_tracker->Objects->destroy(scene_tracker->Objects->handle_of(object.second));
 	}
+	objects->clear();
+	delete skybox;
 }
 
 void Scene::attachObject(std::string object_scene_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, std::string file_name, std::string base_dir)
 {
 	if (objects->find(object_scene_name) == objects->end())
 	{
-		objects->operator[](object_scene_name) = new Object(base_dir+file_name, rot, loc, scale, scene_tracker);
+		createObject(object_scene_name, rot, loc, scale, base_dir + file_name);
 	}
 }
 
@@ -49,86 +64,214 @@ void Scene::attachObject(std::string object_scene_name, std::string object_detai
 {
 	if (objects->find(object_scene_name) == objects->end())
 	{
-		objects->operator[](object_scene_name) = new Object(object_scene_name, object_details, scene_tracker);
+		Object_Handle handle = scene_tracker->Objects->create(object_scene_name, object_details, scene_tracker);
+		Object* object = scene_tracker->Objects->get(handle);
+		objects->operator[](object_scene_name) = object;
+		prototypes[object->get_file_name()] = handle;
 	}
 
 }
 
+void Scene::attachObjects(std::string file_name, const std::vector<Object_Placement> &placements, std::vector<Object_Handle>* handles)
+{
+	PROFILE_SCOPE("Scene::attachObjects");
+	scene_tracker->Objects->reserve(scene_tracker->Objects->size() + static_cast<uint32_t>(placements.size()));
+	if (handles)
+		handles->reserve(handles->size() + placements.size());
+
+	for (auto &placement : placements)
+	{
+		if (objects->find(placement.name) != objects->end())
+			continue;
+
+		Object_Handle handle = createObject(placement.name, placement.rotation, placement.location, placement.scale, file_name);
+		if (handles)
+			handles->push_back(handle);
+	}
+}
+
+Object_Handle Scene::createObject(std::string object_scene_name, glm::quat rot, glm::vec3 loc, glm::vec3 scale, std::string file_name)
+{
+	Pool<Object>* pool = scene_tracker->Objects;
+	Object_Handle handle;
+
+	// Clone an object already using this file; only read it from disk if there is none left
+	std::map<std::string, Object_Handle>::iterator prototype = prototypes.find(file_name);
+	if (prototype != prototypes.end() && !pool->valid(prototype->second))
+	{
+		prototypes.erase(prototype);
+		prototype = prototypes.end();
+		for (auto &object : *objects)
+		{
+			if (object.second->get_file_name() == file_name)
+			{
+				prototype = prototypes.insert(std::make_pair(file_name, pool->handle_of(object.second))).first;
+				break;
+			}
+		}
+	}
+
+	if (prototype != prototypes.end())
+	{
+		handle = pool->create(*pool->get(prototype->second), object_scene_name, rot, loc, scale);
+	}
+	else
+	{
+		handle = pool->create(object_scene_name, file_name, rot, loc, scale, scene_tracker);
+		prototypes[file_name] = handle;
+	}
+
+	objects->operator[](object_scene_name) = pool->get(handle);
+	return handle;
+}
+
 void Scene::attachShader(std::string shader_scene_name, std::string vertex_file, std::string fragment_file)
 {
-	if (scene_tracker->Shaders->find(shader_scene_name) != scene_tracker->Shaders->end())
+	String_ID shader_id = String_Table::intern(shader_scene_name);
+	std::pair<Program_Handle, GLuint>* existing = programs.find(shader_id);
+	if (existing)
 	{
-		glDeleteProgram(scene_tracker->Shaders->at(shader_scene_name));
-		scene_tracker->Shaders->erase(shader_scene_name);
+		// Deleted at the end of the frame, so a draw already using it is unaffected
+		scene_tracker->Programs.release(existing->first, SID("Scene"));
+		programs.erase(shader_id);
 	}
 
-	scene_tracker->Shaders->operator[](shader_scene_name) = shader_loader->build_program(std::make_pair(fragment_file, vertex_file));
+	Program_Resource program = { shader_loader->build_program(std::make_pair(fragment_file, vertex_file)) };
+	Texture_Arrays::assign_units(program.id);
+	Program_Handle handle = scene_tracker->Programs.add(shader_id, program, 0, SID("Scene"));
+	programs[shader_id] = std::make_pair(handle, program.id);
+	if (shader_id == SID("Skybox"))
+		sky_program = program.id;
 }
 
 void Scene::removeObject(std::string object_scene_name)
 {
-	if (objects->find(object_scene_name) != objects->end())
+	std::map<std::string, Object*>::iterator object = objects->find(object_scene_name);
+	if (object != objects->end())
 	{
-		delete objects->at(object_scene_name);
-		objects->erase(objects->find(object_scene_name));
+		// The slot goes back to the pool for the next painted object
+		scene_tracker->Objects->destroy(scene_tracker->Objects->handle_of(object->second));
+		objects->erase(object);
 	}
 }
 
-void Scene::draw()
+void Scene::removeObject(Object_Handle object)
 {
+	Object* removing = scene_tracker->Objects->get(object);
+	if (removing)
+	{
+		objects->erase(removing->get_name());
+		scene_tracker->Objects->destroy(object);
+	}
+}
+
+void Scene::removeObjects(const std::vector<Object_Handle> &removing)
+{
+	PROFILE_SCOPE("Scene::removeObjects");
+	for (auto &object : removing)
+	{
+		removeObject(object);
+	}
+}
+
+void Scene::snapshot(Render_Snapshot &snapshot)
+{
+	PROFILE_SCOPE("Scene::snapshot");
+	snapshot.clear();
+
+	{
+		PROFILE_SCOPE("Scene::snapshot transforms");
+		scene_tracker->Transforms->update_world();
+	}
+
 	update_projection();
+	snapshot.view_position = active_camera->Position;
+	snapshot.view = active_camera->GetViewMatrix();
+	snapshot.projection = m_transform;
+
+	for (auto &light : *lights)
+	{
+		if (snapshot.lights.size() >= MAX_LIGHTS)
+		{
+			break;
+		}
+
+		Light* current_light = light.second;
+		Light_State state = {
+			current_light->type,
+			*current_light->location,
+			*current_light->direction,
+			*current_light->ambient,
+			*current_light->diffuse,
+			*current_light->specular,
+			current_light->cut_off,
+			current_light->outer_cut_off,
+			current_light->constant,
+			current_light->linear,
+			current_light->quadratic
+		};
+		snapshot.lights.push_back(state);
+	}
+
+	for (auto &object : *objects)
+	{
+		object.second->snapshot(snapshot.statics);
+	}
+
+	if (player)
+	{
+		player->snapshot(snapshot.player);
+	}
+}
 
+void Scene::draw(const Render_Snapshot &snapshot)
+{
+	PROFILE_SCOPE("Scene::draw");
 	glUseProgram(active_shader);
+	Texture_Arrays::reset_binds();
 
 	// -- Light Uniforms --
-	if (lights->size() > 0)
+	if (snapshot.lights.size() > 0)
 	{
 		int light_idx = 0;
-		for (auto &light : *lights)
+		for (auto &light : snapshot.lights)
 		{
-			Light* current_light = light.second;
-			if (light_idx >= MAX_LIGHTS)
-			{
-				break;
-			}
-
-			std::string shader_light = "light[" + std::to_string(light_idx) + "].";
-
-			GLuint hasLight = glGetUniformLocation(active_shader, (shader_light+"enabled").c_str());
+			// Uniform names are built in the frame scratch arena, not on the heap
+			GLuint hasLight = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].enabled", light_idx));
 			glUniform1i(hasLight, 1);
 
-			GLuint light_type = glGetUniformLocation(active_shader, (shader_light + "type").c_str());
-			glUniform1i(light_type, current_light->type);
+			GLuint light_type = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].type", light_idx));
+			glUniform1i(light_type, light.type);
 
-			GLuint lightPos = glGetUniformLocation(active_shader, (shader_light + "position").c_str());
-			glUniform3fv(lightPos, 1, glm::value_ptr(*current_light->location));
+			GLuint lightPos = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].position", light_idx));
+			glUniform3fv(lightPos, 1, glm::value_ptr(light.position));
 
-			GLuint lightDir = glGetUniformLocation(active_shader, (shader_light + "direction").c_str());
-			glUniform3fv(lightDir, 1, glm::value_ptr(*current_light->direction));
+			GLuint lightDir = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].direction", light_idx));
+			glUniform3fv(lightDir, 1, glm::value_ptr(light.direction));
 
-			GLuint cut_off = glGetUniformLocation(active_shader, (shader_light + "cut_off").c_str());
-			glUniform1f(cut_off, current_light->cut_off);
+			GLuint cut_off = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].cut_off", light_idx));
+			glUniform1f(cut_off, light.cut_off);
 
-			GLuint outer_cut_off = glGetUniformLocation(active_shader, (shader_light + "cut_off").c_str());
-			glUniform1f(outer_cut_off, current_light->outer_cut_off);
+			GLuint outer_cut_off = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].cut_off", light_idx));
+			glUniform1f(outer_cut_off, light.outer_cut_off);
 
-			GLuint constant = glGetUniformLocation(active_shader, (shader_light + "constant").c_str());
-			glUniform1f(constant, current_light->constant);
+			GLuint constant = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].constant", light_idx));
+			glUniform1f(constant, light.constant);
 
-			GLuint linear = glGetUniformLocation(active_shader, (shader_light + "linear").c_str());
-			glUniform1f(linear, current_light->linear);
+			GLuint linear = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].linear", light_idx));
+			glUniform1f(linear, light.linear);
 
-			GLuint quadratic = glGetUniformLocation(active_shader, (shader_light + "quadratic").c_str());
-			glUniform1f(quadratic, current_light->quadratic);
+			GLuint quadratic = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].quadratic", light_idx));
+			glUniform1f(quadratic, light.quadratic);
 
-			GLuint ambient_color = glGetUniformLocation(active_shader, (shader_light + "ambient").c_str());
-			glUniform3fv(ambient_color, 1, glm::value_ptr(*current_light->ambient));
+			GLuint ambient_color = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].ambient", light_idx));
+			glUniform3fv(ambient_color, 1, glm::value_ptr(light.ambient));
 
-			GLuint specular_color = glGetUniformLocation(active_shader, (shader_light + "specular").c_str());
-			glUniform3fv(specular_color, 1, glm::value_ptr(*current_light->specular));
+			GLuint specular_color = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].specular", light_idx));
+			glUniform3fv(specular_color, 1, glm::value_ptr(light.specular));
 
-			GLuint diffuse_color = glGetUniformLocation(active_shader, (shader_light + "diffuse").c_str());
-			glUniform3fv(diffuse_color, 1, glm::value_ptr(*current_light->diffuse));
+			GLuint diffuse_color = glGetUniformLocation(active_shader, Frame_Memory::format("light[%d].diffuse", light_idx));
+			glUniform3fv(diffuse_color, 1, glm::value_ptr(light.diffuse));
 
 			// Increment light sources
 			++light_idx;
@@ -142,30 +285,29 @@ void Scene::draw()
 
 	// -- Camera Uniforms --
 	GLuint viewPosLoc = glGetUniformLocation(active_shader, "viewPos");
-	glUniform3fv(viewPosLoc, 1, glm::value_ptr(this->active_camera->Position));
+	glUniform3fv(viewPosLoc, 1, glm::value_ptr(snapshot.view_position));
 
 	GLuint cameraLoc = glGetUniformLocation(active_shader, "view");
-	glUniformMatrix4fv(cameraLoc, 1, GL_FALSE, glm::value_ptr(active_camera->GetViewMatrix()));
+	glUniformMatrix4fv(cameraLoc, 1, GL_FALSE, glm::value_ptr(snapshot.view));
 
 	// -- Scene Uniforms --
 	GLuint projectionLoc = glGetUniformLocation(active_shader, "projection");
-	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
+	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(snapshot.projection));
 
 	GLuint viewer_mode = glGetUniformLocation(active_shader, "view_mode");
 	glUniform1i(viewer_mode, view_mode);
 
 	// -- Draw Out Scene Components --
-    for(auto object : *objects)
     {
-        glEnable(GL_CULL_FACE);
-        glFrontFace(GL_CCW);
-        glCullFace(GL_BACK);
-        object.second->draw(active_shader);
-        glDisable(GL_CULL_FACE);
+        PROFILE_SCOPE("Scene::draw statics");
+        GPU_PROFILE_SCOPE("Statics");
+        draw_items(snapshot.statics);
     }
 
     if(heightmap)
     {
+        PROFILE_SCOPE("Scene::draw heightmap");
+        GPU_PROFILE_SCOPE("Heightmap");
         glEnable(GL_CULL_FACE);
         glFrontFace(GL_CCW);
         glCullFace(GL_BACK);
@@ -173,41 +315,76 @@ void Scene::draw()
         glDisable(GL_CULL_FACE);
     }
 
-    if (player)
+    if (!snapshot.player.empty())
     {
-        glEnable(GL_CULL_FACE);
-        glFrontFace(GL_CCW);
-        glCullFace(GL_BACK);
-        player->draw(active_shader);
-        glDisable(GL_CULL_FACE);
+        PROFILE_SCOPE("Scene::draw player");
+        GPU_PROFILE_SCOPE("Player");
+        draw_items(snapshot.player);
     }
 
 	// -- Turn out Lights back off --
-	for (uint32_t light_idx = 0; (light_idx < lights->size() && light_idx < MAX_LIGHTS); ++light_idx)
+	for (uint32_t light_idx = 0; light_idx < snapshot.lights.size(); ++light_idx)
 	{
-		std::string shader_light = "light[" + std::to_string(light_idx) + "].";
-		GLuint hasLight = glGetUniformLocation(active_shader, (shader_light + "enabled").c_str());
+		GLuint hasLight = glGetUniformLocation(active_shader, Frame_Memory::format("light[%u].enabled", light_idx));
 		glUniform1i(hasLight, 0);
 	}
+
+	// -- Sky last: the depth test leaves it only the pixels nothing else covered --
+	if (skybox && sky_program)
+	{
+		PROFILE_SCOPE("Scene::draw skybox");
+		GPU_PROFILE_SCOPE("Skybox");
+		// Filled in wireframe views too, as before; the caller puts its polygon mode back after draw()
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		skybox->draw(sky_program, snapshot.view, snapshot.projection);
+	}
 }
 
-void Scene::rendSky(){
-	glUseProgram(active_shader);
-	glm::mat4 v = glm::mat4(glm::mat3(active_camera->GetViewMatrix()));
-	GLuint cameraLoc = glGetUniformLocation(active_shader, "view");
-	glUniformMatrix4fv(cameraLoc, 1, GL_FALSE, glm::value_ptr(v));
+void Scene::draw_items(const std::vector<Draw_Item> &draw_list)
+{
+	GLuint modelLoc = glGetUniformLocation(active_shader, "model");
+	GLuint normalLoc = glGetUniformLocation(active_shader, "normal_matrix");
 
-	GLuint projectionLoc = glGetUniformLocation(active_shader, "projection");
-	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(m_transform));
+	glEnable(GL_CULL_FACE);
+	glFrontFace(GL_CCW);
+	glCullFace(GL_BACK);
+	for (auto &item : draw_list)
+	{
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+		glUniformMatrix3fv(normalLoc, 1, GL_FALSE, glm::value_ptr(item.normal));
+		item.mesh->draw(active_shader);
+	}
+	glDisable(GL_CULL_FACE);
+}
 
+void Scene::end_frame()
+{
+	PROFILE_SCOPE("Scene::end_frame");
+	scene_tracker->collect();
+}
+
+std::string Scene::resource_report()
+{
+	return scene_tracker->report();
+}
+
+std::string Scene::texture_sharing_report()
+{
+	return scene_tracker->texture_sharing_report();
+}
+
+std::string Scene::texture_residency_report()
+{
+	return scene_tracker->texture_residency_report();
 }
 
 void Scene::tick(GLfloat delta)
 {
+	PROFILE_SCOPE("Scene::tick");
 
 	active_camera->tick();
 
-	for (auto light : *lights)
+	for (auto &light : *lights)
 	{
 		light.second->tick(delta);
 	}
@@ -215,13 +392,19 @@ void Scene::tick(GLfloat delta)
 
 void Scene::setActiveShader(std::string shader_scene_name)
 {
-	if (scene_tracker->Shaders->find(shader_scene_name) != scene_tracker->Shaders->end())
+	setActiveShader(String_Table::intern(shader_scene_name));
+}
+
+void Scene::setActiveShader(String_ID shader_id)
+{
+	std::pair<Program_Handle, GLuint>* shader = programs.find(shader_id);
+	if (shader)
 	{
-		active_shader = scene_tracker->Shaders->at(shader_scene_name);
+		active_shader = shader->second;
 	}
 	else
 	{
-		std::cout << "Shader " << shader_scene_name << " does not exist in scene.\n";
+		std::cout << "Shader " << String_Table::lookup(shader_id) << " does not exist in scene.\n";
 	}
 }
 
@@ -308,6 +491,11 @@ Object * Scene::getObject(std::string scene_object_name)
     return nullptr;
 }
 
+Object * Scene::getObject(Object_Handle object)
+{
+	return scene_tracker->Objects->get(object);
+}
+
 void Scene::attachPlayer(Component * object_pointer, bool * keyboard_input, bool * mouse_buttons, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
 {
 	removePlayer();
@@ -350,6 +538,12 @@ std::string Scene::report()
 	report += "Camera:\n";
 	report += "\tCamera_01 	-1.5 0.0 0.0	0.0 1.0 0.0 	0.0 0.0\n";
 
+	report += "Skybox:\n";
+	report += "\t";
+	for (size_t face = 0; face < skybox_files.size(); ++face)
+		report += (face ? " " : "") + skybox_files[face];
+	report += "\n";
+
 	report += "Lights:\n";
 	report += "\tOverhead 	0	0.0 -1.0 0.0	0.0 0.0 0.0		1.0 0.99 0.5	1.0 1.0 1.0\n";
 	report += "\tRotateLight 1	0.0 0.0 0.0 	1.0 1.0 0.0 	1.0 0.99 0.5 	1.0 1.0 0.0		0.045 0.0075\n";
@@ -361,7 +555,11 @@ std::string Scene::report()
 		report += object.second->report();
 	}
 	report += "Heightmap:\n";
-	report += "\t./Statics/test.heightmap";
+	report += "\t./Statics/test.heightmap\n";
+
+	// Informational only: SceneLoader skips sections it does not know
+	report += "Memory:\n";
+	report += Memory_Stats::report();
 
 	return report;
 
@@ -402,3 +600,20 @@ Heightmap* Scene::getHeightmap()
 {
 	return heightmap;
 }
+
+void Scene::setSkybox(std::vector<std::string> faces)
+{
+	skybox_files = faces;
+
+	// While the scene file is read there is no sky yet; the constructor makes it
+	if (skybox)
+	{
+		delete skybox;
+		skybox = new Skybox(skybox_files);
+	}
+}
+
+Skybox* Scene::getSkybox()
+{
+	return skybox;
+}
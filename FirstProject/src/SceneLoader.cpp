@@ -1,22 +1,27 @@
 #include "../include/SceneLoader.h"
 #include <algorithm>
 
+#include "../include/Profiler.h"
+#include "../include/VFS.h"
+
 
 SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 {
+	PROFILE_SCOPE("SceneLoader");
 	this->scene = loading_scene;
 	this->scene_shader_loader = loading_scene->shader_loader;
 
-	std::ifstream fb; // FileBuffer
+	File_View file;
 
 	std::cout << "Loading: " << (SceneFile) << std::endl;
 
-	fb.open((SceneFile), std::ios::in);
-
-	if (fb.is_open()) {
+	if (VFS::open(SceneFile, file)) {
+		View_Stream fb(file); // FileBuffer
 		std::string ObjectName = SceneFile; // Save Object Name
 		std::string LineBuf;
 		bool load_success = true;
+		// Compiled once: constructing a std::regex per line costs far more than matching it
+		const std::regex tab_line(LIGHT_REGEX);
 
 		while (std::getline(fb, LineBuf)) {
 
@@ -38,7 +43,7 @@ SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 				GLfloat yaw, pitch;
 
 				// TODO set Camera_REGEX (Tho' Light regex will probably work for now :P)
-				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, std::regex(LIGHT_REGEX)))
+				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, tab_line))
 				{
 					std::stringstream iss(LineBuf);
 
@@ -60,7 +65,7 @@ SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 			{
 				std::streampos last_line = fb.tellg();
 
-				if (std::getline(fb, LineBuf) && std::regex_match(LineBuf, std::regex(LIGHT_REGEX)))
+				if (std::getline(fb, LineBuf) && std::regex_match(LineBuf, tab_line))
 				{
 					// Clean Up leading spaces
 					LineBuf.erase(std::remove(LineBuf.begin(), LineBuf.end(), '\t'), LineBuf.end());
@@ -79,7 +84,7 @@ SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 				std::cout << LineBuf << std::endl;
 				std::streampos last_line = fb.tellg();
 
-				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, std::regex(LIGHT_REGEX)))
+				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, tab_line))
 				{
 					std::stringstream iss(LineBuf);
 					std::string name;
@@ -106,7 +111,7 @@ SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 				std::cout << LineBuf << std::endl;
 				std::streampos last_line = fb.tellg();
 
-				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, std::regex(LIGHT_REGEX)))
+				while (std::getline(fb, LineBuf) && std::regex_match(LineBuf, tab_line))
 				{
 					std::stringstream iss(LineBuf);
 					std::string name;
@@ -132,30 +137,29 @@ SceneLoader::SceneLoader(std::string SceneFile, Scene* loading_scene)
 		std::cout << "Scene Failed to load!" << std::endl;
 		exit(-1);
 	}
-	fb.close();
 }
 
-bool SceneLoader::BuildActors(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildActors(std::istream* fb, std::string* LineBuf)
 {
 	return true;
 }
 
-bool SceneLoader::BuildAnimations(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildAnimations(std::istream* fb, std::string* LineBuf)
 {
 	return true;
 }
 
-bool SceneLoader::BuildCamera(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildCamera(std::istream* fb, std::string* LineBuf)
 {
 	return true;
 }
 
-bool SceneLoader::BuildLights(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildLights(std::istream* fb, std::string* LineBuf)
 {
 	return true;
 }
 
-bool SceneLoader::BuildSceneName(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildSceneName(std::istream* fb, std::string* LineBuf)
 {
 	std::getline(*fb, *LineBuf);
 	this->scene->scene_name = *LineBuf;
@@ -163,12 +167,35 @@ bool SceneLoader::BuildSceneName(std::ifstream* fb, std::string* LineBuf)
 	return true;
 }
 
-bool SceneLoader::BuildSkybox(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildSkybox(std::istream* fb, std::string* LineBuf)
 {
+	std::streampos last_line = fb->tellg();
+	const std::regex tab_line(LIGHT_REGEX);
+
+	if (!std::getline(*fb, *LineBuf) || !std::regex_match(*LineBuf, tab_line))
+	{
+		fb->seekg(last_line);
+		return true;
+	}
+
+	// Either the six faces (+X, -X, +Y, -Y, +Z, -Z) or one cooked cube map
+	std::stringstream iss(*LineBuf);
+	std::vector<std::string> faces;
+	std::string face;
+	while (iss >> face)
+		faces.push_back(face);
+
+	if (faces.size() != 1 && faces.size() != TEXTURE_CUBE_FACES)
+	{
+		std::cerr << "Skybox needs " << TEXTURE_CUBE_FACES << " faces or one cube map, not " << faces.size() << std::endl;
+		return false;
+	}
+	std::cout << "Skybox: " << faces[0] << (faces.size() > 1 ? " ..." : "") << std::endl;
+	scene->setSkybox(faces);
 	return true;
 }
 
-bool SceneLoader::BuildStatics(std::ifstream* fb, std::string* LineBuf)
+bool SceneLoader::BuildStatics(std::istream* fb, std::string* LineBuf)
 {
 	return true;
 }
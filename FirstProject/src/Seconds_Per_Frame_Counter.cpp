@@ -1,18 +1,149 @@
 #include "../include/Seconds_Per_Frame_Counter.h"
+#include "../include/Profiler.h"
 
-SPF_Counter::SPF_Counter(bool p_report)
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Number of exact buckets, and linear buckets per power of two above them
+#define SUB_BUCKETS (1u << FRAME_HISTOGRAM_SUB_BITS)
+#define HALF_SUB_BUCKETS (SUB_BUCKETS / 2)
+
+Frame_Histogram::Frame_Histogram()
+{
+	buckets.resize(SUB_BUCKETS + (FRAME_HISTOGRAM_MAX_BITS - FRAME_HISTOGRAM_SUB_BITS) * HALF_SUB_BUCKETS, 0);
+	clear();
+}
+
+void Frame_Histogram::add(double milliseconds)
+{
+	uint64_t microseconds = milliseconds > 0 ? static_cast<uint64_t>(milliseconds * 1000.0) : 0;
+
+	buckets[bucket_index(microseconds)]++;
+	total++;
+	sum += milliseconds;
+	if (milliseconds > largest)
+		largest = milliseconds;
+}
+
+void Frame_Histogram::clear()
+{
+	std::fill(buckets.begin(), buckets.end(), 0);
+	total = 0;
+	sum = 0.0;
+	largest = 0.0;
+}
+
+uint64_t Frame_Histogram::count()
+{
+	return total;
+}
+
+double Frame_Histogram::max()
+{
+	return largest;
+}
+
+double Frame_Histogram::mean()
+{
+	return total > 0 ? sum / total : 0.0;
+}
+
+double Frame_Histogram::percentile(double p)
+{
+	if (total == 0)
+		return 0.0;
+
+	uint64_t target = static_cast<uint64_t>(p * total + 0.5);
+	if (target < 1)
+		target = 1;
+
+	uint64_t seen = 0;
+	for (uint32_t bucket = 0; bucket < buckets.size(); ++bucket)
+	{
+		seen += buckets[bucket];
+		if (seen >= target)
+		{
+			// Never report past the largest frame we actually saw
+			double upper = bucket_upper(bucket);
+			return upper < largest ? upper : largest;
+		}
+	}
+	return largest;
+}
+
+uint32_t Frame_Histogram::bucket_count()
+{
+	return static_cast<uint32_t>(buckets.size());
+}
+
+uint64_t Frame_Histogram::bucket_value(uint32_t bucket)
+{
+	return buckets.at(bucket);
+}
+
+double Frame_Histogram::bucket_lower(uint32_t bucket)
+{
+	if (bucket < SUB_BUCKETS)
+		return bucket / 1000.0;
+
+	uint32_t shift = (bucket - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+	uint64_t sub = (bucket - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+	return (sub << shift) / 1000.0;
+}
+
+double Frame_Histogram::bucket_upper(uint32_t bucket)
+{
+	if (bucket < SUB_BUCKETS)
+		return (bucket + 1) / 1000.0;
+
+	uint32_t shift = (bucket - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+	uint64_t sub = (bucket - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+	return ((sub + 1) << shift) / 1000.0;
+}
+
+uint32_t Frame_Histogram::bucket_index(uint64_t microseconds)
+{
+	if (microseconds < SUB_BUCKETS)
+		return static_cast<uint32_t>(microseconds);
+
+	// Position of the highest set bit picks the power of two, the next bits pick the linear bucket
+	uint32_t msb = 0;
+	while ((microseconds >> (msb + 1)) != 0)
+		msb++;
+
+	uint32_t shift = msb - (FRAME_HISTOGRAM_SUB_BITS - 1);
+	uint32_t index = SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + static_cast<uint32_t>((microseconds >> shift) - HALF_SUB_BUCKETS);
+
+	// Clamp anything absurdly long into the final bucket
+	return index < buckets.size() ? index : static_cast<uint32_t>(buckets.size() - 1);
+}
+
+SPF_Counter::SPF_Counter(bool p_report, double budget_ms)
 {
 	this->lastTime = glfwGetTime();
+	this->lastTick = -1.0;
 	this->nbFrames = 0;
-	this->report = p_report;
+	this->report_fps = p_report;
+	this->budget = budget_ms;
+	this->hitch_count = 0;
+	this->log_hitches = true;
 }
 
 void SPF_Counter::tick()
 {
+	// Frame time since the last tick (the first tick only starts the clock)
+	double now = glfwGetTime();
+	if (lastTick >= 0.0)
+	{
+		record(now - lastTick);
+	}
+	lastTick = now;
+
 	// Measure speed (http://www.opengl-tutorial.org/miscellaneous/an-fps-counter/)
 	nbFrames++;
 	if (delta() >= 1.0) { // If last prinf() was more than 1 sec ago printf and reset timer
-		if(report) printf("%f ms/frame\n", 1000.0 / double(nbFrames));
+		if(report_fps) printf("%f ms/frame\n", 1000.0 / double(nbFrames));
 		nbFrames = 0;
 		lastTime += 1.0;
 	}
@@ -22,4 +153,108 @@ double SPF_Counter::delta()
 {
 	currentTime = glfwGetTime();
 	return currentTime - lastTime;
-}
\ No newline at end of file
+}
+
+void SPF_Counter::record(double frame_seconds)
+{
+	double frame_ms = frame_seconds * 1000.0;
+	frame_times.add(frame_ms);
+
+	if (frame_ms > budget)
+	{
+		hitch_count++;
+		if (log_hitches)
+			log_hitch(frame_ms);
+	}
+}
+
+void SPF_Counter::set_budget(double budget_ms)
+{
+	budget = budget_ms;
+}
+
+double SPF_Counter::get_budget()
+{
+	return budget;
+}
+
+void SPF_Counter::set_hitch_logging(bool enabled)
+{
+	log_hitches = enabled;
+}
+
+uint64_t SPF_Counter::hitches()
+{
+	return hitch_count;
+}
+
+Frame_Histogram* SPF_Counter::histogram()
+{
+	return &frame_times;
+}
+
+std::string SPF_Counter::report()
+{
+	char line[256];
+	snprintf(line, sizeof(line),
+		"Frames: %llu\tmean %.2f ms\tp50 %.2f ms\tp95 %.2f ms\tp99 %.2f ms\tmax %.2f ms\thitches (> %.1f ms): %llu\n",
+		static_cast<unsigned long long>(frame_times.count()),
+		frame_times.mean(),
+		frame_times.percentile(0.50),
+		frame_times.percentile(0.95),
+		frame_times.percentile(0.99),
+		frame_times.max(),
+		budget,
+		static_cast<unsigned long long>(hitch_count));
+	return line;
+}
+
+bool SPF_Counter::export_csv(std::string file_name)
+{
+	std::fstream fs;
+	fs.open(file_name, std::fstream::out);
+	if (!fs.is_open())
+	{
+		std::cerr << "Error saving to: " << file_name << std::endl;
+		return false;
+	}
+
+	fs << "lower_ms,upper_ms,count,cumulative_percent\n";
+
+	uint64_t seen = 0;
+	for (uint32_t bucket = 0; bucket < frame_times.bucket_count(); ++bucket)
+	{
+		uint64_t value = frame_times.bucket_value(bucket);
+		if (value == 0)
+			continue;
+
+		seen += value;
+		fs << frame_times.bucket_lower(bucket) << "," << frame_times.bucket_upper(bucket) << ","
+			<< value << "," << (100.0 * seen) / frame_times.count() << "\n";
+	}
+	fs.close();
+
+	return true;
+}
+
+void SPF_Counter::log_hitch(double frame_ms)
+{
+	printf("Hitch: %.2f ms (budget %.2f ms)\n", frame_ms, budget);
+
+	if (!Profiler::enabled())
+		return;
+
+	// The profiler has already moved on to the next frame by the time we tick
+	uint32_t frame = Profiler::current_frame();
+	if (frame == 0)
+		return;
+
+	// Top level scopes only; the trace has the rest
+	for (auto &event : Profiler::frame_events(frame - 1))
+	{
+		if (event.gpu || event.depth > 1)
+			continue;
+
+		printf("\t%s%s %.2f ms\n", event.depth ? "  " : "", event.name, (event.end - event.begin) / 1.0e6);
+	}
+}
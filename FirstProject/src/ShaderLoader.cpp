@@ -1,4 +1,5 @@
 #include "../include/ShaderLoader.h"
+#include "../include/VFS.h"
 
 ShaderLoader::ShaderLoader()
 {
@@ -47,50 +48,38 @@ GLuint ShaderLoader::build_program(std::pair<std::string, std::string> shaders)
 void ShaderLoader::load_shader(std::string filename)
 {
 	std::cout << "Loading: " << filename << std::endl;
-	std::ifstream in(filename, std::ios::in | std::ios::binary);
+	File_View in;
 
-	if (in) {
-		in.seekg(0, std::ios::end);
-
-		uint64_t length = in.tellg(); // tellg can return up to a long long. It is meant to be able to return the MAXIMUM POSSIBLE filesize the OS can handle.
-		GLchar * ShaderSourceCode = new GLchar[length + 1]; // We are reading a c_string so make room for the \0
-
-		in.seekg(0, std::ios::beg);
-
-		in.read(ShaderSourceCode, length);
-
-		in.close();
-
-		ShaderSourceCode[length] = '\0'; // .read() doesn't add a \0, we need to add it ourselves
+	if (VFS::open(filename, in)) {
+		// GL is given the length, so the source is compiled straight from the file's view with no copy
+		// or terminating \0
+		const GLchar* ShaderSourceCode = reinterpret_cast<const GLchar*>(in.data());
+		GLint length = static_cast<GLint>(in.size());
 
 		// Build Shaders
 		if (std::regex_match(filename, VERT_EXT))
 		{
-			built_shaders->operator[](filename) = build_shader(&ShaderSourceCode, GL_VERTEX_SHADER);
+			built_shaders->operator[](filename) = build_shader(ShaderSourceCode, length, GL_VERTEX_SHADER);
 		}
 		else if (std::regex_match(filename, FRAG_EXT))
 		{
-			built_shaders->operator[](filename) = build_shader(&ShaderSourceCode, GL_FRAGMENT_SHADER);
+			built_shaders->operator[](filename) = build_shader(ShaderSourceCode, length, GL_FRAGMENT_SHADER);
 		}
 		else
 		{
 			printf("ERROR: %s is not .frag nor .vert", filename.c_str());
 		}
-
-		delete[] ShaderSourceCode;
 	}
 	else {
-		std::cout << "ERROR: only " << in.gcount() << " could be read of " << filename << " : SKIPPING" << std::endl;
+		std::cout << "ERROR: " << filename << " could not be read : SKIPPING" << std::endl;
 	}
-
-	in.close();
 }
 
 // Builds a shader of the specified type from the provided source
-GLuint ShaderLoader::build_shader(GLchar** SourceCode, GLuint shader_type)
+GLuint ShaderLoader::build_shader(const GLchar* SourceCode, GLint length, GLuint shader_type)
 {
 	GLuint shader = glCreateShader(shader_type);
-	glShaderSource(shader, 1, (const GLchar**)SourceCode, NULL);
+	glShaderSource(shader, 1, &SourceCode, &length);
 	glCompileShader(shader);
 
 	GLint success;
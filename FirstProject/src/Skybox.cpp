@@ -1,116 +1,142 @@
 #include "../include/Skybox.h"
+#include "../include/Render_Stats.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Texture_Compress.h"
 #include <iostream>
 #include <fstream>
-#ifndef STB_IMAGE_IMPLEMENTATION
 
-#include "../include/stb_image.h"
-#endif
+Skybox::Skybox(const std::vector<std::string> &faces){
+	m_faces = faces;
+	m_levels_left = 0;
+	m_gpu_bytes = 0;
+	m_failed = false;
+	m_program = 0;
+	m_sky_matrix = -1;
+	skyTexId = 0;
+	skyVaoId = CreateVao();
 
-Skybox::Skybox(){
-	std::vector<const GLchar*> faces;
+	// Mip levels of a cube map would otherwise show the seams between faces
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	m_cooking = Image_Decoder::prepare_cube(m_faces);
+}
 
-	faces.push_back("Materials/posx.tga");
-	faces.push_back("Materials/negx.tga");
-	faces.push_back("Materials/posy.png");
-	faces.push_back("Materials/negy.tga");
-	faces.push_back("Materials/posz.tga");
-	faces.push_back("Materials/negz.tga");
-	skyVaoId = CreateVao();
-	skyTexId = loadCubeTex(faces);
+Skybox::~Skybox(){
+	if (skyTexId)
+		glDeleteTextures(1, &skyTexId);
+	glDeleteVertexArrays(1, &skyVaoId);
+	Memory_Stats::release(mSKYBOX, m_gpu_bytes);
 }
 
 
 GLuint Skybox::CreateVao(){
-	//vertex positions
-	float cubeVertices[] = {
-		-1.0f,  1.0f, -1.0f,
-		-1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-
-		-1.0f, -1.0f,  1.0f,
-		-1.0f, -1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f,  1.0f,
-		-1.0f, -1.0f,  1.0f,
-
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-
-		-1.0f, -1.0f,  1.0f,
-		-1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f, -1.0f,  1.0f,
-		-1.0f, -1.0f,  1.0f,
-
-		-1.0f,  1.0f, -1.0f,
-		 1.0f,  1.0f, -1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		-1.0f,  1.0f,  1.0f,
-		-1.0f,  1.0f, -1.0f,
-
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f,  1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f,  1.0f,
-		 1.0f, -1.0f,  1.0f
-	};
-
-  // Create VAO
+	// The triangle's corners come from gl_VertexID, so the VAO has no buffers; core profile only needs one bound
 	GLuint vaoHandle;
 	glGenVertexArrays(1, &vaoHandle);
-	glBindVertexArray(vaoHandle);
-	GLuint buffer[1];
-	glGenBuffers(1, buffer);
-
-	// Set vertex position
-	glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
-	glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    // Un-bind vao
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
 	return vaoHandle;
-
 }
 
 
-GLuint Skybox::loadCubeTex(std::vector<const GLchar*> faces){
+void Skybox::stream(bool block){
+	if (m_failed || (skyTexId && m_levels_left == 0))
+		return;
 
-	GLuint text;
-	glGenTextures(1, &text);
+	if (!skyTexId)
+	{
+		if (!block && !m_cooking.ready())
+			return;
+		if (!m_cooking.wait() || !Texture_Cache::open_cached_cube(m_faces, m_file, m_cube))
+		{
+			std::cerr << "Unable to load skybox: " << (m_faces.empty() ? std::string() : m_faces[0]) << std::endl;
+			m_failed = true;
+			return;
+		}
+
+		glGenTextures(1, &skyTexId);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexId);
+		Texture_Cache::apply_sampling(GL_TEXTURE_CUBE_MAP, m_cube.faces[0].level_count);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		m_levels_left = m_cube.faces[0].level_count;
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexId);
+	}
+
+	// The next level of all six faces; BC1 / BC3 are decoded on the CPU when the driver lacks S3TC
+	uint32_t index = --m_levels_left;
+	Texture_Format format = m_cube.faces[0].format;
+	bool decompress = !Texture_Cache::gpu_supports(format);
+	std::vector<unsigned char> decoded;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (GLuint i = 0; i < TEXTURE_CUBE_FACES; i++)
+	{
+		const Texture_Level &level = m_cube.faces[i].levels[index];
+		if (decompress)
+		{
+			decoded.resize(size_t(level.width) * level.height * 4);
+			Texture_Compress::decode(level.pixels, level.width, level.height, format, decoded.data());
+			Texture_Cache::upload_level(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, TEXTURE_RGBA8, index, level, decoded.data());
+			m_gpu_bytes += decoded.size();
+			Memory_Stats::allocate(mSKYBOX, decoded.size());
+		}
+		else
+		{
+			Texture_Cache::upload_level(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, format, index, level, level.pixels);
+			m_gpu_bytes += level.bytes;
+			Memory_Stats::allocate(mSKYBOX, level.bytes);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, index);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	if (m_levels_left == 0)
+		m_file.close();
+}
+
+void Skybox::flush(){
 	glActiveTexture(GL_TEXTURE0);
+	while (!m_failed && !loaded())
+		stream(true);
+}
+
+bool Skybox::loaded(){
+	return skyTexId && m_levels_left == 0;
+}
 
-	int x,y,n;
-	unsigned char* data;
+void Skybox::draw(GLuint program, const glm::mat4 &view, const glm::mat4 &projection){
+	glActiveTexture(GL_TEXTURE0);
+	stream(false);
+	if (!skyTexId)
+		return;
 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, text);
-	for(GLuint i = 0; i < faces.size(); i++)
+	if (program != m_program)
 	{
-        data = stbi_load( faces[i], &x, &y, &n, 0);
-        glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, x, y, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+		m_program = program;
+		m_sky_matrix = glGetUniformLocation(program, "sky_matrix");
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "texMap"), 0);
+	}
+	else
+	{
+		glUseProgram(program);
 	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-	return text;
+	// Clip space back to a world direction: the camera's rotation only, so the sky never moves with it
+	glm::mat4 sky_matrix = glm::inverse(projection * glm::mat4(glm::mat3(view)));
+	glUniformMatrix4fv(m_sky_matrix, 1, GL_FALSE, glm::value_ptr(sky_matrix));
+
+	// At the far plane (depth 1.0), so LEQUAL keeps only pixels nothing was drawn over and the early
+	// depth test rejects the rest before shading. Nothing needs the sky's depth
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glBindVertexArray(skyVaoId);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexId);
+	glDrawArrays(GL_TRIANGLES, 0, SKYBOX_VERTICES);
+	Render_Stats::draw(SKYBOX_VERTICES);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
 }
@@ -0,0 +1,58 @@
+#include "../include/String_ID.h"
+
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// Function statics so interning during static initialisation is safe
+static std::unordered_map<String_ID, std::string>& string_table()
+{
+	static std::unordered_map<String_ID, std::string> table;
+	return table;
+}
+
+static std::mutex& string_table_lock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+String_ID String_Table::intern(const std::string &name)
+{
+	// Same FNV-1a as string_id_hash, written as a loop for long runtime strings (file paths)
+	String_ID id = STRING_ID_OFFSET;
+	for (char c : name)
+	{
+		id = (id ^ static_cast<uint8_t>(c)) * STRING_ID_PRIME;
+	}
+
+	std::lock_guard<std::mutex> guard(string_table_lock());
+	auto result = string_table().insert(std::make_pair(id, name));
+	if (!result.second && result.first->second != name)
+	{
+		std::cerr << "String ID collision: \"" << name << "\" and \"" << result.first->second << "\" both hash to " << id << std::endl;
+	}
+
+	return id;
+}
+
+std::string String_Table::lookup(String_ID id)
+{
+	std::lock_guard<std::mutex> guard(string_table_lock());
+	auto found = string_table().find(id);
+	if (found != string_table().end())
+	{
+		return found->second;
+	}
+
+	char hex[16];
+	snprintf(hex, sizeof(hex), "0x%08x", id);
+	return hex;
+}
+
+uint32_t String_Table::size()
+{
+	std::lock_guard<std::mutex> guard(string_table_lock());
+	return static_cast<uint32_t>(string_table().size());
+}
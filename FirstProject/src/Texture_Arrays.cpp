@@ -0,0 +1,540 @@
+#include "../include/Texture_Arrays.h"
+#include "../include/Profiler.h"
+#include "../include/Render_Stats.h"
+#include "../include/Resource_Manager.h"
+#include "../include/Texture_Compress.h"
+#include "../include/Texture_Streamer.h"
+#include "../include/VFS.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+struct Texture_Array {
+	GLuint id;
+	// What every layer holds, as the GPU stores it
+	Texture_Format format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t level_count;
+	uint32_t layers;
+	// Slots still using a layer; the array goes with the last
+	uint32_t live;
+	// Largest levels trimmed away: GL level 0 is level dropped of the image
+	uint32_t dropped;
+	uint64_t last_used;
+	// Bound while trimmed, so its levels are loaded back
+	bool wanted;
+	// A level could not be loaded back from the cache; never trimmed again
+	bool pinned;
+};
+
+struct Slot_Entry {
+	uint32_t array;
+	uint32_t layer;
+	bool alive;
+	// Where pack() uploads it from when the driver can't copy between textures
+	std::string file_name;
+	Texture_Usage usage;
+};
+
+struct Array_Stats {
+	uint64_t packs;
+	uint64_t moved;
+	uint64_t skipped_binds;
+	uint64_t levels_dropped;
+	uint64_t levels_restored;
+};
+
+// Released arrays (id 0) and slots are reused, so indices stay put
+static std::vector<Texture_Array> arrays;
+static std::vector<Slot_Entry> slots;
+static std::vector<uint32_t> free_slots;
+static GLuint bound[TEXTURE_ARRAY_UNITS];
+// A texture has been loaded since the last pack()
+static bool unpacked = false;
+// Counts update()s, for last_used
+static uint64_t frame = 0;
+static Array_Stats stats;
+
+static bool same_kind(const Texture_Array &a, const Texture_Array &b)
+{
+	return a.format == b.format && a.width == b.width && a.height == b.height && a.level_count == b.level_count;
+}
+
+static bool kind_order(const Texture_Array &a, const Texture_Array &b)
+{
+	if (a.format != b.format)
+		return a.format < b.format;
+	if (a.width != b.width)
+		return a.width < b.width;
+	if (a.height != b.height)
+		return a.height < b.height;
+	return a.level_count < b.level_count;
+}
+
+static uint32_t new_array()
+{
+	for (uint32_t index = 0; index < arrays.size(); ++index)
+	{
+		if (!arrays[index].id)
+			return index;
+	}
+	arrays.push_back(Texture_Array());
+	return static_cast<uint32_t>(arrays.size() - 1);
+}
+
+static void delete_array(Texture_Array &array)
+{
+	for (GLuint &unit : bound)
+	{
+		if (unit == array.id)
+			unit = 0;
+	}
+	glDeleteTextures(1, &array.id);
+	array.id = 0;
+	array.live = 0;
+}
+
+// Bytes of level of an array's image (one layer)
+static uint64_t level_size(const Texture_Array &array, uint32_t level)
+{
+	return Texture_Cache::level_bytes(array.format, std::max(1u, array.width >> level), std::max(1u, array.height >> level));
+}
+
+static uint64_t array_bytes(const Texture_Array &array)
+{
+	uint64_t total = 0;
+	for (uint32_t level = array.dropped; level < array.level_count; ++level)
+		total += level_size(array, level);
+	return total * array.layers;
+}
+
+// Storage for the levels of kind's image it has not dropped, layers deep
+static GLuint allocate(const Texture_Array &kind, uint32_t layers)
+{
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+	GLenum internal = Texture_Cache::internal_format(kind.format);
+	bool compressed = Texture_Compress::block_bytes(kind.format) != 0;
+	for (uint32_t level = kind.dropped; level < kind.level_count; ++level)
+	{
+		GLint gl_level = level - kind.dropped;
+		GLsizei w = std::max(1u, kind.width >> level), h = std::max(1u, kind.height >> level);
+		if (compressed)
+		{
+			GLsizei bytes = static_cast<GLsizei>(level_size(kind, level) * layers);
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, gl_level, internal, w, h, layers, 0, bytes, nullptr);
+		}
+		else
+		{
+			GLenum layout = kind.format == TEXTURE_RGBA8 ? GL_RGBA : GL_RGB;
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, gl_level, internal, w, h, layers, 0, layout, GL_UNSIGNED_BYTE, nullptr);
+		}
+	}
+	Texture_Cache::apply_sampling(GL_TEXTURE_2D_ARRAY, kind.level_count - kind.dropped);
+	return id;
+}
+
+// Fills levels first to last (exclusive) of layer of the bound array, shaped as kind, from the slot's
+// cache file. False when that is gone
+static bool upload_layer(const Slot_Entry &slot, const Texture_Array &kind, uint32_t layer, uint32_t first, uint32_t last)
+{
+	File_View cached;
+	Texture_Image image;
+	if (!Texture_Cache::open_cached(slot.file_name, slot.usage, cached, image) || image.format != kind.format ||
+		image.width != kind.width || image.height != kind.height || image.level_count != kind.level_count)
+		return false;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLenum internal = Texture_Cache::internal_format(kind.format);
+	for (uint32_t index = first; index < last; ++index)
+	{
+		const Texture_Level &level = image.levels[index];
+		GLint gl_level = index - kind.dropped;
+		if (Texture_Compress::block_bytes(kind.format))
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, gl_level, 0, 0, layer, level.width, level.height, 1, internal,
+				static_cast<GLsizei>(level.bytes), level.pixels);
+		else
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, gl_level, 0, 0, layer, level.width, level.height, 1,
+				kind.format == TEXTURE_RGBA8 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, level.pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return true;
+}
+
+// Moves the textures of slots (each alone in an array of the same kind) into one new array
+static uint32_t pack_group(const std::vector<uint32_t> &group)
+{
+	// Without copy_image each texture is uploaded again, which needs its cache file in the GPU's format
+	std::vector<uint32_t> members;
+	for (uint32_t slot : group)
+	{
+		if (GLEW_ARB_copy_image || Texture_Cache::gpu_supports(arrays[slots[slot].array].format))
+			members.push_back(slot);
+	}
+	if (members.size() < 2)
+		return 0;
+
+	Texture_Array kind = arrays[slots[members[0]].array];
+	GLuint id = allocate(kind, static_cast<uint32_t>(members.size()));
+
+	uint32_t layer = 0;
+	for (uint32_t slot : members)
+	{
+		Slot_Entry &entry = slots[slot];
+		Texture_Array &single = arrays[entry.array];
+		if (GLEW_ARB_copy_image)
+		{
+			uint32_t w = kind.width, h = kind.height;
+			for (uint32_t level = 0; level < kind.level_count; ++level)
+			{
+				glCopyImageSubData(single.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, id, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1);
+				w = std::max(1u, w / 2);
+				h = std::max(1u, h / 2);
+			}
+		}
+		else if (!upload_layer(entry, kind, layer, 0, kind.level_count))
+		{
+			continue;
+		}
+
+		delete_array(single);
+		entry.layer = layer++;
+		// Index of the new array is settled below, once delete_array has freed the singles' entries
+		entry.array = UINT32_MAX;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if (layer == 0)
+	{
+		glDeleteTextures(1, &id);
+		return 0;
+	}
+
+	uint32_t index = new_array();
+	kind.id = id;
+	kind.layers = static_cast<uint32_t>(members.size());
+	kind.live = layer;
+	kind.last_used = frame;
+	arrays[index] = kind;
+	for (uint32_t slot : members)
+	{
+		if (slots[slot].array == UINT32_MAX)
+			slots[slot].array = index;
+	}
+	return layer;
+}
+
+// Gives array index storage starting at level first_level of its image: levels it still has are copied
+// across (or uploaded again without copy_image), the others come from the cache. False, with the
+// array left as it was, when a layer's cache can't be read
+static bool resize(uint32_t index, uint32_t first_level)
+{
+	Texture_Array kind = arrays[index];
+	kind.dropped = first_level;
+	kind.id = allocate(kind, kind.layers);
+
+	const Texture_Array &old = arrays[index];
+	uint32_t kept = std::max(old.dropped, first_level);
+	for (const Slot_Entry &entry : slots)
+	{
+		if (!entry.alive || entry.array != index)
+			continue;
+
+		bool filled;
+		if (GLEW_ARB_copy_image)
+		{
+			for (uint32_t level = kept; level < kind.level_count; ++level)
+				glCopyImageSubData(old.id, GL_TEXTURE_2D_ARRAY, level - old.dropped, 0, 0, entry.layer,
+					kind.id, GL_TEXTURE_2D_ARRAY, level - first_level, 0, 0, entry.layer,
+					std::max(1u, kind.width >> level), std::max(1u, kind.height >> level), 1);
+			filled = kept == first_level || upload_layer(entry, kind, entry.layer, first_level, kept);
+		}
+		else
+		{
+			filled = upload_layer(entry, kind, entry.layer, first_level, kind.level_count);
+		}
+
+		if (!filled)
+		{
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+			glDeleteTextures(1, &kind.id);
+			return false;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	delete_array(arrays[index]);
+	arrays[index] = kind;
+	return true;
+}
+
+// Loads one level back into the first array bound while trimmed, smallest level first
+static void restore()
+{
+	for (uint32_t index = 0; index < arrays.size(); ++index)
+	{
+		Texture_Array &array = arrays[index];
+		if (!array.id || !array.wanted)
+			continue;
+
+		if (array.dropped > 0 && resize(index, array.dropped - 1))
+		{
+			stats.levels_restored++;
+		}
+		else if (array.dropped > 0)
+		{
+			std::cerr << "Texture_Arrays: unable to load back the levels of a trimmed texture array\n";
+			array.pinned = true;
+			array.wanted = false;
+		}
+
+		arrays[index].wanted = arrays[index].dropped > 0;
+		return;
+	}
+}
+
+Texture_Slot Texture_Arrays::load(const std::string &file_name, Texture_Usage usage, Texture_Info* info)
+{
+	Texture_Info texture_info;
+	GLuint id = Texture_Streamer::request(file_name, usage, &texture_info, GL_TEXTURE_2D_ARRAY);
+	if (!id)
+		return 0;
+	if (info)
+		*info = texture_info;
+
+	uint32_t index = new_array();
+	Texture_Array &array = arrays[index];
+	array.id = id;
+	// Without S3TC the upload decoded BC1 / BC3 to RGBA8
+	array.format = Texture_Cache::gpu_supports(texture_info.format) ? texture_info.format : TEXTURE_RGBA8;
+	array.width = texture_info.width;
+	array.height = texture_info.height;
+	array.level_count = texture_info.level_count;
+	array.layers = 1;
+	array.live = 1;
+	array.dropped = 0;
+	array.last_used = frame;
+	array.wanted = false;
+	array.pinned = false;
+
+	uint32_t slot;
+	if (!free_slots.empty())
+	{
+		slot = free_slots.back();
+		free_slots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(slots.size());
+		slots.push_back(Slot_Entry());
+	}
+	Slot_Entry &entry = slots[slot];
+	entry.array = index;
+	entry.layer = 0;
+	entry.alive = true;
+	entry.file_name = file_name;
+	entry.usage = usage;
+
+	unpacked = true;
+	return slot + 1;
+}
+
+void Texture_Arrays::release(Texture_Slot slot)
+{
+	if (slot == 0 || slot > slots.size() || !slots[slot - 1].alive)
+		return;
+
+	Slot_Entry &entry = slots[slot - 1];
+	Texture_Array &array = arrays[entry.array];
+	entry.alive = false;
+	entry.file_name.clear();
+	free_slots.push_back(slot - 1);
+
+	// Layers of a shared array are not handed out again; the array goes when all are released
+	if (--array.live == 0)
+	{
+		Texture_Streamer::cancel(array.id);
+		delete_array(array);
+	}
+}
+
+uint32_t Texture_Arrays::pack()
+{
+	PROFILE_SCOPE("Texture_Arrays::pack");
+	unpacked = false;
+
+	// Slots alone in their array, grouped by kind
+	std::vector<uint32_t> singles;
+	for (uint32_t slot = 0; slot < slots.size(); ++slot)
+	{
+		const Slot_Entry &entry = slots[slot];
+		const Texture_Array &array = arrays[entry.array];
+		if (entry.alive && array.layers == 1 && array.dropped == 0 && !Texture_Streamer::streaming(array.id))
+			singles.push_back(slot);
+	}
+	std::stable_sort(singles.begin(), singles.end(), [](uint32_t a, uint32_t b) {
+		return kind_order(arrays[slots[a].array], arrays[slots[b].array]);
+	});
+
+	uint32_t moved = 0;
+	for (size_t first = 0; first < singles.size();)
+	{
+		size_t last = first + 1;
+		while (last < singles.size() && last - first < TEXTURE_ARRAY_MAX_LAYERS &&
+			same_kind(arrays[slots[singles[first]].array], arrays[slots[singles[last]].array]))
+			++last;
+
+		if (last - first > 1)
+			moved += pack_group(std::vector<uint32_t>(singles.begin() + first, singles.begin() + last));
+		first = last;
+	}
+
+	stats.packs++;
+	stats.moved += moved;
+	return moved;
+}
+
+void Texture_Arrays::update()
+{
+	frame++;
+	if (unpacked && Texture_Streamer::pending() == 0)
+		pack();
+	restore();
+}
+
+uint32_t Texture_Arrays::trim(uint64_t target, uint32_t idle_frames)
+{
+	PROFILE_SCOPE("Texture_Arrays::trim");
+	uint64_t resident = resident_bytes();
+	uint32_t dropped = 0;
+	while (resident > target)
+	{
+		// Least recently bound array with a level above the minimum to give up
+		uint32_t victim = UINT32_MAX;
+		for (uint32_t index = 0; index < arrays.size(); ++index)
+		{
+			const Texture_Array &array = arrays[index];
+			if (!array.id || array.pinned || array.last_used + idle_frames > frame || array.dropped + 1 >= array.level_count)
+				continue;
+			if ((array.width >> (array.dropped + 1)) < TEXTURE_TRIM_MIN || (array.height >> (array.dropped + 1)) < TEXTURE_TRIM_MIN)
+				continue;
+			if (Texture_Streamer::streaming(array.id))
+				continue;
+			if (victim == UINT32_MAX || array.last_used < arrays[victim].last_used)
+				victim = index;
+		}
+		if (victim == UINT32_MAX)
+			break;
+
+		uint64_t before = array_bytes(arrays[victim]);
+		if (!resize(victim, arrays[victim].dropped + 1))
+		{
+			arrays[victim].pinned = true;
+			continue;
+		}
+		resident -= before - array_bytes(arrays[victim]);
+		dropped++;
+	}
+
+	stats.levels_dropped += dropped;
+	return dropped;
+}
+
+uint64_t Texture_Arrays::resident_bytes()
+{
+	uint64_t total = 0;
+	for (const Texture_Array &array : arrays)
+	{
+		if (array.id)
+			total += array_bytes(array);
+	}
+	return total;
+}
+
+GLint Texture_Arrays::bind(GLuint unit, Texture_Slot slot)
+{
+	if (slot == 0 || slot > slots.size())
+		return 0;
+
+	const Slot_Entry &entry = slots[slot - 1];
+	Texture_Array &array = arrays[entry.array];
+	array.last_used = frame;
+	array.wanted = array.dropped > 0 && !array.pinned;
+	GLuint id = array.id;
+	if (bound[unit] != id)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+		bound[unit] = id;
+		Render_Stats::texture_bind();
+	}
+	else
+	{
+		stats.skipped_binds++;
+	}
+	return static_cast<GLint>(entry.layer);
+}
+
+void Texture_Arrays::reset_binds()
+{
+	std::fill(bound, bound + TEXTURE_ARRAY_UNITS, 0);
+}
+
+void Texture_Arrays::assign_units(GLuint program)
+{
+	const char* maps[MATERIAL_TEXTURE_MAPS] = { "diffuse", "specular", "normal" };
+	char name[64];
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "heightmap"), HEIGHTMAP_TEXTURE_UNIT);
+	for (uint32_t material = 0; material < MATERIAL_SLOTS; ++material)
+	{
+		for (uint32_t map = 0; map < MATERIAL_TEXTURE_MAPS; ++map)
+		{
+			snprintf(name, sizeof(name), "material[%u].%s", material, maps[map]);
+			glUniform1i(glGetUniformLocation(program, name), MATERIAL_TEXTURE_UNIT(material, map));
+		}
+	}
+	glUseProgram(0);
+}
+
+std::string Texture_Arrays::report()
+{
+	uint32_t shared = 0, single = 0, layers = 0, live = 0, trimmed = 0;
+	for (const Texture_Array &array : arrays)
+	{
+		if (!array.id)
+			continue;
+		trimmed += array.dropped > 0;
+		if (array.layers > 1)
+		{
+			shared++;
+			layers += array.layers;
+			live += array.live;
+		}
+		else
+		{
+			single++;
+		}
+	}
+
+	char text[512];
+	snprintf(text, sizeof(text),
+		"Texture arrays: %u shared (%u of %u layers in use), %u textures on their own\n"
+		"\t%llu textures packed in %llu passes, %llu binds skipped, %llu made\n"
+		"\t%s resident, %u arrays trimmed (%llu levels dropped, %llu loaded back)\n",
+		shared, live, layers, single,
+		static_cast<unsigned long long>(stats.moved),
+		static_cast<unsigned long long>(stats.packs),
+		static_cast<unsigned long long>(stats.skipped_binds),
+		static_cast<unsigned long long>(Render_Stats::total_texture_binds()),
+		format_bytes(resident_bytes()).c_str(), trimmed,
+		static_cast<unsigned long long>(stats.levels_dropped),
+		static_cast<unsigned long long>(stats.levels_restored));
+	return text;
+}
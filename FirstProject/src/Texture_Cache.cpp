@@ -0,0 +1,738 @@
+#include "../include/Texture_Cache.h"
+#include "../include/File_IO.h"
+#include "../include/Profiler.h"
+#include "../include/Texture_Compress.h"
+#include "../include/VFS.h"
+#include "../include/stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// DDS header fields (see "DDS_HEADER structure" in the DirectX docs). Only what we write is read back
+#define DDS_MAGIC 0x20534444	// "DDS "
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PITCH 0x8
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xfc00
+#define FOUR_CC(a, b, c, d) (uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24))
+// Our own use of the header's reserved words: this tag, then the encode error as a float
+#define DDS_ERROR_TAG FOUR_CC('R', 'M', 'S', 'E')
+
+struct DDS_Pixel_Format {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t four_cc;
+	uint32_t bit_count;
+	uint32_t red_mask;
+	uint32_t green_mask;
+	uint32_t blue_mask;
+	uint32_t alpha_mask;
+};
+
+struct DDS_Header {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitch_or_linear_size;
+	uint32_t depth;
+	uint32_t mip_map_count;
+	uint32_t reserved1[11];
+	DDS_Pixel_Format format;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+static_assert(sizeof(DDS_Header) == 124, "DDS header must match the file layout");
+
+static uint32_t channel_count(Texture_Format format)
+{
+	return (format == TEXTURE_RGBA8 || format == TEXTURE_BC3) ? 4 : 3;
+}
+
+// Whether a cached format is what this usage cooks to
+static bool suits(Texture_Format format, Texture_Usage usage)
+{
+	switch (usage)
+	{
+	case TEXTURE_COLOUR:
+		return format == TEXTURE_BC1 || format == TEXTURE_BC3;
+	case TEXTURE_NORMAL:
+		return format == TEXTURE_BC5;
+	default:
+		return format == TEXTURE_RGB8 || format == TEXTURE_RGBA8;
+	}
+}
+
+// Decodes and compresses an image for its usage. Levels point into decoded or compressed
+static bool cook_image(const std::string &file_name, Texture_Usage usage, std::vector<unsigned char> &decoded,
+	std::vector<unsigned char> &compressed, Texture_Image &image)
+{
+	if (!Texture_Cache::decode(file_name, decoded, image))
+		return false;
+
+	Texture_Format format = Texture_Cache::cooked_format(image, usage);
+	if (format != image.format)
+	{
+		Texture_Image source = image;
+		Texture_Cache::compress(source, format, compressed, image);
+	}
+	return true;
+}
+
+uint64_t Texture_Image::bytes() const
+{
+	uint64_t total = 0;
+	for (uint32_t level = 0; level < level_count; ++level)
+		total += levels[level].bytes;
+	return total;
+}
+
+uint64_t Texture_Image::uncompressed_bytes() const
+{
+	uint64_t total = 0;
+	for (uint32_t level = 0; level < level_count; ++level)
+		total += uint64_t(levels[level].width) * levels[level].height * channel_count(format);
+	return total;
+}
+
+uint64_t Texture_Cube::bytes() const
+{
+	uint64_t total = 0;
+	for (const Texture_Image &face : faces)
+		total += face.bytes();
+	return total;
+}
+
+GLuint Texture_Cache::load(const std::string &file_name, Texture_Usage usage, Texture_Info* info, GLenum target)
+{
+	PROFILE_SCOPE("Texture_Cache::load");
+	Texture_Image image;
+	GLuint texture_id = 0;
+
+	File_View cached;
+	if (open_cached(file_name, usage, cached, image))
+		texture_id = upload(image, target);
+
+	std::vector<unsigned char> decoded, compressed;
+	if (!texture_id)
+	{
+		// Cook it now; if the cache can't be written the chain is still good to upload
+		if (!cook_image(file_name, usage, decoded, compressed, image))
+			return 0;
+		if (!write_dds(cache_path(file_name), image))
+			std::cerr << "Unable to cache texture: " << file_name << std::endl;
+		texture_id = upload(image, target);
+	}
+
+	describe(image, info);
+	return texture_id;
+}
+
+bool Texture_Cache::cook(const std::string &file_name, Texture_Usage usage, Texture_Info* info)
+{
+	Texture_Image image;
+	std::vector<unsigned char> decoded, compressed;
+	if (!cook_image(file_name, usage, decoded, compressed, image) || !write_dds(cache_path(file_name), image))
+		return false;
+
+	describe(image, info);
+	return true;
+}
+
+bool Texture_Cache::open_cached(const std::string &file_name, Texture_Usage usage, File_View &cached, Texture_Image &image)
+{
+	return !stale(file_name) && VFS::open(cache_path(file_name), cached) &&
+		parse_dds(cached.data(), cached.size(), image) && suits(image.format, usage);
+}
+
+void Texture_Cache::describe(const Texture_Image &image, Texture_Info* info)
+{
+	if (!info)
+		return;
+	info->format = image.format;
+	info->width = image.width;
+	info->height = image.height;
+	info->level_count = image.level_count;
+	info->gpu_bytes = image.bytes();
+	info->uncompressed_bytes = image.uncompressed_bytes();
+	info->error = image.error;
+}
+
+bool Texture_Cache::stale(const std::string &file_name)
+{
+	int64_t cached = VFS::modified_time(cache_path(file_name));
+	return cached < 0 || cached < VFS::modified_time(file_name);
+}
+
+std::string Texture_Cache::cache_path(const std::string &file_name)
+{
+	// "./Materials/Barrel.png" -> TEXTURE_CACHE_DIR "Materials_Barrel.png.dds"
+	std::string name = file_name;
+	while (name.compare(0, 2, "./") == 0 || name.compare(0, 2, ".\\") == 0)
+		name.erase(0, 2);
+	std::replace(name.begin(), name.end(), '/', '_');
+	std::replace(name.begin(), name.end(), '\\', '_');
+	std::replace(name.begin(), name.end(), ':', '_');
+	return TEXTURE_CACHE_DIR + name + ".dds";
+}
+
+bool Texture_Cache::cook_cube(const std::vector<std::string> &faces, Texture_Info* info)
+{
+	PROFILE_SCOPE("Texture_Cache::cook_cube");
+	if (faces.size() == 1)
+	{
+		// Already cooked, so there is nothing to cook it from
+		std::cerr << "Unable to load cube map: " << faces[0] << std::endl;
+		return false;
+	}
+	if (faces.size() != TEXTURE_CUBE_FACES)
+	{
+		std::cerr << "A cube map needs " << TEXTURE_CUBE_FACES << " faces, not " << faces.size() << std::endl;
+		return false;
+	}
+
+	// All six are decoded before any is compressed: one translucent face makes the whole map BC3
+	Texture_Cube decoded, cube;
+	std::vector<unsigned char> decoded_storage[TEXTURE_CUBE_FACES], compressed_storage[TEXTURE_CUBE_FACES];
+	Texture_Format format = TEXTURE_BC1;
+	for (uint32_t face = 0; face < TEXTURE_CUBE_FACES; ++face)
+	{
+		Texture_Image &image = decoded.faces[face];
+		if (!decode(faces[face], decoded_storage[face], image))
+			return false;
+		if (image.width != image.height || image.width != decoded.faces[0].width)
+		{
+			std::cerr << "Cube map faces must be square and the same size: " << faces[face] << std::endl;
+			return false;
+		}
+		if (cooked_format(image, TEXTURE_COLOUR) == TEXTURE_BC3)
+			format = TEXTURE_BC3;
+	}
+
+	// The header keeps one error, so every face reports the worst
+	float error = 0;
+	for (uint32_t face = 0; face < TEXTURE_CUBE_FACES; ++face)
+	{
+		compress(decoded.faces[face], format, compressed_storage[face], cube.faces[face]);
+		error = std::max(error, cube.faces[face].error);
+	}
+	for (Texture_Image &face : cube.faces)
+		face.error = error;
+
+	if (!write_dds(cube_cache_path(faces), cube))
+	{
+		std::cerr << "Unable to cache cube map: " << faces[0] << std::endl;
+		return false;
+	}
+
+	describe(cube.faces[0], info);
+	if (info)
+	{
+		info->gpu_bytes = cube.bytes();
+		info->uncompressed_bytes *= TEXTURE_CUBE_FACES;
+	}
+	return true;
+}
+
+bool Texture_Cache::open_cached_cube(const std::vector<std::string> &faces, File_View &cached, Texture_Cube &cube)
+{
+	return !cube_stale(faces) && VFS::open(cube_cache_path(faces), cached) &&
+		parse_dds(cached.data(), cached.size(), cube);
+}
+
+bool Texture_Cache::cube_stale(const std::vector<std::string> &faces)
+{
+	if (faces.size() == 1)
+		return !VFS::exists(faces[0]);
+
+	int64_t cached = VFS::modified_time(cube_cache_path(faces));
+	if (cached < 0)
+		return true;
+	for (const std::string &face : faces)
+	{
+		if (cached < VFS::modified_time(face))
+			return true;
+	}
+	return false;
+}
+
+std::string Texture_Cache::cube_cache_path(const std::vector<std::string> &faces)
+{
+	if (faces.size() == 1)
+		return faces[0];
+
+	// Named after the +X face: TEXTURE_CACHE_DIR "Materials_posx.tga.cube.dds"
+	std::string path = cache_path(faces.empty() ? std::string("cube") : faces[0]);
+	return path.insert(path.size() - 4, ".cube");
+}
+
+bool Texture_Cache::decode(const std::string &file_name, std::vector<unsigned char> &storage, Texture_Image &image)
+{
+	PROFILE_SCOPE("Texture_Cache::decode");
+	// stb_image reads the file from its view, so packed images decode straight out of the pack
+	File_View file;
+	int w, h, comp;
+	if (!VFS::open(file_name, file) || !stbi_info_from_memory(file.data(), static_cast<int>(file.size()), &w, &h, &comp))
+	{
+		std::cerr << "Unable to load texture: " << file_name << std::endl;
+		return false;
+	}
+
+	// Grey images are widened to RGB, grey + alpha to RGBA
+	int channels = (comp == 2 || comp == 4) ? 4 : 3;
+	unsigned char* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &w, &h, &comp, channels);
+	if (!pixels)
+	{
+		std::cerr << "Unable to load texture: " << file_name << std::endl;
+		return false;
+	}
+
+	build_mips(pixels, w, h, channels, storage, image);
+	stbi_image_free(pixels);
+	return true;
+}
+
+void Texture_Cache::build_mips(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t channels,
+	std::vector<unsigned char> &storage, Texture_Image &image)
+{
+	image.width = width;
+	image.height = height;
+	image.format = channels == 4 ? TEXTURE_RGBA8 : TEXTURE_RGB8;
+	image.error = 0;
+
+	// Lay the levels out first so storage is sized once and the pointers stay put
+	size_t offsets[TEXTURE_MAX_LEVELS];
+	size_t total = 0;
+	image.level_count = 0;
+	for (uint32_t w = width, h = height; image.level_count < TEXTURE_MAX_LEVELS; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+	{
+		Texture_Level &level = image.levels[image.level_count];
+		level.width = w;
+		level.height = h;
+		level.bytes = size_t(w) * h * channels;
+		offsets[image.level_count++] = total;
+		total += level.bytes;
+
+		if (w == 1 && h == 1)
+			break;
+	}
+
+	storage.resize(total);
+	memcpy(storage.data(), pixels, image.levels[0].bytes);
+	image.levels[0].pixels = storage.data();
+
+	// Each level averages the block of the level above that covers it (2x2, or 3 wide at odd edges)
+	for (uint32_t index = 1; index < image.level_count; ++index)
+	{
+		const Texture_Level &source = image.levels[index - 1];
+		Texture_Level &target = image.levels[index];
+		unsigned char* out = storage.data() + offsets[index];
+		target.pixels = out;
+
+		for (uint32_t y = 0; y < target.height; ++y)
+		{
+			uint32_t y0 = y * source.height / target.height;
+			uint32_t y1 = std::max(y0 + 1, (y + 1) * source.height / target.height);
+			for (uint32_t x = 0; x < target.width; ++x)
+			{
+				uint32_t x0 = x * source.width / target.width;
+				uint32_t x1 = std::max(x0 + 1, (x + 1) * source.width / target.width);
+				uint32_t area = (x1 - x0) * (y1 - y0);
+
+				for (uint32_t channel = 0; channel < channels; ++channel)
+				{
+					uint32_t sum = 0;
+					for (uint32_t sy = y0; sy < y1; ++sy)
+					{
+						const unsigned char* row = source.pixels + (size_t(sy) * source.width) * channels;
+						for (uint32_t sx = x0; sx < x1; ++sx)
+							sum += row[sx * channels + channel];
+					}
+					*out++ = static_cast<unsigned char>((sum + area / 2) / area);
+				}
+			}
+		}
+	}
+}
+
+Texture_Format Texture_Cache::cooked_format(const Texture_Image &image, Texture_Usage usage)
+{
+	if (usage == TEXTURE_NORMAL)
+		return TEXTURE_BC5;
+	if (usage == TEXTURE_DATA)
+		return image.format;
+
+	// An alpha channel only earns BC3 if some pixel is actually translucent
+	if (image.format == TEXTURE_RGBA8)
+	{
+		const Texture_Level &top = image.levels[0];
+		for (size_t alpha = 3; alpha < top.bytes; alpha += 4)
+		{
+			if (top.pixels[alpha] != 255)
+				return TEXTURE_BC3;
+		}
+	}
+	return TEXTURE_BC1;
+}
+
+void Texture_Cache::compress(const Texture_Image &source, Texture_Format format, std::vector<unsigned char> &storage,
+	Texture_Image &compressed)
+{
+	PROFILE_SCOPE("Texture_Cache::compress");
+	compressed = source;
+	compressed.format = format;
+
+	size_t total = 0;
+	for (uint32_t index = 0; index < source.level_count; ++index)
+	{
+		compressed.levels[index].bytes = level_bytes(format, source.levels[index].width, source.levels[index].height);
+		total += compressed.levels[index].bytes;
+	}
+	storage.resize(total);
+
+	uint32_t channels = channel_count(source.format);
+	unsigned char* out = storage.data();
+	for (uint32_t index = 0; index < source.level_count; ++index)
+	{
+		const Texture_Level &level = source.levels[index];
+		Texture_Compress::encode(level.pixels, level.width, level.height, channels, format, out);
+		compressed.levels[index].pixels = out;
+		out += compressed.levels[index].bytes;
+	}
+
+	// Encode error over the channels the format keeps (BC5: X and Y only)
+	const Texture_Level &top = source.levels[0];
+	std::vector<unsigned char> round_trip(size_t(top.width) * top.height * 4);
+	Texture_Compress::decode(compressed.levels[0].pixels, top.width, top.height, format, round_trip.data());
+
+	uint32_t compared = format == TEXTURE_BC5 ? 2 : std::min(channels, channel_count(format));
+	double squared = 0;
+	size_t pixels = size_t(top.width) * top.height;
+	for (size_t pixel = 0; pixel < pixels; ++pixel)
+	{
+		for (uint32_t channel = 0; channel < compared; ++channel)
+		{
+			double delta = double(top.pixels[pixel * channels + channel]) - round_trip[pixel * 4 + channel];
+			squared += delta * delta;
+		}
+	}
+	compressed.error = static_cast<float>(std::sqrt(squared / (pixels * compared)));
+}
+
+size_t Texture_Cache::level_bytes(Texture_Format format, uint32_t width, uint32_t height)
+{
+	uint32_t block = Texture_Compress::block_bytes(format);
+	if (block)
+		return size_t((width + 3) / 4) * ((height + 3) / 4) * block;
+	return size_t(width) * height * channel_count(format);
+}
+
+const char* Texture_Cache::format_name(Texture_Format format)
+{
+	switch (format)
+	{
+	case TEXTURE_RGB8:
+		return "RGB8";
+	case TEXTURE_RGBA8:
+		return "RGBA8";
+	case TEXTURE_BC1:
+		return "BC1";
+	case TEXTURE_BC3:
+		return "BC3";
+	default:
+		return "BC5";
+	}
+}
+
+// One image, or the faces of a cube map one after another (each with its whole mip chain)
+static bool write_faces(const std::string &file_name, const Texture_Image* faces, uint32_t face_count)
+{
+	MakeDirectory(TEXTURE_CACHE_DIR);
+	const Texture_Image &image = faces[0];
+
+	DDS_Header header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_Header);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+	header.height = image.height;
+	header.width = image.width;
+	header.mip_map_count = image.level_count;
+	header.format.size = sizeof(DDS_Pixel_Format);
+	header.caps = DDSCAPS_TEXTURE | (image.level_count > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+	if (face_count == TEXTURE_CUBE_FACES)
+	{
+		header.caps |= DDSCAPS_COMPLEX;
+		header.caps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+	}
+	header.reserved1[0] = DDS_ERROR_TAG;
+	memcpy(&header.reserved1[1], &image.error, sizeof(image.error));
+
+	if (Texture_Compress::block_bytes(image.format))
+	{
+		header.flags |= DDSD_LINEARSIZE;
+		header.pitch_or_linear_size = static_cast<uint32_t>(image.levels[0].bytes);
+		header.format.flags = DDPF_FOURCC;
+		header.format.four_cc = image.format == TEXTURE_BC1 ? FOUR_CC('D', 'X', 'T', '1') :
+			image.format == TEXTURE_BC3 ? FOUR_CC('D', 'X', 'T', '5') : FOUR_CC('A', 'T', 'I', '2');
+	}
+	else
+	{
+		uint32_t channels = channel_count(image.format);
+		header.flags |= DDSD_PITCH;
+		header.pitch_or_linear_size = image.width * channels;
+		header.format.flags = DDPF_RGB | (channels == 4 ? DDPF_ALPHAPIXELS : 0);
+		header.format.bit_count = channels * 8;
+		header.format.red_mask = 0x000000ff;
+		header.format.green_mask = 0x0000ff00;
+		header.format.blue_mask = 0x00ff0000;
+		header.format.alpha_mask = channels == 4 ? 0xff000000 : 0;
+	}
+
+	// Write beside the real file and rename, so a reader never maps a half written cache
+	std::string temporary = file_name + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+		return false;
+
+	uint32_t magic = DDS_MAGIC;
+	bool written = fwrite(&magic, sizeof(magic), 1, file) == 1 && fwrite(&header, sizeof(header), 1, file) == 1;
+	for (uint32_t face = 0; face < face_count; ++face)
+	{
+		for (uint32_t level = 0; written && level < faces[face].level_count; ++level)
+			written = fwrite(faces[face].levels[level].pixels, 1, faces[face].levels[level].bytes, file) == faces[face].levels[level].bytes;
+	}
+	written = fclose(file) == 0 && written;
+
+	// A failed write leaves the last good cache in place
+	if (!written)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+#if _WIN32 || _WIN64
+	// Windows can't rename over an existing file; elsewhere the rename swaps the cache in atomically
+	remove(file_name.c_str());
+#endif
+	if (rename(temporary.c_str(), file_name.c_str()) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Texture_Cache::write_dds(const std::string &file_name, const Texture_Image &image)
+{
+	return write_faces(file_name, &image, 1);
+}
+
+bool Texture_Cache::write_dds(const std::string &file_name, const Texture_Cube &cube)
+{
+	return write_faces(file_name, cube.faces, TEXTURE_CUBE_FACES);
+}
+
+// Points each of face_count images at its levels in data; the file must hold exactly that many faces
+static bool parse_faces(const unsigned char* data, size_t size, Texture_Image* faces, uint32_t face_count)
+{
+	Texture_Image &image = faces[0];
+	DDS_Header header;
+	uint32_t magic;
+	if (size < sizeof(magic) + sizeof(header))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+
+	const DDS_Pixel_Format &format = header.format;
+	if (magic != DDS_MAGIC || header.size != sizeof(DDS_Header) || format.size != sizeof(DDS_Pixel_Format))
+	{
+		std::cerr << "Not a DDS file" << std::endl;
+		return false;
+	}
+
+	bool cube = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
+	if (cube != (face_count == TEXTURE_CUBE_FACES) ||
+		(cube && (header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES))
+	{
+		std::cerr << (cube ? "DDS cube map where a 2D texture was expected" : "DDS file is not a complete cube map") << std::endl;
+		return false;
+	}
+
+	if (format.flags & DDPF_FOURCC)
+	{
+		if (format.four_cc == FOUR_CC('D', 'X', 'T', '1'))
+			image.format = TEXTURE_BC1;
+		else if (format.four_cc == FOUR_CC('D', 'X', 'T', '5'))
+			image.format = TEXTURE_BC3;
+		else if (format.four_cc == FOUR_CC('A', 'T', 'I', '2') || format.four_cc == FOUR_CC('B', 'C', '5', 'U'))
+			image.format = TEXTURE_BC5;
+		else
+		{
+			std::cerr << "Unsupported DDS compression" << std::endl;
+			return false;
+		}
+	}
+	else if ((format.flags & DDPF_RGB) && format.red_mask == 0x000000ff && format.green_mask == 0x0000ff00 &&
+		format.blue_mask == 0x00ff0000 && (format.bit_count == 24 || format.bit_count == 32))
+	{
+		image.format = format.bit_count == 32 ? TEXTURE_RGBA8 : TEXTURE_RGB8;
+	}
+	else
+	{
+		std::cerr << "Unsupported DDS pixel format" << std::endl;
+		return false;
+	}
+
+	image.width = header.width;
+	image.height = header.height;
+	image.level_count = std::min<uint32_t>(std::max(1u, header.mip_map_count), TEXTURE_MAX_LEVELS);
+	image.error = 0;
+	if (header.reserved1[0] == DDS_ERROR_TAG)
+		memcpy(&image.error, &header.reserved1[1], sizeof(image.error));
+
+	size_t offset = sizeof(magic) + sizeof(header);
+	for (uint32_t face = 0; face < face_count; ++face)
+	{
+		Texture_Image &target = faces[face];
+		if (face > 0)
+			target = image;
+
+		uint32_t w = image.width, h = image.height;
+		for (uint32_t index = 0; index < image.level_count; ++index)
+		{
+			Texture_Level &level = target.levels[index];
+			level.width = w;
+			level.height = h;
+			level.bytes = Texture_Cache::level_bytes(image.format, w, h);
+			level.pixels = data + offset;
+			offset += level.bytes;
+			if (offset > size)
+			{
+				std::cerr << "Truncated DDS file" << std::endl;
+				return false;
+			}
+
+			w = std::max(1u, w / 2);
+			h = std::max(1u, h / 2);
+		}
+	}
+	return true;
+}
+
+bool Texture_Cache::parse_dds(const unsigned char* data, size_t size, Texture_Image &image)
+{
+	return parse_faces(data, size, &image, 1);
+}
+
+bool Texture_Cache::parse_dds(const unsigned char* data, size_t size, Texture_Cube &cube)
+{
+	return parse_faces(data, size, cube.faces, TEXTURE_CUBE_FACES);
+}
+
+GLuint Texture_Cache::upload(const Texture_Image &image, GLenum target)
+{
+	PROFILE_SCOPE("Texture_Cache::upload");
+	GLuint texture_id;
+	glGenTextures(1, &texture_id);
+	glBindTexture(target, texture_id);
+
+	// RGB rows are not 4 byte aligned in general
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	bool decompress = !gpu_supports(image.format);
+	std::vector<unsigned char> decoded;
+	for (uint32_t index = 0; index < image.level_count; ++index)
+	{
+		const Texture_Level &level = image.levels[index];
+		if (decompress)
+		{
+			decoded.resize(size_t(level.width) * level.height * 4);
+			Texture_Compress::decode(level.pixels, level.width, level.height, image.format, decoded.data());
+			upload_level(target, TEXTURE_RGBA8, index, level, decoded.data());
+		}
+		else
+		{
+			upload_level(target, image.format, index, level, level.pixels);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	apply_sampling(target, image.level_count);
+	glBindTexture(target, 0);
+	return texture_id;
+}
+
+void Texture_Cache::upload_level(GLenum target, Texture_Format format, uint32_t index, const Texture_Level &level, const void* pixels)
+{
+	GLenum internal = internal_format(format);
+	if (Texture_Compress::block_bytes(format))
+	{
+		GLsizei bytes = static_cast<GLsizei>(level.bytes);
+		if (target == GL_TEXTURE_2D_ARRAY)
+			glCompressedTexImage3D(target, index, internal, level.width, level.height, 1, 0, bytes, pixels);
+		else
+			glCompressedTexImage2D(target, index, internal, level.width, level.height, 0, bytes, pixels);
+	}
+	else
+	{
+		GLenum layout = format == TEXTURE_RGBA8 ? GL_RGBA : GL_RGB;
+		if (target == GL_TEXTURE_2D_ARRAY)
+			glTexImage3D(target, index, internal, level.width, level.height, 1, 0, layout, GL_UNSIGNED_BYTE, pixels);
+		else
+			glTexImage2D(target, index, internal, level.width, level.height, 0, layout, GL_UNSIGNED_BYTE, pixels);
+	}
+}
+
+GLenum Texture_Cache::internal_format(Texture_Format format)
+{
+	switch (format)
+	{
+	case TEXTURE_RGB8:
+		return GL_RGB8;
+	case TEXTURE_RGBA8:
+		return GL_RGBA8;
+	case TEXTURE_BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TEXTURE_BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default:
+		return GL_COMPRESSED_RG_RGTC2;
+	}
+}
+
+bool Texture_Cache::gpu_supports(Texture_Format format)
+{
+	return (format != TEXTURE_BC1 && format != TEXTURE_BC3) || GLEW_EXT_texture_compression_s3tc;
+}
+
+void Texture_Cache::apply_sampling(GLenum target, uint32_t level_count)
+{
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+
+	if (GLEW_EXT_texture_filter_anisotropic)
+	{
+		static GLfloat driver_limit = 0;
+		if (driver_limit == 0)
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &driver_limit);
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(TEXTURE_ANISOTROPY, driver_limit));
+	}
+}
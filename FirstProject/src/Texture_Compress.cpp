@@ -0,0 +1,388 @@
+#include "../include/Texture_Compress.h"
+#include "../include/Job_System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Least squares passes over the BC1 endpoints after the first fit
+#define BC1_REFINE_PASSES 2
+
+// Share of endpoint 0 in each BC1 palette entry (4 colour mode)
+static const float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+static uint16_t pack_565(const float colour[3])
+{
+	int r = static_cast<int>(std::floor(std::min(std::max(colour[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f));
+	int g = static_cast<int>(std::floor(std::min(std::max(colour[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f));
+	int b = static_cast<int>(std::floor(std::min(std::max(colour[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f));
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t packed, int colour[3])
+{
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	colour[0] = (r << 3) | (r >> 2);
+	colour[1] = (g << 2) | (g >> 4);
+	colour[2] = (b << 3) | (b >> 2);
+}
+
+// The four (or three plus transparent black) colours a BC1 block can use
+static void bc1_palette(uint16_t c0, uint16_t c1, int palette[4][4])
+{
+	unpack_565(c0, palette[0]);
+	unpack_565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = 255;
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		if (c0 > c1)
+		{
+			palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+			palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+		}
+		else
+		{
+			palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+			palette[3][channel] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = c0 > c1 ? 255 : 0;
+}
+
+// Nearest palette entry per pixel; returns the packed indices and the summed squared error
+static uint32_t bc1_indices(const unsigned char rgba[64], uint16_t c0, uint16_t c1, uint32_t &error)
+{
+	int palette[4][4];
+	bc1_palette(c0, c1, palette);
+
+	uint32_t indices = 0;
+	error = 0;
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		uint32_t best = 0, best_distance = ~0u;
+		for (uint32_t entry = 0; entry < 4; ++entry)
+		{
+			uint32_t distance = 0;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				int delta = rgba[pixel * 4 + channel] - palette[entry][channel];
+				distance += delta * delta;
+			}
+			if (distance < best_distance)
+			{
+				best_distance = distance;
+				best = entry;
+			}
+		}
+		indices |= best << (pixel * 2);
+		error += best_distance;
+	}
+	return indices;
+}
+
+uint32_t Texture_Compress::block_bytes(Texture_Format format)
+{
+	switch (format)
+	{
+	case TEXTURE_BC1:
+		return 8;
+	case TEXTURE_BC3:
+	case TEXTURE_BC5:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+void Texture_Compress::encode_bc1(const unsigned char rgba[64], unsigned char block[8])
+{
+	float mean[3] = { 0, 0, 0 };
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		for (int channel = 0; channel < 3; ++channel)
+			mean[channel] += rgba[pixel * 4 + channel] / 16.0f;
+	}
+
+	// Principal axis of the colours by power iteration on their covariance
+	float covariance[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		float r = rgba[pixel * 4] - mean[0], g = rgba[pixel * 4 + 1] - mean[1], b = rgba[pixel * 4 + 2] - mean[2];
+		covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+		covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+	}
+	float axis[3] = { 1, 1, 1 };
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+		float length = std::max(std::fabs(next[0]), std::max(std::fabs(next[1]), std::fabs(next[2])));
+		if (length < 1e-6f)
+			break;
+		for (int channel = 0; channel < 3; ++channel)
+			axis[channel] = next[channel] / length;
+	}
+
+	// Extremes along the axis are the first guess at the endpoints
+	float low = 1e30f, high = -1e30f;
+	float endpoints[2][3];
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		float projection = 0;
+		for (int channel = 0; channel < 3; ++channel)
+			projection += (rgba[pixel * 4 + channel] - mean[channel]) * axis[channel];
+		if (projection > high)
+		{
+			high = projection;
+			for (int channel = 0; channel < 3; ++channel)
+				endpoints[0][channel] = rgba[pixel * 4 + channel];
+		}
+		if (projection < low)
+		{
+			low = projection;
+			for (int channel = 0; channel < 3; ++channel)
+				endpoints[1][channel] = rgba[pixel * 4 + channel];
+		}
+	}
+
+	uint16_t best_c0 = 0, best_c1 = 0;
+	uint32_t best_indices = 0, best_error = ~0u;
+	for (int pass = 0; pass <= BC1_REFINE_PASSES; ++pass)
+	{
+		uint16_t c0 = pack_565(endpoints[0]);
+		uint16_t c1 = pack_565(endpoints[1]);
+		// Keep to four colour mode: c0 > c1 (equal endpoints mean every pixel is that colour anyway)
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		uint32_t error = 0;
+		uint32_t indices = 0;
+		if (c0 == c1)
+		{
+			// One colour: every index 0, since index 3 is transparent black when the endpoints match
+			int colour[3];
+			unpack_565(c0, colour);
+			for (int pixel = 0; pixel < 16; ++pixel)
+			{
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					int delta = rgba[pixel * 4 + channel] - colour[channel];
+					error += delta * delta;
+				}
+			}
+		}
+		else
+		{
+			indices = bc1_indices(rgba, c0, c1, error);
+		}
+
+		if (error < best_error)
+		{
+			best_error = error;
+			best_c0 = c0;
+			best_c1 = c1;
+			best_indices = indices;
+		}
+		if (best_error == 0 || c0 == c1 || pass == BC1_REFINE_PASSES)
+			break;
+
+		// Solve for the endpoints that best fit the chosen indices
+		float aa = 0, ab = 0, bb = 0;
+		float ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+		for (int pixel = 0; pixel < 16; ++pixel)
+		{
+			float weight = BC1_WEIGHTS[(indices >> (pixel * 2)) & 3];
+			aa += weight * weight;
+			ab += weight * (1 - weight);
+			bb += (1 - weight) * (1 - weight);
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				ax[channel] += weight * rgba[pixel * 4 + channel];
+				bx[channel] += (1 - weight) * rgba[pixel * 4 + channel];
+			}
+		}
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+			break;
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			endpoints[0][channel] = (ax[channel] * bb - bx[channel] * ab) / determinant;
+			endpoints[1][channel] = (bx[channel] * aa - ax[channel] * ab) / determinant;
+		}
+	}
+
+	block[0] = best_c0 & 0xff;
+	block[1] = best_c0 >> 8;
+	block[2] = best_c1 & 0xff;
+	block[3] = best_c1 >> 8;
+	for (int byte = 0; byte < 4; ++byte)
+		block[4 + byte] = (best_indices >> (byte * 8)) & 0xff;
+}
+
+void Texture_Compress::decode_bc1(const unsigned char block[8], unsigned char rgba[64])
+{
+	uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	int palette[4][4];
+	bc1_palette(c0, c1, palette);
+
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		const int* colour = palette[(indices >> (pixel * 2)) & 3];
+		for (int channel = 0; channel < 4; ++channel)
+			rgba[pixel * 4 + channel] = static_cast<unsigned char>(colour[channel]);
+	}
+}
+
+void Texture_Compress::encode_bc4(const unsigned char values[16], unsigned char block[8])
+{
+	int low = 255, high = 0;
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		low = std::min<int>(low, values[pixel]);
+		high = std::max<int>(high, values[pixel]);
+	}
+
+	// high > low selects the 8 value ramp: index 0 is high, 1 is low, 2 - 7 step from high to low
+	block[0] = static_cast<unsigned char>(high);
+	block[1] = static_cast<unsigned char>(low);
+	uint64_t indices = 0;
+	if (high > low)
+	{
+		for (int pixel = 0; pixel < 16; ++pixel)
+		{
+			int step = ((values[pixel] - low) * 14 + (high - low)) / ((high - low) * 2);
+			uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+			indices |= index << (pixel * 3);
+		}
+	}
+	for (int byte = 0; byte < 6; ++byte)
+		block[2 + byte] = (indices >> (byte * 8)) & 0xff;
+}
+
+void Texture_Compress::decode_bc4(const unsigned char block[8], unsigned char values[16])
+{
+	int ramp[8];
+	ramp[0] = block[0];
+	ramp[1] = block[1];
+	if (ramp[0] > ramp[1])
+	{
+		for (int index = 2; index < 8; ++index)
+			ramp[index] = ((8 - index) * ramp[0] + (index - 1) * ramp[1]) / 7;
+	}
+	else
+	{
+		for (int index = 2; index < 6; ++index)
+			ramp[index] = ((6 - index) * ramp[0] + (index - 1) * ramp[1]) / 5;
+		ramp[6] = 0;
+		ramp[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int byte = 0; byte < 6; ++byte)
+		indices |= static_cast<uint64_t>(block[2 + byte]) << (byte * 8);
+	for (int pixel = 0; pixel < 16; ++pixel)
+		values[pixel] = static_cast<unsigned char>(ramp[(indices >> (pixel * 3)) & 7]);
+}
+
+void Texture_Compress::encode(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t channels,
+	Texture_Format format, unsigned char* blocks)
+{
+	uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+	uint32_t bytes = block_bytes(format);
+
+	Job_System::parallel_for(blocks_y, TEXTURE_ENCODE_ROWS, [&](uint32_t first, uint32_t last) {
+		unsigned char rgba[64];
+		unsigned char channel_values[16];
+		for (uint32_t by = first; by < last; ++by)
+		{
+			for (uint32_t bx = 0; bx < blocks_x; ++bx)
+			{
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					uint32_t x = std::min(bx * 4 + pixel % 4, width - 1);
+					uint32_t y = std::min(by * 4 + pixel / 4, height - 1);
+					const unsigned char* source = pixels + (size_t(y) * width + x) * channels;
+					rgba[pixel * 4] = source[0];
+					rgba[pixel * 4 + 1] = source[1];
+					rgba[pixel * 4 + 2] = source[2];
+					rgba[pixel * 4 + 3] = channels == 4 ? source[3] : 255;
+				}
+
+				unsigned char* block = blocks + (size_t(by) * blocks_x + bx) * bytes;
+				if (format == TEXTURE_BC1)
+				{
+					encode_bc1(rgba, block);
+				}
+				else if (format == TEXTURE_BC3)
+				{
+					for (uint32_t pixel = 0; pixel < 16; ++pixel)
+						channel_values[pixel] = rgba[pixel * 4 + 3];
+					encode_bc4(channel_values, block);
+					encode_bc1(rgba, block + 8);
+				}
+				else if (format == TEXTURE_BC5)
+				{
+					for (uint32_t half = 0; half < 2; ++half)
+					{
+						for (uint32_t pixel = 0; pixel < 16; ++pixel)
+							channel_values[pixel] = rgba[pixel * 4 + half];
+						encode_bc4(channel_values, block + half * 8);
+					}
+				}
+			}
+		}
+	});
+}
+
+void Texture_Compress::decode(const unsigned char* blocks, uint32_t width, uint32_t height, Texture_Format format, unsigned char* rgba)
+{
+	uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+	uint32_t bytes = block_bytes(format);
+	unsigned char decoded[64];
+	unsigned char channel_values[16];
+
+	for (uint32_t by = 0; by < blocks_y; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocks_x; ++bx)
+		{
+			const unsigned char* block = blocks + (size_t(by) * blocks_x + bx) * bytes;
+			if (format == TEXTURE_BC1)
+			{
+				decode_bc1(block, decoded);
+			}
+			else if (format == TEXTURE_BC3)
+			{
+				decode_bc1(block + 8, decoded);
+				decode_bc4(block, channel_values);
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+					decoded[pixel * 4 + 3] = channel_values[pixel];
+			}
+			else if (format == TEXTURE_BC5)
+			{
+				for (uint32_t half = 0; half < 2; ++half)
+				{
+					decode_bc4(block + half * 8, channel_values);
+					for (uint32_t pixel = 0; pixel < 16; ++pixel)
+						decoded[pixel * 4 + half] = channel_values[pixel];
+				}
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					decoded[pixel * 4 + 2] = 0;
+					decoded[pixel * 4 + 3] = 255;
+				}
+			}
+
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				uint32_t x = bx * 4 + pixel % 4, y = by * 4 + pixel / 4;
+				if (x < width && y < height)
+					memcpy(rgba + (size_t(y) * width + x) * 4, decoded + pixel * 4, 4);
+			}
+		}
+	}
+}
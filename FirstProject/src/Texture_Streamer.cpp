@@ -0,0 +1,374 @@
+#include "../include/Texture_Streamer.h"
+#include "../include/Job_System.h"
+#include "../include/Profiler.h"
+#include "../include/Resource_Manager.h"
+#include "../include/VFS.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+// A texture with levels still to stream. Lives until its last staged level has been uploaded
+struct Stream_Texture {
+	GLuint texture;
+	GLenum target;
+	File_View file;
+	Texture_Image image;
+	// Levels from here down to 0 have not been staged yet (next_level - 1 is next)
+	uint32_t next_level;
+	// Levels sitting in buffers
+	uint32_t staged;
+	bool cancelled;
+};
+
+// One pixel buffer of the ring. Free when it holds no level and has no fence
+struct Stream_Buffer {
+	GLuint buffer;
+	size_t capacity;
+	GLsync fence;
+	Stream_Texture* texture;
+	uint32_t level;
+	Job* copy;
+	std::atomic<bool> copied;
+};
+
+struct Copy_Job {
+	Stream_Buffer* buffer;
+	void* target;
+	const unsigned char* source;
+	size_t bytes;
+};
+
+struct Stream_Stats {
+	uint64_t textures;
+	uint64_t levels;
+	uint64_t bytes;
+	uint64_t max_frame_bytes;
+	uint64_t busy_frames;
+	uint64_t buffer_bytes;
+};
+
+static Stream_Buffer buffers[TEXTURE_STREAM_BUFFERS];
+// Textures still being staged, in request order; only the front one is staged from
+static std::deque<Stream_Texture*> waiting;
+// Buffers holding a level, in the order they were staged (uploads keep that order so each texture
+// gains its levels from small to large)
+static std::deque<Stream_Buffer*> staged;
+static Stream_Stats stats;
+
+static void copy_level(Job*, const void* data)
+{
+	Copy_Job copy;
+	memcpy(&copy, data, sizeof(copy));
+	memcpy(copy.target, copy.source, copy.bytes);
+	copy.buffer->copied.store(true, std::memory_order_release);
+}
+
+// Last reference to a texture's stream gone
+static void finish(Stream_Texture* texture)
+{
+	if (texture->staged == 0 && (texture->cancelled || texture->next_level == 0))
+		delete texture;
+}
+
+// Frees buffers whose uploads the GPU has consumed
+static void retire(bool block)
+{
+	for (Stream_Buffer &buffer : buffers)
+	{
+		if (!buffer.fence)
+			continue;
+
+		GLenum status = glClientWaitSync(buffer.fence, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, block ? GL_TIMEOUT_IGNORED : 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+		{
+			glDeleteSync(buffer.fence);
+			buffer.fence = 0;
+		}
+	}
+}
+
+// Uploads staged levels whose copies are done, oldest first
+static uint32_t upload(bool block)
+{
+	uint32_t uploaded = 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (!staged.empty())
+	{
+		Stream_Buffer &buffer = *staged.front();
+		if (!buffer.copied.load(std::memory_order_acquire))
+		{
+			if (!block)
+				break;
+			Job_System::wait(buffer.copy);
+		}
+		staged.pop_front();
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+		bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+
+		Stream_Texture* texture = buffer.texture;
+		const Texture_Level &level = texture->image.levels[buffer.level];
+		if (!texture->cancelled)
+		{
+			glBindTexture(texture->target, texture->texture);
+			if (intact)
+			{
+				Texture_Cache::upload_level(texture->target, texture->image.format, buffer.level, level, nullptr);
+			}
+			else
+			{
+				// The buffer's contents were lost (e.g. a mode switch), so send this level from the file
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				Texture_Cache::upload_level(texture->target, texture->image.format, buffer.level, level, level.pixels);
+			}
+			glTexParameteri(texture->target, GL_TEXTURE_BASE_LEVEL, buffer.level);
+			glBindTexture(texture->target, 0);
+
+			buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			++stats.levels;
+			stats.bytes += level.bytes;
+			++uploaded;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		buffer.texture = nullptr;
+		texture->staged--;
+		finish(texture);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return uploaded;
+}
+
+// Maps free buffers and sets jobs copying the next levels into them, up to budget bytes
+static uint64_t stage(uint64_t budget)
+{
+	uint64_t total = 0;
+	bool jobs = Job_System::running() && Job_System::thread_count() > 1;
+	while (!waiting.empty())
+	{
+		Stream_Buffer* free_buffer = nullptr;
+		for (Stream_Buffer &buffer : buffers)
+		{
+			if (!buffer.texture && !buffer.fence)
+			{
+				free_buffer = &buffer;
+				break;
+			}
+		}
+		if (!free_buffer)
+			break;
+
+		Stream_Texture* texture = waiting.front();
+		uint32_t index = texture->next_level - 1;
+		const Texture_Level &level = texture->image.levels[index];
+		// A level over the budget still goes, on its own
+		if (total && total + level.bytes > budget)
+			break;
+
+		Stream_Buffer &buffer = *free_buffer;
+		if (!buffer.buffer)
+			glGenBuffers(1, &buffer.buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+		if (buffer.capacity < level.bytes)
+		{
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, level.bytes, nullptr, GL_STREAM_DRAW);
+			stats.buffer_bytes += level.bytes - buffer.capacity;
+			buffer.capacity = level.bytes;
+		}
+		// The fence has signalled, so nothing reads the buffer and mapping need not wait for the driver
+		void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, level.bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (!target)
+			break;
+
+		buffer.texture = texture;
+		buffer.level = index;
+		buffer.copied.store(false, std::memory_order_relaxed);
+		Copy_Job copy = { &buffer, target, level.pixels, level.bytes };
+		if (jobs)
+		{
+			buffer.copy = Job_System::create(copy_level, &copy, sizeof(copy));
+			Job_System::run(buffer.copy);
+		}
+		else
+		{
+			buffer.copy = nullptr;
+			copy_level(nullptr, &copy);
+		}
+		staged.push_back(&buffer);
+
+		texture->staged++;
+		if (--texture->next_level == 0)
+			waiting.pop_front();
+		total += level.bytes;
+	}
+	return total;
+}
+
+GLuint Texture_Streamer::request(const std::string &file_name, Texture_Usage usage, Texture_Info* info, GLenum target)
+{
+	PROFILE_SCOPE("Texture_Streamer::request");
+	Stream_Texture* texture = new Stream_Texture();
+	if (!Texture_Cache::open_cached(file_name, usage, texture->file, texture->image) ||
+		!Texture_Cache::gpu_supports(texture->image.format))
+	{
+		// Cooked now (first use) or decoded on the CPU; either way it goes up in one piece
+		delete texture;
+		return Texture_Cache::load(file_name, usage, info, target);
+	}
+	Texture_Cache::describe(texture->image, info);
+
+	const Texture_Image &image = texture->image;
+	texture->target = target;
+	glGenTextures(1, &texture->texture);
+	glBindTexture(target, texture->texture);
+	Texture_Cache::apply_sampling(target, image.level_count);
+
+	// The smallest level always, then every level up to the tail size, so it can be sampled right away
+	uint32_t level = image.level_count - 1;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	Texture_Cache::upload_level(target, image.format, level, image.levels[level], image.levels[level].pixels);
+	while (level > 0 && image.levels[level - 1].width <= TEXTURE_STREAM_TAIL && image.levels[level - 1].height <= TEXTURE_STREAM_TAIL)
+	{
+		--level;
+		Texture_Cache::upload_level(target, image.format, level, image.levels[level], image.levels[level].pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, level);
+	glBindTexture(target, 0);
+
+	GLuint texture_id = texture->texture;
+	texture->next_level = level;
+	texture->staged = 0;
+	texture->cancelled = false;
+	if (level == 0)
+	{
+		delete texture;
+		return texture_id;
+	}
+
+	waiting.push_back(texture);
+	++stats.textures;
+	return texture_id;
+}
+
+void Texture_Streamer::update(uint64_t budget)
+{
+	PROFILE_SCOPE("Texture_Streamer::update");
+	retire(false);
+	upload(false);
+	uint64_t bytes = stage(budget);
+
+	stats.max_frame_bytes = std::max(stats.max_frame_bytes, bytes);
+	stats.busy_frames += bytes > 0;
+}
+
+void Texture_Streamer::flush()
+{
+	PROFILE_SCOPE("Texture_Streamer::flush");
+	while (!waiting.empty() || !staged.empty())
+	{
+		retire(true);
+		upload(true);
+		stage(UINT64_MAX);
+	}
+	retire(true);
+}
+
+void Texture_Streamer::cancel(GLuint texture)
+{
+	for (auto it = waiting.begin(); it != waiting.end(); ++it)
+	{
+		if ((*it)->texture == texture)
+		{
+			Stream_Texture* stream = *it;
+			waiting.erase(it);
+			stream->cancelled = true;
+			finish(stream);
+			return;
+		}
+	}
+
+	// Fully staged: the buffers still holding its levels skip the upload
+	for (Stream_Buffer* buffer : staged)
+	{
+		if (buffer->texture->texture == texture)
+			buffer->texture->cancelled = true;
+	}
+}
+
+void Texture_Streamer::release()
+{
+	std::deque<Stream_Texture*> dropped;
+	dropped.swap(waiting);
+	for (Stream_Texture* texture : dropped)
+	{
+		texture->cancelled = true;
+		finish(texture);
+	}
+
+	// Copies may still be writing into mapped buffers; upload() waits for them and unmaps
+	for (Stream_Buffer* buffer : staged)
+		buffer->texture->cancelled = true;
+	upload(true);
+
+	for (Stream_Buffer &buffer : buffers)
+	{
+		if (buffer.fence)
+			glDeleteSync(buffer.fence);
+		if (buffer.buffer)
+			glDeleteBuffers(1, &buffer.buffer);
+		buffer.fence = 0;
+		buffer.buffer = 0;
+		buffer.capacity = 0;
+	}
+	stats.buffer_bytes = 0;
+}
+
+bool Texture_Streamer::streaming(GLuint texture)
+{
+	for (const Stream_Texture* stream : waiting)
+	{
+		if (stream->texture == texture)
+			return true;
+	}
+	for (const Stream_Buffer* buffer : staged)
+	{
+		if (buffer->texture->texture == texture && !buffer->texture->cancelled)
+			return true;
+	}
+	return false;
+}
+
+uint32_t Texture_Streamer::pending()
+{
+	// Fully staged textures are only reachable through their buffers
+	std::vector<const Stream_Texture*> textures(waiting.begin(), waiting.end());
+	for (const Stream_Buffer* buffer : staged)
+	{
+		if (std::find(textures.begin(), textures.end(), buffer->texture) == textures.end())
+			textures.push_back(buffer->texture);
+	}
+	return static_cast<uint32_t>(textures.size());
+}
+
+std::string Texture_Streamer::report()
+{
+	char text[512];
+	snprintf(text, sizeof(text),
+		"Texture streaming: %llu textures, %llu levels, %s over %llu frames (max %s a frame), %u pending\n"
+		"\tPixel buffers: %s\n",
+		static_cast<unsigned long long>(stats.textures),
+		static_cast<unsigned long long>(stats.levels),
+		format_bytes(stats.bytes).c_str(),
+		static_cast<unsigned long long>(stats.busy_frames),
+		format_bytes(stats.max_frame_bytes).c_str(),
+		pending(),
+		format_bytes(stats.buffer_bytes).c_str());
+	return text;
+}
@@ -0,0 +1,385 @@
+#include "../include/Transform_Store.h"
+#include "../include/Job_System.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Marks parent_index entries for nodes placed directly in the scene
+static const uint32_t NO_PARENT = 0xFFFFFFFF;
+
+Transform_Store::Transform_Store()
+{
+	levels_stale = false;
+	dirty_count = 0;
+	pass = 0;
+}
+
+Transform_Handle Transform_Store::create(glm::vec3 location, glm::quat rotation, glm::vec3 scale, Transform_Handle parent)
+{
+	uint32_t index;
+
+	if (!free_slots.empty())
+	{
+		index = free_slots.back();
+		free_slots.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(generations.size());
+		locations.push_back(glm::vec3());
+		rotations.push_back(glm::quat());
+		scales.push_back(glm::vec3());
+		matrices.push_back(glm::mat4());
+		lowers.push_back(glm::vec3());
+		uppers.push_back(glm::vec3());
+		parents.push_back(NULL_TRANSFORM);
+		offsets.push_back(glm::mat4());
+		worlds.push_back(glm::mat4());
+		models.push_back(glm::mat4());
+		normals.push_back(glm::mat3());
+		dirty.push_back(0);
+		rebuilt_pass.push_back(0);
+		parent_index.push_back(NO_PARENT);
+		generations.push_back(0);
+		alive.push_back(0);
+	}
+
+	locations[index] = location;
+	rotations[index] = rotation;
+	scales[index] = scale;
+	lowers[index] = glm::vec3(0);
+	uppers[index] = glm::vec3(0);
+	parents[index] = valid(parent) ? parent : NULL_TRANSFORM;
+	offsets[index] = glm::mat4();
+	rebuilt_pass[index] = 0;
+	generations[index]++;
+	alive[index] = 1;
+	levels_stale = true;
+
+	dirty[index] = 0;
+	build_matrix(index);
+	mark_dirty(index);
+
+	Transform_Handle handle = { index, generations[index] };
+	return handle;
+}
+
+void Transform_Store::destroy(Transform_Handle handle)
+{
+	if (!valid(handle))
+		return;
+
+	if (dirty[handle.index])
+	{
+		dirty[handle.index] = 0;
+		dirty_count--;
+	}
+	alive[handle.index] = 0;
+	free_slots.push_back(handle.index);
+	levels_stale = true;
+}
+
+bool Transform_Store::valid(Transform_Handle handle)
+{
+	return handle.index < generations.size() && alive[handle.index] && generations[handle.index] == handle.generation;
+}
+
+bool Transform_Store::set_parent(Transform_Handle handle, Transform_Handle parent)
+{
+	if (!valid(handle))
+		return false;
+
+	// Refuse anything that would make a node its own ancestor
+	for (Transform_Handle ancestor = parent; valid(ancestor); ancestor = parents[ancestor.index])
+	{
+		if (ancestor.index == handle.index)
+			return false;
+	}
+
+	parents[handle.index] = valid(parent) ? parent : NULL_TRANSFORM;
+	levels_stale = true;
+	mark_dirty(handle.index);
+	return true;
+}
+
+Transform_Handle Transform_Store::parent(Transform_Handle handle)
+{
+	return parents[handle.index];
+}
+
+const glm::vec3& Transform_Store::location(Transform_Handle handle)
+{
+	return locations[handle.index];
+}
+
+const glm::quat& Transform_Store::rotation(Transform_Handle handle)
+{
+	return rotations[handle.index];
+}
+
+const glm::vec3& Transform_Store::scale(Transform_Handle handle)
+{
+	return scales[handle.index];
+}
+
+void Transform_Store::set_location(Transform_Handle handle, glm::vec3 location)
+{
+	locations[handle.index] = location;
+	update(handle);
+}
+
+void Transform_Store::set_rotation(Transform_Handle handle, glm::quat rotation)
+{
+	rotations[handle.index] = rotation;
+	update(handle);
+}
+
+void Transform_Store::set_scale(Transform_Handle handle, glm::vec3 scale)
+{
+	scales[handle.index] = scale;
+	update(handle);
+}
+
+void Transform_Store::set_local(Transform_Handle handle, glm::vec3 location, glm::quat rotation, glm::vec3 scale)
+{
+	locations[handle.index] = location;
+	rotations[handle.index] = rotation;
+	scales[handle.index] = scale;
+	update(handle);
+}
+
+const glm::mat4& Transform_Store::matrix(Transform_Handle handle)
+{
+	return matrices[handle.index];
+}
+
+void Transform_Store::set_offset(Transform_Handle handle, const glm::mat4 &offset)
+{
+	offsets[handle.index] = offset;
+	mark_dirty(handle.index);
+}
+
+const glm::mat4& Transform_Store::world(Transform_Handle handle)
+{
+	return worlds[handle.index];
+}
+
+const glm::mat4& Transform_Store::model(Transform_Handle handle)
+{
+	return models[handle.index];
+}
+
+const glm::mat3& Transform_Store::normal(Transform_Handle handle)
+{
+	return normals[handle.index];
+}
+
+glm::vec3& Transform_Store::lower_bounds(Transform_Handle handle)
+{
+	return lowers[handle.index];
+}
+
+glm::vec3& Transform_Store::upper_bounds(Transform_Handle handle)
+{
+	return uppers[handle.index];
+}
+
+void Transform_Store::set_bounds(Transform_Handle handle, glm::vec3 lower, glm::vec3 upper)
+{
+	lowers[handle.index] = lower;
+	uppers[handle.index] = upper;
+}
+
+void Transform_Store::update(Transform_Handle handle)
+{
+	build_matrix(handle.index);
+	mark_dirty(handle.index);
+}
+
+void Transform_Store::update_all()
+{
+	uint32_t count = static_cast<uint32_t>(generations.size());
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		if (alive[index])
+		{
+			build_matrix(index);
+			mark_dirty(index);
+		}
+	}
+}
+
+uint32_t Transform_Store::update_world()
+{
+	if (dirty_count == 0 && !levels_stale)
+		return 0;
+
+	if (levels_stale)
+		build_levels();
+
+	pass++;
+	uint32_t rebuilt = 0;
+
+	for (size_t level = 0; level + 1 < level_starts.size(); ++level)
+	{
+		uint32_t begin = level_starts[level];
+		uint32_t end = level_starts[level + 1];
+		uint32_t count = end - begin;
+
+		// A handful of dirty nodes in a big level is cheaper to scan than to hand out to jobs
+		if (std::min(count, dirty_count) < 2 * TRANSFORM_BATCH_SIZE)
+		{
+			rebuilt += update_range(begin, end);
+			continue;
+		}
+
+		// Every node on this level only reads its parent from the level above, so batches never overlap
+		std::atomic<uint32_t> level_rebuilt(0);
+		Job_System::parallel_for(count, TRANSFORM_BATCH_SIZE, [this, begin, &level_rebuilt](uint32_t first, uint32_t last) {
+			level_rebuilt.fetch_add(update_range(begin + first, begin + last), std::memory_order_relaxed);
+		});
+		rebuilt += level_rebuilt.load();
+	}
+
+	dirty_count = 0;
+	return rebuilt;
+}
+
+void Transform_Store::query(glm::vec3 lower, glm::vec3 upper, std::vector<Transform_Handle> &overlapping)
+{
+	uint32_t count = static_cast<uint32_t>(generations.size());
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		const glm::vec3 &low = lowers[index];
+		const glm::vec3 &high = uppers[index];
+
+		if (alive[index] &&
+			lower.x <= high.x && upper.x >= low.x &&
+			lower.y <= high.y && upper.y >= low.y &&
+			lower.z <= high.z && upper.z >= low.z)
+		{
+			Transform_Handle handle = { index, generations[index] };
+			overlapping.push_back(handle);
+		}
+	}
+}
+
+uint32_t Transform_Store::size()
+{
+	return static_cast<uint32_t>(generations.size() - free_slots.size());
+}
+
+uint32_t Transform_Store::capacity()
+{
+	return static_cast<uint32_t>(generations.size());
+}
+
+void Transform_Store::build_matrix(uint32_t index)
+{
+	glm::mat4 transform = glm::translate(glm::mat4(), locations[index]);
+	transform *= glm::toMat4(rotations[index]);
+	matrices[index] = glm::scale(transform, scales[index]);
+}
+
+void Transform_Store::mark_dirty(uint32_t index)
+{
+	// Children are not touched here; update_world() rebuilds them because their parent was rebuilt
+	if (!dirty[index])
+	{
+		dirty[index] = 1;
+		dirty_count++;
+	}
+}
+
+void Transform_Store::build_levels()
+{
+	uint32_t count = static_cast<uint32_t>(generations.size());
+	std::vector<uint32_t> depth(count, NO_PARENT);
+	uint32_t max_depth = 0;
+
+	// A node whose parent was re-linked or destroyed needs rebuilding even if it did not change itself
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		uint32_t linked = NO_PARENT;
+		if (alive[index] && valid(parents[index]))
+			linked = parents[index].index;
+
+		if (alive[index] && linked != parent_index[index])
+			mark_dirty(index);
+		parent_index[index] = linked;
+	}
+
+	// Walk up to the first node with a known depth, then fill the chain back in on the way down
+	std::vector<uint32_t> chain;
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		if (!alive[index] || depth[index] != NO_PARENT)
+			continue;
+
+		chain.clear();
+		uint32_t node = index;
+		while (node != NO_PARENT && depth[node] == NO_PARENT)
+		{
+			chain.push_back(node);
+			node = parent_index[node];
+		}
+
+		uint32_t node_depth = node == NO_PARENT ? 0 : depth[node] + 1;
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+		{
+			depth[*it] = node_depth++;
+		}
+		max_depth = std::max(max_depth, node_depth - 1);
+	}
+
+	// Counting sort by depth
+	level_starts.assign(max_depth + 2, 0);
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		if (alive[index])
+			level_starts[depth[index] + 1]++;
+	}
+	for (size_t level = 1; level < level_starts.size(); ++level)
+	{
+		level_starts[level] += level_starts[level - 1];
+	}
+
+	std::vector<uint32_t> cursor(level_starts.begin(), level_starts.end() - 1);
+	order.assign(level_starts.back(), 0);
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		if (alive[index])
+			order[cursor[depth[index]]++] = index;
+	}
+
+	levels_stale = false;
+}
+
+uint32_t Transform_Store::update_range(uint32_t begin, uint32_t end)
+{
+	uint32_t rebuilt = 0;
+
+	for (uint32_t position = begin; position < end; ++position)
+	{
+		uint32_t index = order[position];
+		uint32_t parent = parent_index[index];
+		bool parent_rebuilt = parent != NO_PARENT && rebuilt_pass[parent] == pass;
+
+		if (!dirty[index] && !parent_rebuilt)
+			continue;
+
+		if (parent != NO_PARENT)
+			worlds[index] = worlds[parent] * matrices[index];
+		else
+			worlds[index] = matrices[index];
+
+		models[index] = worlds[index] * offsets[index];
+		normals[index] = glm::inverseTranspose(glm::mat3(models[index]));
+
+		dirty[index] = 0;
+		rebuilt_pass[index] = pass;
+		rebuilt++;
+	}
+
+	return rebuilt;
+}
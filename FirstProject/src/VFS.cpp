@@ -0,0 +1,265 @@
+#include "../include/VFS.h"
+#include "../include/Asset_Pack.h"
+#include "../include/File_IO.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+
+struct VFS_Stats {
+	std::atomic<uint64_t> packed_opens;
+	std::atomic<uint64_t> packed_bytes;
+	std::atomic<uint64_t> loose_opens;
+	std::atomic<uint64_t> loose_bytes;
+};
+
+// Searched from the back. Only changed by mount and unmount_all, before and after loading
+static std::vector<Asset_Pack*> packs;
+static VFS_Stats stats;
+
+// The first pack (searching from the last mounted) holding the normalised path
+static const Asset_Pack_Entry* find_packed(const std::string &path, Asset_Pack** pack)
+{
+	for (auto it = packs.rbegin(); it != packs.rend(); ++it)
+	{
+		const Asset_Pack_Entry* entry = (*it)->find(path);
+		if (entry)
+		{
+			*pack = *it;
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+File_View::File_View()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+	m_packed = false;
+}
+
+bool File_View::is_open()
+{
+	return m_open;
+}
+
+const unsigned char* File_View::data()
+{
+	return m_data;
+}
+
+size_t File_View::size()
+{
+	return m_size;
+}
+
+bool File_View::packed()
+{
+	return m_packed;
+}
+
+void File_View::close()
+{
+	m_file.close();
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+	m_packed = false;
+}
+
+View_Buffer::View_Buffer(const unsigned char* data, size_t size)
+{
+	// The get area is only ever read, so the const_cast never writes to the mapping
+	char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+	setg(begin, begin, begin + size);
+}
+
+View_Buffer::pos_type View_Buffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which)
+{
+	if (!(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+
+	off_type position = offset;
+	if (direction == std::ios_base::cur)
+		position += gptr() - eback();
+	else if (direction == std::ios_base::end)
+		position += egptr() - eback();
+	if (position < 0 || position > egptr() - eback())
+		return pos_type(off_type(-1));
+
+	setg(eback(), eback() + position, egptr());
+	return pos_type(position);
+}
+
+View_Buffer::pos_type View_Buffer::seekpos(pos_type position, std::ios_base::openmode which)
+{
+	return seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+View_Stream::View_Stream(File_View &view)
+	: View_Buffer(view.data(), view.size()), std::istream(static_cast<View_Buffer*>(this))
+{
+}
+
+View_Stream::View_Stream(const unsigned char* data, size_t size)
+	: View_Buffer(data, size), std::istream(static_cast<View_Buffer*>(this))
+{
+}
+
+bool VFS::mount(const std::string &pack_file)
+{
+	Asset_Pack* pack = new Asset_Pack();
+	if (!pack->open(pack_file))
+	{
+		delete pack;
+		return false;
+	}
+	packs.push_back(pack);
+	return true;
+}
+
+void VFS::unmount_all()
+{
+	for (Asset_Pack* pack : packs)
+		delete pack;
+	packs.clear();
+}
+
+bool VFS::open(const std::string &file_name, File_View &view)
+{
+	view.close();
+	std::string path = normalise(file_name);
+
+	Asset_Pack* pack = nullptr;
+	const Asset_Pack_Entry* entry = find_packed(path, &pack);
+	if (entry)
+	{
+		view.m_data = pack->contents(*entry);
+		view.m_size = static_cast<size_t>(entry->size);
+		view.m_open = true;
+		view.m_packed = true;
+		stats.packed_opens++;
+		stats.packed_bytes += entry->size;
+		return true;
+	}
+
+	// Checked first so a missing file is quiet, as a failed ifstream was; Mapped_File reports the rest
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+	if (info.st_size == 0)
+	{
+		// Nothing to map; empty, as it would be from a pack
+		view.m_open = true;
+		stats.loose_opens++;
+		return true;
+	}
+	if (!view.m_file.open(path))
+		return false;
+	view.m_data = view.m_file.data();
+	view.m_size = view.m_file.size();
+	view.m_open = true;
+	stats.loose_opens++;
+	stats.loose_bytes += view.m_size;
+	return true;
+}
+
+bool VFS::exists(const std::string &file_name)
+{
+	return modified_time(file_name) >= 0;
+}
+
+int64_t VFS::modified_time(const std::string &file_name)
+{
+	std::string path = normalise(file_name);
+	Asset_Pack* pack = nullptr;
+	const Asset_Pack_Entry* entry = find_packed(path, &pack);
+	if (entry)
+		return entry->modified;
+	return FileModifiedTime(path);
+}
+
+std::vector<std::string> VFS::directory_contents(const std::string &dir)
+{
+	std::string prefix = normalise(dir);
+	if (!prefix.empty() && prefix != ".")
+		prefix += "/";
+	else
+		prefix.clear();
+
+	std::vector<std::string> files;
+	for (Asset_Pack* pack : packs)
+	{
+		for (uint32_t index = 0; index < pack->entry_count(); ++index)
+		{
+			std::string name = pack->name(pack->entry(index));
+			if (name.compare(0, prefix.size(), prefix) == 0 && name.find('/', prefix.size()) == std::string::npos)
+				files.push_back(name.substr(prefix.size()));
+		}
+	}
+
+	// DirectoryContents complains about a missing directory, which is expected when it is only packed
+	if (FileModifiedTime(prefix.empty() ? "." : prefix) >= 0)
+	{
+		for (const std::string &name : DirectoryContents(prefix.empty() ? "./" : prefix))
+		{
+			if (name != "." && name != "..")
+				files.push_back(name);
+		}
+	}
+
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+	return files;
+}
+
+std::string VFS::normalise(const std::string &file_name)
+{
+	std::vector<std::string> parts;
+	bool absolute = !file_name.empty() && (file_name[0] == '/' || file_name[0] == '\\');
+	size_t start = 0;
+	while (start <= file_name.size())
+	{
+		size_t end = file_name.find_first_of("/\\", start);
+		if (end == std::string::npos)
+			end = file_name.size();
+		std::string part = file_name.substr(start, end - start);
+		start = end + 1;
+
+		if (part.empty() || part == ".")
+			continue;
+		if (part == ".." && !parts.empty() && parts.back() != "..")
+			parts.pop_back();
+		else if (part != ".." || !absolute)
+			parts.push_back(part);
+	}
+
+	std::string path = absolute ? "/" : "";
+	for (size_t index = 0; index < parts.size(); ++index)
+	{
+		if (index > 0)
+			path += "/";
+		path += parts[index];
+	}
+	return path.empty() ? "." : path;
+}
+
+std::string VFS::report()
+{
+	std::string text;
+	char line[256];
+	for (Asset_Pack* pack : packs)
+	{
+		snprintf(line, sizeof(line), "Asset pack: %s, %u files, %.1f MB mapped\n", pack->file_name().c_str(),
+			pack->entry_count(), pack->size() / (1024.0 * 1024.0));
+		text += line;
+	}
+	snprintf(line, sizeof(line), "File opens: %llu from packs (%.1f MB), %llu loose (%.1f MB)\n",
+		static_cast<unsigned long long>(stats.packed_opens.load()), stats.packed_bytes.load() / (1024.0 * 1024.0),
+		static_cast<unsigned long long>(stats.loose_opens.load()), stats.loose_bytes.load() / (1024.0 * 1024.0));
+	return text + line;
+}
@@ -27,7 +27,18 @@
 #include "../include/SceneLoader.h"
 #include "../include/tiny_obj_loader.h"
 #include "../include/File_IO.h"
-#include "../include/Skybox.h"
+#include "../include/Profiler.h"					// Scoped CPU timings (make PROFILE=1)
+#include "../include/GPU_Profiler.h"				// Per pass GPU timings, reported alongside the CPU
+#include "../include/Render_Stats.h"				// Draw calls submitted per frame
+#include "../include/Input_Recorder.h"				// Deterministic input record / replay
+#include "../include/Frame_Memory.h"				// Per frame scratch arena and heap allocation counts
+#include "../include/Scatter_Brush.h"				// Poisson-disc placement of many objects at once
+#include "../include/Frame_Pipeline.h"				// Simulation on a worker while the last frame is drawn
+#include "../include/Job_System.h"					// Work-stealing workers for parallel_for
+#include "../include/Texture_Streamer.h"			// Textures uploaded a few mip levels a frame
+#include "../include/Texture_Arrays.h"				// Same size textures packed into shared arrays
+#include "../include/Image_Decoder.h"				// Image files decoded on the job system while loading
+#include "../include/VFS.h"						// Assets read from an asset pack or loose files
 
 // Window Dimensions
 const GLuint WIDTH = 1024, HEIGHT = 768;
@@ -57,24 +68,51 @@ uint32_t brush = 0;
 uint32_t brush_scale = 1.0;
 GLfloat brush_y_offset = 0.0;
 uint32_t paint_count = 0;
-std::vector<std::string> last_painted;
+std::vector<std::vector<Object_Handle>> last_painted; // Undo stack for the R key; a scatter is one entry
+
+// Scatter brush (T): this many copies of the brush within the radius around the player
+const uint32_t SCATTER_COUNT = 200;
+const GLfloat SCATTER_RADIUS = 10.0;
 
 // View / Focus Swapping
 const double VIEW_SWAP_DELAY = 0.5;	// Only swap view this many times per second
-double time_since_last_swap = 0; // How long since we last swapped view focus
+double time_since_last_swap = -VIEW_SWAP_DELAY; // How long since we last swapped view focus
+double sim_time = 0; // Simulated time. Drives the swap delay so replays behave identically
+
+// Input recording ("--record FILE") and replay ("--replay FILE")
+Input_Recorder input_recorder;
+double step_accumulator = 0;
+std::vector<Input_Event> replay_brushes; // Answers to the brush prompt for the coming step
 
 // Callbacks
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
+// Input handlers: shared by the live callbacks and replay
+void handle_key(int key, int action);
+void handle_cursor(double xpos, double ypos);
+void handle_mouse_button(int button, int action);
+
 void Keyboard_Input(float deltaTime);
+void Simulate(float deltaTime);
+void Step_World(float deltaTime);
+bool Replay_Step();
 void find_complex_files(std::string directory, std::vector<std::string> &complex_files);
 
-int SKYBOX_TRIS = 36;
 bool SHOW_FPS = false;
 
-int main()
+// Frame time statistics: frames slower than this are logged as hitches, histogram written on exit
+const double FRAME_BUDGET_MS = 33.3;
+const std::string FRAME_TIMES_FILE = "./frame_times.csv";
+
+// Profiling: rolling summary (toggle with P) and trace written on exit
+bool SHOW_PROFILE = false;
+const double PROFILE_REPORT_DELAY = 1.0;
+const uint32_t PROFILE_SUMMARY_FRAMES = 60;
+const std::string PROFILE_TRACE_FILE = "./profile_trace.json";
+
+int main(int argc, char** argv)
 {
 	double start_time = glfwGetTime();
 
@@ -109,6 +147,9 @@ int main()
 		exit(-1);
 	}
 
+	// One worker per spare hardware thread; transform updates and the scatter brush split across them
+	Job_System::start();
+
 	// Set required callbacks: Guessing this becomes a large switch which will then be converted into a hash (after all you always want rebindable keys!)
 	// Following from that; I wonder how one does context... State machine?
 	glfwSetKeyCallback(window, key_callback);
@@ -133,17 +174,37 @@ int main()
 	// Clear Color
 	glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 
+	// Meshes only need their bounds once uploaded; "--drop-geometry" frees the tinyobj copies.
+	// "--pipeline" simulates the next frame on a worker thread while this one is drawn.
+	// "--pack FILE" reads assets from an asset pack (default ASSET_PACK_DEFAULT when it exists)
+	bool threaded_pipeline = false;
+	std::string pack_file = ASSET_PACK_DEFAULT;
+	for (int idx = 1; idx < argc; ++idx)
+	{
+		if (std::string(argv[idx]) == "--drop-geometry")
+			Mesh::keep_cpu_geometry(false);
+		else if (std::string(argv[idx]) == "--pipeline")
+			threaded_pipeline = true;
+		else if (std::string(argv[idx]) == "--pack" && idx + 1 < argc)
+			pack_file = argv[++idx];
+	}
+	// Mounted for the whole run: views into it are held until exit
+	if (FileExists(pack_file))
+		VFS::mount(pack_file);
+
 	// Load Scene
 	// current_level = new Scene("./Scenes/Test.scene");
-	current_level = new Scene("./Scenes/Final.scene");
+	{
+		PROFILE_SCOPE("Scene Load");
+		current_level = new Scene("./Scenes/Final.scene");
+	}
 
 	// Attaching Scene Shaders (Move into Level.scene).
 	current_level->attachShader("Debug", "./Shaders/debug.vert", "./Shaders/debug.frag");
 	current_level->attachShader("Light-Texture", "./Shaders/light-texture.vert", "./Shaders/light-texture.frag");
-	current_level->attachShader("Skybox", "./Shaders/skybox.vert", "./Shaders/skybox.frag");
 
 	// Defaulting to active lighting
-	current_level->setActiveShader("Light-Texture");
+	current_level->setActiveShader(SID("Light-Texture"));
 
 	// Lighting
 	// current_level->getLight("CamLight")->attach_light(&current_level->getActiveCamera()->Position, &current_level->getActiveCamera()->Front);
@@ -162,25 +223,97 @@ int main()
 		current_level->getActiveCamera()->SetCircleFocus(&origin, 2, origin);
 		current_level->getActiveCamera()->SetLookFocus(&origin);
 	}
-	Skybox* sky = new Skybox();
-
 	// Initialise Seconds per Frame counter
 	SPF_Counter* spf_report;
-	spf_report = new SPF_Counter(SHOW_FPS);
+	spf_report = new SPF_Counter(SHOW_FPS, FRAME_BUDGET_MS);
 
 	// Set up delta tracking
-	double delta, lastFrame, currentFrame = glfwGetTime();
+	double delta = 0, lastFrame, currentFrame = glfwGetTime();
 
 	// How long did loading take? (Plants take up close to 4 seconds!)
 	std::cout << "Loaded after " << (currentFrame - start_time) << " seconds.\n";
+	std::cout << current_level->texture_sharing_report();
+	std::cout << Image_Decoder::report();
+	std::cout << VFS::report();
 
 	find_complex_files("./Statics/", complex_files);
 
+	double last_profile_report = currentFrame;
+
+	// Options with a value; "--texture-budget MB" sets the texture VRAM budget (default 256)
+	for (int idx = 1; idx + 1 < argc; ++idx)
+	{
+		std::string arg = argv[idx];
+		if (arg == "--record")
+			input_recorder.start_recording(argv[++idx]);
+		else if (arg == "--replay")
+			input_recorder.start_replay(argv[++idx]);
+		else if (arg == "--texture-budget")
+			Resource_Manager::set_texture_budget(strtoull(argv[++idx], nullptr, 10) * 1024 * 1024);
+	}
+
+	// Replays run as fast as they can render
+	if (input_recorder.replaying())
+		glfwSwapInterval(0);
+
+	// Recording and replay interleave input with fixed steps, so they always run serially
+	if (threaded_pipeline && (input_recorder.recording() || input_recorder.replaying()))
+	{
+		std::cout << "Recording and replay use the serial pipeline\n";
+		threaded_pipeline = false;
+	}
+	Frame_Pipeline* pipeline = new Frame_Pipeline(threaded_pipeline);
+	// The first frame drawn is the scene as loaded
+	current_level->snapshot(pipeline->front());
+
+	// Threaded: input is applied at the sync point, the worker only advances the world
+	Frame_Pipeline::Step world_step = [&delta](Render_Snapshot &snapshot) {
+		Step_World(delta);
+		current_level->snapshot(snapshot);
+	};
+
+	// Serial: input, simulation and snapshot in one go (the only mode that records and replays)
+	Frame_Pipeline::Step serial_step = [&](Render_Snapshot &snapshot) {
+		if (input_recorder.replaying())
+		{
+			// One recorded step per rendered frame; live input is ignored
+			if (!Replay_Step())
+			{
+				std::cout << "Replay finished after " << input_recorder.get_steps() << " steps\n";
+				glfwSetWindowShouldClose(window, GL_TRUE);
+			}
+		}
+		else if (input_recorder.recording())
+		{
+			// Fixed steps so the replay can repeat them exactly
+			input_recorder.frame(delta);
+			step_accumulator += delta;
+			if (step_accumulator > INPUT_MAX_CATCH_UP * input_recorder.get_timestep())
+				step_accumulator = INPUT_MAX_CATCH_UP * input_recorder.get_timestep();
+			while (step_accumulator >= input_recorder.get_timestep())
+			{
+				Simulate(input_recorder.get_timestep());
+				input_recorder.step();
+				step_accumulator -= input_recorder.get_timestep();
+			}
+		}
+		else
+		{
+			Simulate(delta);
+		}
+
+		current_level->snapshot(snapshot);
+	};
+
 	// Program Loop
 	while (!glfwWindowShouldClose(window))
 	{
+		PROFILE_FRAME();
+		GPU_PROFILE_FRAME();
+		Render_Stats::new_frame();
+		Frame_Memory::new_frame();
 		// Frame Delta
-		current_level->setActiveShader("Light-Texture");
+		current_level->setActiveShader(SID("Light-Texture"));
 		lastFrame = currentFrame;
 		currentFrame = glfwGetTime();
 		delta = currentFrame - lastFrame;
@@ -191,40 +324,73 @@ int main()
 		// Check and call events
 		glfwPollEvents();
 
-		// Player Input
-		// System Controls
-		Keyboard_Input(delta);
-		// Character Controls
-		if (current_level->hasPlayer())
-			current_level->getPlayer()->tick(delta);
-
-		// Update Level
-		current_level->tick(delta);
+		if (pipeline->threaded())
+		{
+			// The worker is idle until submit, so input may attach / remove objects and load meshes
+			{
+				PROFILE_SCOPE("Keyboard_Input");
+				Keyboard_Input(delta);
+			}
+			pipeline->submit(world_step);
+		}
+		else
+		{
+			pipeline->submit(serial_step);
+		}
 
-		// Rendering Commands here
+		// Rendering Commands here: only the snapshot is read from here to sync()
+		Render_Snapshot &frame = pipeline->front();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		glPolygonMode(GL_FRONT_AND_BACK, fill_mode);
 
-		current_level->draw();
+		current_level->draw(frame);
 
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-		current_level->setActiveShader("Skybox");
+		// Swap Buffers
+		{
+			PROFILE_SCOPE("glfwSwapBuffers");
+			glfwSwapBuffers(window);
+		}
+		pipeline->present();
 
-		current_level->rendSky();
+		// Meshes released this frame are in no snapshot still to be drawn, so they can go
+		current_level->end_frame();
 
-		glDepthFunc(GL_LEQUAL);
-		glBindVertexArray(sky->skyVaoId);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, sky->skyTexId);
-		glDrawArrays(GL_TRIANGLES, 0, SKYBOX_TRIS);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LESS);
+		pipeline->sync();
 
-		// Swap Buffers
-		glfwSwapBuffers(window);
+		// Next few mip levels of recently loaded textures, then pack them once they are all in
+		Texture_Streamer::update();
+		Texture_Arrays::update();
 
+		// Rolling profile summary
+		if (SHOW_PROFILE && currentFrame - last_profile_report > PROFILE_REPORT_DELAY)
+		{
+			std::cout << Profiler::summary(PROFILE_SUMMARY_FRAMES);
+			std::cout << Frame_Memory::report();
+			std::cout << current_level->texture_residency_report();
+			last_profile_report = currentFrame;
+		}
+	}
+
+	input_recorder.stop();
+
+	std::cout << spf_report->report();
+	std::cout << pipeline->report();
+	delete pipeline;
+	Job_System::stop();
+	std::cout << Frame_Memory::report();
+	spf_report->export_csv(FRAME_TIMES_FILE);
+	std::cout << current_level->resource_report();
+	std::cout << Texture_Streamer::report();
+	std::cout << Texture_Arrays::report();
+	Texture_Streamer::release();
+
+	if (Profiler::enabled())
+	{
+		Profiler::write_chrome_trace(PROFILE_TRACE_FILE);
+		GPU_Profiler::release();
 	}
 
 	glfwTerminate();
@@ -239,7 +405,7 @@ void Keyboard_Input(float deltaTime)
 	// Inspection Mode
 	if (keys[GLFW_KEY_2])
 	{
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY && !is_fully_rendered)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY && !is_fully_rendered)
 		{
 			inspection_mode++;
 			if (inspection_mode > 0)
@@ -253,18 +419,18 @@ void Keyboard_Input(float deltaTime)
 				inspection_mode = 0;
 				std::cout << "Wire Frame\n";
 			}
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
 			current_level->setViewMode(inspection_mode);
 		}
 	}
 	// Switch between Lighting / Inspection Mode
 	if(keys[GLFW_KEY_1])
 	{
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
 		{
 			if (is_fully_rendered == false) // If Currently Debug
 			{
-				current_level->setActiveShader("Light-Texture");
+				current_level->setActiveShader(SID("Light-Texture"));
 				fill_mode = GL_FILL;
 				lighting_mode = 0;
 				current_level->setActiveLight("Overhead");
@@ -273,7 +439,7 @@ void Keyboard_Input(float deltaTime)
 			}
 			else
 			{
-				current_level->setActiveShader("Debug");
+				current_level->setActiveShader(SID("Debug"));
 				inspection_mode = 0;
 				fill_mode = GL_LINE;
 				std::cout << "Debug Mode\n";
@@ -281,83 +447,198 @@ void Keyboard_Input(float deltaTime)
 
 			is_fully_rendered = !is_fully_rendered;
 
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
 		}
 	}
 	if (keys[GLFW_KEY_Q])
 	{
 
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
 		{
-			std::cout << "Choose brush:\n" << std::endl;
-			for (uint32_t idx = 0; idx < complex_files.size(); ++idx)
+			uint32_t new_brush = brush;
+			uint32_t new_size = brush_scale;
+
+			if (input_recorder.replaying())
+			{
+				// Use the answers given when this was recorded
+				if (!replay_brushes.empty())
+				{
+					new_brush = replay_brushes.front().code;
+					new_size = replay_brushes.front().action;
+					brush_y_offset = replay_brushes.front().x;
+					replay_brushes.erase(replay_brushes.begin());
+				}
+			}
+			else
 			{
-				std::cout << "\t" << std::to_string(idx) << ": " << complex_files.at(idx) << std::endl;
+				std::cout << "Choose brush:\n" << std::endl;
+				for (uint32_t idx = 0; idx < complex_files.size(); ++idx)
+				{
+					std::cout << "\t" << std::to_string(idx) << ": " << complex_files.at(idx) << std::endl;
+				}
+				std::cin >> new_brush;
+				std::cout << "Choose brush size:\n" << std::endl;
+				std::cin >> new_size;
+				std::cout << "Choose brush y-offset:\n" << std::endl;
+				std::cin >> brush_y_offset;
+
+				input_recorder.brush(new_brush, new_size, brush_y_offset);
 			}
-			uint32_t new_brush;
-			std::cin >> new_brush;
+
 			if (new_brush < complex_files.size())
 			{
 				brush = new_brush;
 			}
-			std::cout << "Choose brush size:\n" << std::endl;
-			uint32_t new_size;
-			std::cin >> new_size;
 			if (new_size > 0)
 			{
 				brush_scale = new_size;
 			}
-			std::cout << "Choose brush y-offset:\n" << std::endl;
-			std::cin >> brush_y_offset;
 
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
 		}
 	}
 	if (keys[GLFW_KEY_E])
 	{
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
 		{
 			current_level->getPlayer()->clip(false);
 
 			glm::vec3 location = *current_level->getPlayer()->get_location();
 			location.y += brush_y_offset;
 
-			current_level->attachObject(complex_files.at(brush) + "_" + std::to_string(paint_count),
+			Object_Placement placement = {
+				complex_files.at(brush) + "_" + std::to_string(paint_count),
 				current_level->getPlayer()->get_rotation(),
 				location,
-				glm::vec3(brush_scale),
-				complex_files.at(brush),
-				"./Statics/");
-			last_painted.push_back(complex_files.at(brush) + "_" + std::to_string(paint_count));
-			std::cout << "Attached: " << last_painted.back() << std::endl;
+				glm::vec3(brush_scale)
+			};
+			last_painted.push_back(std::vector<Object_Handle>());
+			current_level->attachObjects("./Statics/" + complex_files.at(brush), std::vector<Object_Placement>(1, placement), &last_painted.back());
+			std::cout << "Attached: " << placement.name << std::endl;
+			paint_count++;
+			time_since_last_swap = sim_time;
+		}
+	}
+	if (keys[GLFW_KEY_T])
+	{
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
+		{
+			current_level->getPlayer()->clip(false);
+
+			glm::vec3 location = *current_level->getPlayer()->get_location();
+
+			Scatter_Region region;
+			region.centre = glm::vec2(location.x, location.z);
+			region.radius = SCATTER_RADIUS;
+
+			// Seeded by the paint count so a replay scatters the same placements
+			Scatter_Settings settings = { SCATTER_COUNT, 0.0f, 0.5f * brush_scale, 1.5f * brush_scale, brush_y_offset, paint_count };
+
+			Scatter_Brush scatter_brush(current_level->getHeightmap());
+			last_painted.push_back(std::vector<Object_Handle>());
+			uint32_t placed = scatter_brush.scatter(current_level, "./Statics/" + complex_files.at(brush), region, settings,
+				complex_files.at(brush) + "_" + std::to_string(paint_count), 0, &last_painted.back());
+
+			std::cout << "Scattered " << placed << " x " << complex_files.at(brush) << " (sample " << scatter_brush.last_sample_ms()
+				<< " ms, attach " << scatter_brush.last_attach_ms() << " ms)" << std::endl;
 			paint_count++;
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
 		}
 	}
 	if (keys[GLFW_KEY_R])
 	{
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
 		{
 			if (last_painted.size() > 0)
 			{
-				current_level->removeObject(last_painted.back());
-				std::cout << "Removed: " << last_painted.back() << std::endl;
+				std::vector<Object_Handle> &painted = last_painted.back();
+				Object* first = painted.empty() ? nullptr : current_level->getObject(painted.front());
+				if (painted.size() == 1 && first)
+					std::cout << "Removed: " << first->get_name() << std::endl;
+				else if (painted.size() > 1)
+					std::cout << "Removed: " << painted.size() << " scattered objects" << std::endl;
+				current_level->removeObjects(painted);
 				last_painted.pop_back();
 			}
 
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
+		}
+	}
+	if (keys[GLFW_KEY_P])
+	{
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
+		{
+			SHOW_PROFILE = !SHOW_PROFILE;
+			std::cout << (SHOW_PROFILE ? "Profile Summary On\n" : "Profile Summary Off\n");
+
+			time_since_last_swap = sim_time;
 		}
 	}
 	if (keys[GLFW_KEY_F])
 	{
-		if (glfwGetTime() - time_since_last_swap > VIEW_SWAP_DELAY)
+		if (sim_time - time_since_last_swap > VIEW_SWAP_DELAY)
 		{
 			// std::cout << current_level->report() << std::endl;
 			current_level->save_level("TEST_SAVE");
 
-			time_since_last_swap = glfwGetTime();
+			time_since_last_swap = sim_time;
+		}
+	}
+}
+
+// One simulation step: input, player and level
+void Simulate(float deltaTime)
+{
+	// Player Input
+	// System Controls
+	{
+		PROFILE_SCOPE("Keyboard_Input");
+		Keyboard_Input(deltaTime);
+	}
+	Step_World(deltaTime);
+}
+
+// Everything but input: safe to run on the pipeline worker
+void Step_World(float deltaTime)
+{
+	// Character Controls
+	if (current_level->hasPlayer())
+		current_level->getPlayer()->tick(deltaTime);
+
+	// Update Level
+	current_level->tick(deltaTime);
+
+	sim_time += deltaTime;
+}
+
+// Feed recorded input up to the next step marker, then simulate that step
+bool Replay_Step()
+{
+	Input_Event event;
+	while (input_recorder.next(event))
+	{
+		switch (event.type)
+		{
+			case iKEY:
+				handle_key(event.code, event.action);
+				break;
+			case iMOUSE_BUTTON:
+				handle_mouse_button(event.code, event.action);
+				break;
+			case iCURSOR:
+				handle_cursor(event.x, event.y);
+				break;
+			case iBRUSH:
+				replay_brushes.push_back(event);
+				break;
+			case iSTEP:
+				Simulate(input_recorder.get_timestep());
+				return true;
+			default:
+				break;
 		}
 	}
+	return false;
 }
 
 // Capture Input via Callbacks
@@ -370,6 +651,40 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	// closing the application
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+
+	// While replaying only the recording drives the game
+	if (input_recorder.replaying())
+		return;
+
+	input_recorder.key(key, action);
+	handle_key(key, action);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    // Silencing warnings for unused vars but needed for OpenGL
+    (void)window;
+	if (input_recorder.replaying())
+		return;
+
+	input_recorder.cursor(xpos, ypos);
+	handle_cursor(xpos, ypos);
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    // Silencing warnings for unused vars but needed for OpenGL
+    (void)window;
+    (void)mods;
+	if (input_recorder.replaying())
+		return;
+
+	input_recorder.mouse_button(button, action);
+	handle_mouse_button(button, action);
+}
+
+void handle_key(int key, int action)
+{
 	if (key >= 0 && key < 1024)
 	{
 		if (action == GLFW_PRESS)
@@ -379,10 +694,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	}
 }
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+void handle_cursor(double xpos, double ypos)
 {
-    // Silencing warnings for unused vars but needed for OpenGL
-    (void)window;
 	if (firstMouse)
 	{
 		lastX = xpos;
@@ -408,12 +721,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 
 }
 
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+void handle_mouse_button(int button, int action)
 {
-    // Silencing warnings for unused vars but needed for OpenGL
-    (void)window;
-    (void)mods;
-	if (button >= 0 && button <= 8)
+	if (button >= 0 && button < 8)
 	{
 		if (action == GLFW_PRESS)
 		{
@@ -430,7 +740,7 @@ void find_complex_files(std::string directory, std::vector<std::string> &complex
 {
 	std::vector<std::string> files;
 
-	files = DirectoryContents(directory);
+	files = VFS::directory_contents(directory);
 
 	for (auto &file : files)
 	{
@@ -0,0 +1,78 @@
+/*	Author: Ben Weatherall
+	Description: Asset packer. Writes every file below the asset directories (sub directories included)
+	into one Asset_Pack, which the game and benchmark mount at start up and read through the VFS
+	instead of opening each file on its own. Cook the textures first ("./texture_cook") so the
+	cooked DDS files under Materials/Cache/ are packed as well.
+
+	Packed files hide the loose ones, so build the pack again after editing an asset (or delete it).
+
+	Build with "make asset_pack" and run from the FirstProject directory:
+		./asset_pack [--out FILE] [directory...]
+	(default ./Assets.pack from Meshes, Materials, Statics, Scenes and Shaders).
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../include/Asset_Pack.h"
+#include "../include/File_IO.h"
+#include "../include/VFS.h"
+
+int main(int argc, char** argv)
+{
+	std::string pack_file = ASSET_PACK_DEFAULT;
+	std::vector<std::string> directories;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (strcmp(argv[arg], "--out") == 0 && arg + 1 < argc)
+			pack_file = argv[++arg];
+		else
+			directories.push_back(argv[arg]);
+	}
+	if (directories.empty())
+		directories = { "./Meshes/", "./Materials/", "./Statics/", "./Scenes/", "./Shaders/" };
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::string> files;
+	std::string packed_name = VFS::normalise(pack_file);
+	for (std::string directory : directories)
+	{
+		if (directory.back() != '/' && directory.back() != '\\')
+			directory += "/";
+
+		uint32_t count = 0;
+		for (const std::string &name : DirectoryTree(directory))
+		{
+			// A pack written inside a packed directory must not swallow itself (or its temporary)
+			std::string normalised = VFS::normalise(directory + name);
+			if (normalised == packed_name || normalised == packed_name + ".tmp")
+				continue;
+			files.push_back(directory + name);
+			count++;
+		}
+		printf("%-24s %6u files\n", directory.c_str(), count);
+	}
+
+	if (!Asset_Pack::write(pack_file, files))
+	{
+		fprintf(stderr, "Unable to write asset pack: %s\n", pack_file.c_str());
+		return 1;
+	}
+	double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Read it back, so a broken pack is found here rather than by the game
+	Asset_Pack pack;
+	if (!pack.open(pack_file))
+		return 1;
+	uint64_t content_bytes = 0;
+	for (uint32_t index = 0; index < pack.entry_count(); ++index)
+		content_bytes += pack.entry(index).size;
+
+	printf("\n%s: %u files, %.2f MB of contents in %.2f MB (table and %u byte alignment) in %.1f ms\n",
+		pack_file.c_str(), pack.entry_count(), content_bytes / (1024.0 * 1024.0), pack.size() / (1024.0 * 1024.0),
+		ASSET_PACK_ALIGNMENT, total_ms);
+	return 0;
+}
@@ -0,0 +1,541 @@
+/*	Author: Ben Weatherall
+	Description: Headless benchmark. Creates an offscreen OpenGL 3.3 core context with EGL
+	(surfaceless, so no window or display is needed and Mesa llvmpipe works), loads a scene,
+	flies the camera along a scripted or recorded path for a fixed number of frames and writes
+	frame time and draw call statistics as JSON.
+
+	Build with "make benchmark", run from the FirstProject directory:
+		./benchmark [--scene FILE] [--path FILE] [--frames N] [--warmup N] [--out FILE] [--pipeline] [--pack FILE]
+
+	"--pipeline" simulates each frame on a worker thread while the previous one is drawn (see
+	Frame_Pipeline); run with and without it to compare latency and throughput. Assets come from
+	"--pack FILE" (default ./Assets.pack when it exists, see "make asset_pack") or loose files.
+
+	The context is made current through EGL, so GL entry points must come from a GLVND libGL
+	(the default on current Mesa and NVIDIA installs) for GLEW to resolve them.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+// EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+// GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../include/Scene.h"
+#include "../include/Skybox.h"
+#include "../include/Seconds_Per_Frame_Counter.h"
+#include "../include/Render_Stats.h"
+#include "../include/Memory_Stats.h"
+#include "../include/Frame_Memory.h"
+#include "../include/Frame_Pipeline.h"
+#include "../include/Job_System.h"
+#include "../include/Profiler.h"
+#include "../include/GPU_Profiler.h"
+#include "../include/Texture_Streamer.h"
+#include "../include/Texture_Arrays.h"
+#include "../include/VFS.h"
+
+// Fixed simulation step so every run animates the scene identically
+const GLfloat BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+
+// Default scripted path: orbit the origin at this radius and height
+const GLfloat ORBIT_RADIUS = 20.0f;
+const GLfloat ORBIT_HEIGHT = 8.0f;
+
+struct Camera_Key {
+	glm::vec3 position;
+	glm::vec3 target;
+};
+
+struct Benchmark_Options {
+	std::string scene_file = "./Scenes/Final.scene";
+	std::string path_file;
+	std::string out_file = "./benchmark.json";
+	uint32_t frames = 600;
+	uint32_t warmup = 30;
+	bool drop_geometry = false;
+	bool pipeline = false;
+	// Empty when nothing is mounted
+	std::string pack_file = ASSET_PACK_DEFAULT;
+};
+
+struct Offscreen_Context {
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	GLuint framebuffer = 0;
+	GLuint renderbuffers[2] = { 0, 0 };
+};
+
+struct Draw_Totals {
+	uint64_t draw_calls = 0;
+	uint64_t vertices = 0;
+	uint64_t max_draw_calls = 0;
+	uint64_t max_vertices = 0;
+	uint64_t texture_binds = 0;
+	uint64_t max_texture_binds = 0;
+	uint64_t heap_allocations = 0;
+	uint64_t max_heap_allocations = 0;
+};
+
+bool parse_options(int argc, char** argv, Benchmark_Options &options);
+bool create_context(Offscreen_Context &offscreen);
+void destroy_context(Offscreen_Context &offscreen);
+bool load_path(std::string path_file, std::vector<Camera_Key> &keys);
+Camera_Key sample_path(const std::vector<Camera_Key> &keys, uint32_t frame, uint32_t frames);
+std::string to_json(const Benchmark_Options &options, SPF_Counter &frame_times, SPF_Counter &submit_times,
+	double load_seconds, const Draw_Totals &draws, Frame_Pipeline &pipeline);
+
+int main(int argc, char** argv)
+{
+	Benchmark_Options options;
+	if (!parse_options(argc, argv, options))
+	{
+		return -1;
+	}
+
+	Offscreen_Context offscreen;
+	if (!create_context(offscreen))
+	{
+		return -1;
+	}
+
+	// Same GL state as the interactive build
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+
+	std::vector<Camera_Key> path;
+	if (!options.path_file.empty() && !load_path(options.path_file, path))
+	{
+		destroy_context(offscreen);
+		return -1;
+	}
+
+	Mesh::keep_cpu_geometry(!options.drop_geometry);
+	Job_System::start();
+	if (!FileExists(options.pack_file) || !VFS::mount(options.pack_file))
+		options.pack_file.clear();
+
+	// -- Load --
+	auto load_start = std::chrono::steady_clock::now();
+
+	Scene* level;
+	{
+		PROFILE_SCOPE("Scene Load");
+		level = new Scene(options.scene_file);
+	}
+	level->attachShader("Light-Texture", "./Shaders/light-texture.vert", "./Shaders/light-texture.frag");
+
+	// The player needs a heightmap to stand on; include it when we can so the draw list matches the game
+	bool keys[1024] = { false };
+	bool mouse_button[8] = { false };
+	if (level->getHeightmap())
+	{
+		level->attachPlayer("./Meshes/Assign_3/Barrel02.obj", keys, mouse_button, glm::vec3(0, 1, 0), glm::vec3(0.0f), glm::vec3(0.2, 0.2, 0.2));
+	}
+
+	// Measure with every level resident and the textures packed, as a warm game would be
+	Texture_Streamer::flush();
+	level->getSkybox()->flush();
+	Texture_Arrays::pack();
+	glFinish();
+
+	double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+	std::cout << "Loaded after " << load_seconds << " seconds.\n";
+	std::cout << VFS::report();
+
+	// Hitches are still counted against the interactive budget so numbers are comparable
+	SPF_Counter frame_times(false);
+	SPF_Counter submit_times(false);
+	frame_times.set_hitch_logging(false);
+	submit_times.set_hitch_logging(false);
+
+	Camera* camera = level->getActiveCamera();
+	Camera_Key key;
+	camera->SetLookFocus(&key.target);
+
+	Draw_Totals draws;
+
+	// Fly the path, animate the scene and capture what to draw. Runs on the pipeline worker with --pipeline
+	Frame_Pipeline pipeline(options.pipeline);
+	uint32_t step_frame = 0;
+	Frame_Pipeline::Step step = [&](Render_Snapshot &snapshot) {
+		// The warm up flies the first keyframe so caches are hot before we measure
+		key = sample_path(path, step_frame < options.warmup ? 0 : step_frame - options.warmup, options.frames);
+		camera->Position = key.position;
+
+		if (level->hasPlayer())
+			level->getPlayer()->tick(BENCHMARK_TIMESTEP);
+		level->tick(BENCHMARK_TIMESTEP);
+		level->snapshot(snapshot);
+	};
+	level->snapshot(pipeline.front());
+
+	// -- Run --
+	for (uint32_t frame = 0; frame < options.warmup + options.frames; ++frame)
+	{
+		PROFILE_FRAME();
+		GPU_PROFILE_FRAME();
+		Render_Stats::new_frame();
+		Frame_Memory::new_frame();
+
+		if (frame == options.warmup)
+			pipeline.clear_stats();
+
+		auto frame_start = std::chrono::steady_clock::now();
+
+		step_frame = frame;
+		pipeline.submit(step);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		level->setActiveShader(SID("Light-Texture"));
+		level->draw(pipeline.front());
+
+		auto frame_submitted = std::chrono::steady_clock::now();
+
+		// Nothing to swap; wait for the GPU so a frame costs what it would with vsync off
+		{
+			PROFILE_SCOPE("glFinish");
+			glFinish();
+		}
+		pipeline.present();
+		level->end_frame();
+		pipeline.sync();
+		Texture_Streamer::update();
+		Texture_Arrays::update();
+
+		auto frame_end = std::chrono::steady_clock::now();
+
+		if (frame < options.warmup)
+			continue;
+
+		frame_times.record(std::chrono::duration<double>(frame_end - frame_start).count());
+		submit_times.record(std::chrono::duration<double>(frame_submitted - frame_start).count());
+
+		draws.draw_calls += Render_Stats::frame_draw_calls();
+		draws.vertices += Render_Stats::frame_vertices();
+		draws.max_draw_calls = std::max(draws.max_draw_calls, Render_Stats::frame_draw_calls());
+		draws.max_vertices = std::max(draws.max_vertices, Render_Stats::frame_vertices());
+		draws.texture_binds += Render_Stats::frame_texture_binds();
+		draws.max_texture_binds = std::max(draws.max_texture_binds, Render_Stats::frame_texture_binds());
+		draws.heap_allocations += Frame_Memory::frame_allocations();
+		draws.max_heap_allocations = std::max(draws.max_heap_allocations, Frame_Memory::frame_allocations());
+	}
+
+	std::string json = to_json(options, frame_times, submit_times, load_seconds, draws, pipeline);
+
+	std::fstream fs;
+	fs.open(options.out_file, std::fstream::out);
+	if (fs.is_open())
+	{
+		fs << json;
+		fs.close();
+		std::cout << "Benchmark written to: " << options.out_file << std::endl;
+	}
+	else
+	{
+		std::cerr << "Error saving to: " << options.out_file << std::endl;
+	}
+
+	std::cout << frame_times.report();
+	std::cout << pipeline.report();
+	std::cout << "Draw calls: " << draws.draw_calls / options.frames << " per frame\n";
+	std::cout << "Texture binds: " << double(draws.texture_binds) / options.frames << " per frame\n";
+	std::cout << Texture_Arrays::report();
+	std::cout << "Heap allocations: " << double(draws.heap_allocations) / options.frames << " per frame (max " << draws.max_heap_allocations << ")\n";
+	std::cout << "Memory:\n" << Memory_Stats::report();
+
+	if (Profiler::enabled())
+	{
+		std::cout << Profiler::summary(options.frames);
+		GPU_Profiler::release();
+	}
+
+	Texture_Streamer::release();
+	Job_System::stop();
+	destroy_context(offscreen);
+
+	return 0;
+}
+
+bool parse_options(int argc, char** argv, Benchmark_Options &options)
+{
+	for (int idx = 1; idx < argc; ++idx)
+	{
+		std::string arg = argv[idx];
+		bool has_value = idx + 1 < argc;
+
+		if (arg == "--scene" && has_value)
+			options.scene_file = argv[++idx];
+		else if (arg == "--path" && has_value)
+			options.path_file = argv[++idx];
+		else if (arg == "--out" && has_value)
+			options.out_file = argv[++idx];
+		else if (arg == "--frames" && has_value)
+			options.frames = std::max(1, atoi(argv[++idx]));
+		else if (arg == "--warmup" && has_value)
+			options.warmup = std::max(0, atoi(argv[++idx]));
+		else if (arg == "--drop-geometry")
+			options.drop_geometry = true;
+		else if (arg == "--pipeline")
+			options.pipeline = true;
+		else if (arg == "--pack" && has_value)
+			options.pack_file = argv[++idx];
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--scene FILE] [--path FILE] [--frames N] [--warmup N] [--out FILE] [--drop-geometry] [--pipeline] [--pack FILE]\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool create_context(Offscreen_Context &offscreen)
+{
+	// Surfaceless platform first (no display server needed), then whatever the default display is
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	if (get_platform_display)
+		offscreen.display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#else
+	(void)get_platform_display;
+#endif
+	if (offscreen.display == EGL_NO_DISPLAY)
+		offscreen.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (offscreen.display == EGL_NO_DISPLAY || !eglInitialize(offscreen.display, &major, &minor))
+	{
+		std::cout << "Failed to initialise EGL" << std::endl;
+		return false;
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint config_count = 0;
+	eglChooseConfig(offscreen.display, config_attribs, &config, 1, &config_count);
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	eglBindAPI(EGL_OPENGL_API);
+	offscreen.context = eglCreateContext(offscreen.display, config_count > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+	if (offscreen.context == EGL_NO_CONTEXT ||
+		!eglMakeCurrent(offscreen.display, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreen.context))
+	{
+		std::cout << "Failed to create an OpenGL 3.3 core EGL context" << std::endl;
+		eglTerminate(offscreen.display);
+		return false;
+	}
+
+	// Initialise GLEW. Without an X display GLEW 2.x still loads GL but reports the missing GLX display
+	glewExperimental = GL_TRUE;
+	GLenum glew_status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (glew_status == GLEW_ERROR_NO_GLX_DISPLAY)
+		glew_status = GLEW_OK;
+#endif
+	if (glew_status != GLEW_OK)
+	{
+		std::cout << "Failed to initialise GLEW" << std::endl;
+		destroy_context(offscreen);
+		return false;
+	}
+	// glewExperimental can leave a harmless GL_INVALID_ENUM behind
+	glGetError();
+
+	// No default framebuffer without a surface, so render into our own at the game's resolution
+	glGenFramebuffers(1, &offscreen.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen.framebuffer);
+	glGenRenderbuffers(2, offscreen.renderbuffers);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen.renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, s_WIDTH, s_HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen.renderbuffers[0]);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen.renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, s_WIDTH, s_HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen.renderbuffers[1]);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer incomplete" << std::endl;
+		destroy_context(offscreen);
+		return false;
+	}
+
+	glViewport(0, 0, s_WIDTH, s_HEIGHT);
+
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << " (EGL " << major << "." << minor << ")\n";
+	return true;
+}
+
+void destroy_context(Offscreen_Context &offscreen)
+{
+	if (offscreen.framebuffer)
+	{
+		glDeleteFramebuffers(1, &offscreen.framebuffer);
+		glDeleteRenderbuffers(2, offscreen.renderbuffers);
+		offscreen.framebuffer = 0;
+	}
+
+	eglMakeCurrent(offscreen.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (offscreen.context != EGL_NO_CONTEXT)
+		eglDestroyContext(offscreen.display, offscreen.context);
+	eglTerminate(offscreen.display);
+}
+
+// See docs/CameraPathDefinition.txt
+bool load_path(std::string path_file, std::vector<Camera_Key> &keys)
+{
+	std::ifstream fs(path_file);
+	if (!fs.is_open())
+	{
+		std::cerr << "Could not open camera path: " << path_file << std::endl;
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(fs, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream values(line);
+		Camera_Key key;
+		if (values >> key.position.x >> key.position.y >> key.position.z >> key.target.x >> key.target.y >> key.target.z)
+		{
+			keys.push_back(key);
+		}
+	}
+
+	if (keys.empty())
+	{
+		std::cerr << "No keyframes in camera path: " << path_file << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Keyframes are spread evenly over the run and linearly interpolated. No keyframes orbits the origin
+Camera_Key sample_path(const std::vector<Camera_Key> &keys, uint32_t frame, uint32_t frames)
+{
+	float t = frames > 1 ? float(frame) / float(frames - 1) : 0.0f;
+	Camera_Key key;
+
+	if (keys.empty())
+	{
+		float angle = t * 2.0f * float(M_PI);
+		key.position = glm::vec3(ORBIT_RADIUS * cos(angle), ORBIT_HEIGHT, ORBIT_RADIUS * sin(angle));
+		key.target = glm::vec3(0.0f, 1.0f, 0.0f);
+		return key;
+	}
+	if (keys.size() == 1)
+	{
+		return keys.front();
+	}
+
+	float position = t * float(keys.size() - 1);
+	uint32_t first = std::min(static_cast<uint32_t>(position), static_cast<uint32_t>(keys.size() - 2));
+	float blend = position - first;
+
+	key.position = glm::mix(keys[first].position, keys[first + 1].position, blend);
+	key.target = glm::mix(keys[first].target, keys[first + 1].target, blend);
+	return key;
+}
+
+std::string to_json(const Benchmark_Options &options, SPF_Counter &frame_times, SPF_Counter &submit_times,
+	double load_seconds, const Draw_Totals &draws, Frame_Pipeline &pipeline)
+{
+	Frame_Histogram* frame = frame_times.histogram();
+	Frame_Histogram* submit = submit_times.histogram();
+	Frame_Histogram* latency = pipeline.latency_times();
+	uint64_t frames = frame->count() ? frame->count() : 1;
+
+	char buffer[4096];
+	snprintf(buffer, sizeof(buffer),
+		"{\n"
+		"\t\"scene\": \"%s\",\n"
+		"\t\"path\": \"%s\",\n"
+		"\t\"renderer\": \"%s\",\n"
+		"\t\"width\": %u,\n"
+		"\t\"height\": %u,\n"
+		"\t\"frames\": %llu,\n"
+		"\t\"warmup\": %u,\n"
+		"\t\"load_seconds\": %.4f,\n"
+		"\t\"frame_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n"
+		"\t\"submit_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n"
+		"\t\"hitches\": %llu,\n"
+		"\t\"hitch_budget_ms\": %.2f,\n"
+		"\t\"draw_calls\": { \"mean\": %.2f, \"max\": %llu },\n"
+		"\t\"vertices\": { \"mean\": %.1f, \"max\": %llu },\n"
+		"\t\"texture_binds\": { \"mean\": %.2f, \"max\": %llu },\n"
+		"\t\"heap_allocations\": { \"mean\": %.2f, \"max\": %llu },\n"
+		"\t\"drop_geometry\": %s,\n"
+		"\t\"pipeline\": \"%s\",\n"
+		"\t\"pack\": \"%s\",\n"
+		"\t\"fps\": %.2f,\n"
+		"\t\"latency_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"max\": %.4f },\n"
+		"\t\"stage_ms\": { \"simulation\": %.4f, \"render\": %.4f, \"sync_wait\": %.4f },\n"
+		"\t\"memory_bytes\": { \"gpu\": %llu, \"cpu\": %llu, \"textures\": %llu, \"mesh_geometry\": %llu }\n"
+		"}\n",
+		options.scene_file.c_str(),
+		options.path_file.empty() ? "orbit" : options.path_file.c_str(),
+		reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+		s_WIDTH, s_HEIGHT,
+		static_cast<unsigned long long>(frame->count()),
+		options.warmup,
+		load_seconds,
+		frame->mean(), frame->percentile(0.50), frame->percentile(0.95), frame->percentile(0.99), frame->max(),
+		submit->mean(), submit->percentile(0.50), submit->percentile(0.95), submit->percentile(0.99), submit->max(),
+		static_cast<unsigned long long>(frame_times.hitches()),
+		frame_times.get_budget(),
+		double(draws.draw_calls) / frames,
+		static_cast<unsigned long long>(draws.max_draw_calls),
+		double(draws.vertices) / frames,
+		static_cast<unsigned long long>(draws.max_vertices),
+		double(draws.texture_binds) / frames,
+		static_cast<unsigned long long>(draws.max_texture_binds),
+		double(draws.heap_allocations) / frames,
+		static_cast<unsigned long long>(draws.max_heap_allocations),
+		options.drop_geometry ? "true" : "false",
+		pipeline.threaded() ? "threaded" : "serial",
+		options.pack_file.empty() ? "none" : options.pack_file.c_str(),
+		pipeline.frames_per_second(),
+		latency->mean(), latency->percentile(0.50), latency->percentile(0.95), latency->max(),
+		pipeline.simulation_times()->mean(), pipeline.render_times()->mean(), pipeline.wait_times()->mean(),
+		static_cast<unsigned long long>(Memory_Stats::gpu_bytes()),
+		static_cast<unsigned long long>(Memory_Stats::cpu_bytes()),
+		static_cast<unsigned long long>(Memory_Stats::current(mTEXTURES)),
+		static_cast<unsigned long long>(Memory_Stats::current(mMESH_GEOMETRY)));
+
+	return buffer;
+}
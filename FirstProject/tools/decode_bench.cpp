@@ -0,0 +1,133 @@
+/*	Author: Ben Weatherall
+	Description: Image decode benchmark. Decodes every image in a directory one after another on this
+	thread (as the loaders used to), then all at once through Image_Decoder on the job system, and
+	prints both totals, the speedup and the decoded bytes. The two decodes of each image are hashed
+	and compared, so a mismatch would show up as a failure.
+
+	Build with "make decode_bench" and run "./decode_bench [directory] [threads]" (default ./Materials/
+	and one worker per spare hardware thread).
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../include/Content_Hash.h"
+#include "../include/File_IO.h"
+#include "../include/Image_Decoder.h"
+#include "../include/Job_System.h"
+#include "../include/Resource_Manager.h"
+
+#include "../include/stb_image.h"
+
+#define REPEATS 3
+
+struct Decode_Result {
+	std::string name;
+	uint64_t bytes;
+	uint64_t hash;
+	double serial_ms;
+};
+
+static bool is_image(std::string name)
+{
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+	for (const char* extension : extensions)
+	{
+		size_t length = strlen(extension);
+		if (name.size() > length && name.compare(name.size() - length, length, extension) == 0)
+			return true;
+	}
+	return false;
+}
+
+static double now_ms()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t image_hash(const Decoded_Image &image)
+{
+	return image.pixels ? content_hash(image.pixels, size_t(image.width) * image.height * image.channels) : 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string directory = argc > 1 ? argv[1] : "./Materials/";
+	uint32_t threads = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 0;
+	if (directory.back() != '/' && directory.back() != '\\')
+		directory += "/";
+
+	std::vector<Decode_Result> results;
+	for (const std::string &name : DirectoryContents(directory))
+	{
+		if (is_image(name))
+			results.push_back({ name, 0, 0, 0 });
+	}
+	std::sort(results.begin(), results.end(), [](const Decode_Result &a, const Decode_Result &b) { return a.name < b.name; });
+	if (results.empty())
+	{
+		printf("No images in %s\n", directory.c_str());
+		return 1;
+	}
+
+	// Serial, the way Mesh / Heightmap / Skybox decoded before
+	double serial = 1e30;
+	for (uint32_t repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		double start = now_ms();
+		for (Decode_Result &result : results)
+		{
+			double image_start = now_ms();
+			Decoded_Image image = { nullptr, 0, 0, 0 };
+			image.pixels = stbi_load((directory + result.name).c_str(), &image.width, &image.height, &image.channels, 0);
+			result.serial_ms = now_ms() - image_start;
+			result.bytes = uint64_t(image.width) * image.height * image.channels;
+			result.hash = image_hash(image);
+			Image_Decoder::free(image);
+		}
+		serial = std::min(serial, now_ms() - start);
+	}
+
+	// Every image queued on the decode service, consumed in order like the GL thread would
+	Job_System::start(threads);
+	double parallel = 1e30;
+	uint32_t mismatched = 0;
+	for (uint32_t repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		mismatched = 0;
+		double start = now_ms();
+		std::vector<Image_Future> decodes;
+		decodes.reserve(results.size());
+		for (const Decode_Result &result : results)
+			decodes.push_back(Image_Decoder::decode(directory + result.name));
+		for (uint32_t idx = 0; idx < decodes.size(); ++idx)
+		{
+			Decoded_Image image = decodes[idx].get();
+			mismatched += image_hash(image) != results[idx].hash;
+			Image_Decoder::free(image);
+		}
+		parallel = std::min(parallel, now_ms() - start);
+	}
+	uint32_t thread_count = Job_System::thread_count();
+	Job_System::stop();
+
+	uint64_t total_bytes = 0;
+	printf("%-40s %12s %10s\n", "image", "decoded", "ms");
+	for (const Decode_Result &result : results)
+	{
+		printf("%-40s %12s %10.2f\n", result.name.c_str(), format_bytes(result.bytes).c_str(), result.serial_ms);
+		total_bytes += result.bytes;
+	}
+	printf("\n%u images, %s decoded (best of %u)\n", static_cast<uint32_t>(results.size()), format_bytes(total_bytes).c_str(), REPEATS);
+	printf("Serial:   %10.1f ms\n", serial);
+	printf("Parallel: %10.1f ms on %u threads (queue of %u), %.2fx\n", parallel, thread_count, IMAGE_DECODE_QUEUE, serial / parallel);
+	if (mismatched)
+		printf("%u images decoded differently in parallel\n", mismatched);
+	return mismatched ? 1 : 0;
+}
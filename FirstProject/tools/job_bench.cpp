@@ -0,0 +1,159 @@
+/*	Author: Ben Weatherall
+	Description: Microbenchmark for Job_System. Measures the cost of scheduling (empty jobs and an
+	empty parallel_for, in nanoseconds per job) and how a compute bound parallel_for scales from one
+	thread to every hardware thread. Continuation and child ordering are checked along the way.
+
+	Build with "make job_bench" and run "./job_bench [items] [threads]" (default 4M items and
+	every hardware thread).
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../include/Job_System.h"
+
+#define WORK_ITEMS (4u << 20)
+#define WORK_BATCH 4096
+#define EMPTY_JOBS 100000
+#define EMPTY_ROUND 500
+#define REPEATS 5
+
+static std::atomic<uint32_t> counter(0);
+
+static void empty_job(Job*, const void*)
+{
+}
+
+static void count_job(Job*, const void*)
+{
+	counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Each continuation checks the job before it ran first
+static void chain_job(Job*, const void* data)
+{
+	uint32_t expected;
+	memcpy(&expected, data, sizeof(expected));
+	uint32_t seen = expected;
+	counter.compare_exchange_strong(seen, expected + 1);
+}
+
+static double now_ms()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Best of REPEATS, in milliseconds
+template <typename Function>
+static double best_of(Function function)
+{
+	double best = 1e30;
+	for (uint32_t repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		double start = now_ms();
+		function();
+		best = std::min(best, now_ms() - start);
+	}
+	return best;
+}
+
+static bool check_dependencies()
+{
+	// Children keep the root open
+	counter.store(0);
+	Job* root = Job_System::create(empty_job);
+	for (uint32_t idx = 0; idx < EMPTY_ROUND; ++idx)
+		Job_System::run(Job_System::create_child(root, count_job));
+	Job_System::run(root);
+	Job_System::wait(root);
+	bool children = counter.load() == EMPTY_ROUND;
+
+	// A chain of continuations runs in order
+	counter.store(0);
+	uint32_t step = 0;
+	Job* first = Job_System::create(chain_job, &step, sizeof(step));
+	Job* previous = first;
+	std::vector<Job*> chain(1, first);
+	for (step = 1; step < 4; ++step)
+	{
+		Job* next = Job_System::create(chain_job, &step, sizeof(step));
+		Job_System::add_continuation(previous, next);
+		chain.push_back(next);
+		previous = next;
+	}
+	Job_System::run(first);
+	Job_System::wait(chain.back());
+	bool continuations = counter.load() == 4;
+
+	return children && continuations;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t items = argc > 1 ? std::max(1, atoi(argv[1])) : WORK_ITEMS;
+	uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t max_threads = argc > 2 ? std::max(1, atoi(argv[2])) : hardware;
+	max_threads = std::min<uint32_t>(max_threads, JOB_MAX_WORKERS + 1);
+
+	std::vector<float> input(items), output(items);
+	for (uint32_t idx = 0; idx < items; ++idx)
+		input[idx] = static_cast<float>(idx % 1000) * 0.001f;
+
+	// Enough maths per item that memory bandwidth is not the limit
+	auto work = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t idx = begin; idx < end; ++idx)
+		{
+			float value = input[idx];
+			for (uint32_t round = 0; round < 16; ++round)
+				value = std::sin(value) * 0.5f + std::sqrt(value + 1.0f);
+			output[idx] = value;
+		}
+	};
+
+	double serial = best_of([&]() { work(0, items); });
+	printf("%u items, %u hardware threads\n", items, hardware);
+	printf("Plain loop\t%.2f ms\n\n", serial);
+
+	printf("threads\tparallel_for ms\tspeedup\tempty job ns\tempty parallel_for ns/item\n");
+	for (uint32_t threads = 1; threads <= max_threads; ++threads)
+	{
+		Job_System::start(threads - 1);
+
+		double parallel = best_of([&]() { Job_System::parallel_for(items, WORK_BATCH, work); });
+
+		// Scheduling cost alone: empty children of a root (in rounds that fit the job ring), then an
+		// empty parallel_for in batches of one
+		double spawn = best_of([&]() {
+			for (uint32_t round = 0; round < EMPTY_JOBS; round += EMPTY_ROUND)
+			{
+				Job* root = Job_System::create(empty_job);
+				for (uint32_t idx = 0; idx < EMPTY_ROUND; ++idx)
+					Job_System::run(Job_System::create_child(root, empty_job));
+				Job_System::run(root);
+				Job_System::wait(root);
+			}
+		});
+		double split = best_of([&]() {
+			Job_System::parallel_for(EMPTY_JOBS, 1, [](uint32_t, uint32_t) {});
+		});
+
+		bool correct = check_dependencies();
+		printf("%u\t%.2f\t\t%.2fx\t%.1f\t\t%.1f%s\n", threads, parallel, serial / parallel,
+			spawn * 1e6 / EMPTY_JOBS, split * 1e6 / EMPTY_JOBS, correct ? "" : "\tDEPENDENCY ORDER WRONG");
+
+		Job_System::stop();
+	}
+
+	// Keep the work from being optimised away
+	float sum = 0;
+	for (uint32_t idx = 0; idx < items; idx += 4096)
+		sum += output[idx];
+	printf("\n(checksum %.3f)\n", sum);
+	return 0;
+}
@@ -0,0 +1,172 @@
+/*	Author: Ben Weatherall
+	Description: Offline texture cooker. Decodes every image in a directory, builds its mip chain, block
+	compresses it and writes the DDS the game would otherwise cook on first load (see Texture_Cache),
+	one image per job. Images named on a "norm" line of any .mtl in the directory are cooked as normal
+	maps (BC5), the rest as colour (BC1 / BC3). Images whose cache is already newer than the source are
+	skipped unless --force is given. Prints the size, format and encode error of each.
+
+	Build with "make texture_cook" and run "./texture_cook [directory] [--force]" (default ./Materials/).
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../include/File_IO.h"
+#include "../include/Job_System.h"
+#include "../include/Resource_Manager.h"
+#include "../include/Texture_Cache.h"
+
+struct Cook_Result {
+	std::string name;
+	Texture_Usage usage;
+	bool cooked;
+	bool failed;
+	double ms;
+	uint64_t source_bytes;
+	uint64_t cache_bytes;
+	Texture_Info info;
+};
+
+static bool is_image(std::string name)
+{
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+	for (const char* extension : extensions)
+	{
+		size_t length = strlen(extension);
+		if (name.size() > length && name.compare(name.size() - length, length, extension) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Images the directory's materials use as normal maps
+static std::vector<std::string> normal_maps(const std::string &directory, const std::vector<std::string> &files)
+{
+	std::vector<std::string> normals;
+	for (const std::string &name : files)
+	{
+		if (name.size() < 4 || name.compare(name.size() - 4, 4, ".mtl") != 0)
+			continue;
+
+		std::ifstream material(directory + name);
+		std::string line;
+		while (std::getline(material, line))
+		{
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 5, "norm ") != 0)
+				continue;
+			size_t texture = line.find_last_of(" \t");
+			std::string texture_name = line.substr(texture + 1);
+			if (!texture_name.empty() && texture_name.back() == '\r')
+				texture_name.pop_back();
+			normals.push_back(texture_name);
+		}
+	}
+	return normals;
+}
+
+static uint64_t file_size(const std::string &file_name)
+{
+	std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+	return file ? static_cast<uint64_t>(file.tellg()) : 0;
+}
+
+// GPU bytes of everything cooked this run
+static uint64_t cook_total(const std::vector<Cook_Result> &results)
+{
+	uint64_t total = 0;
+	for (const Cook_Result &result : results)
+	{
+		if (result.cooked && !result.failed)
+			total += result.info.gpu_bytes;
+	}
+	return total;
+}
+
+int main(int argc, char** argv)
+{
+	std::string directory = "./Materials/";
+	bool force = false;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (strcmp(argv[arg], "--force") == 0)
+			force = true;
+		else
+			directory = argv[arg];
+	}
+	if (directory.back() != '/' && directory.back() != '\\')
+		directory += "/";
+
+	std::vector<std::string> files = DirectoryContents(directory);
+	std::vector<std::string> normals = normal_maps(directory, files);
+
+	std::vector<Cook_Result> results;
+	for (const std::string &name : files)
+	{
+		if (is_image(name))
+		{
+			Cook_Result result = {};
+			result.name = name;
+			result.usage = std::find(normals.begin(), normals.end(), name) != normals.end() ? TEXTURE_NORMAL : TEXTURE_COLOUR;
+			results.push_back(result);
+		}
+	}
+	std::sort(results.begin(), results.end(), [](const Cook_Result &a, const Cook_Result &b) { return a.name < b.name; });
+
+	Job_System::start();
+	auto start = std::chrono::steady_clock::now();
+	Job_System::parallel_for(static_cast<uint32_t>(results.size()), 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t idx = first; idx < last; ++idx)
+		{
+			Cook_Result &result = results[idx];
+			std::string source = directory + result.name;
+			if (force || Texture_Cache::stale(source))
+			{
+				auto cook_start = std::chrono::steady_clock::now();
+				result.failed = !Texture_Cache::cook(source, result.usage, &result.info);
+				result.cooked = true;
+				result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cook_start).count();
+			}
+			result.source_bytes = file_size(source);
+			result.cache_bytes = file_size(Texture_Cache::cache_path(source));
+		}
+	});
+	double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	uint32_t threads = Job_System::thread_count();
+	Job_System::stop();
+
+	uint64_t source_total = 0, cache_total = 0, uncompressed_total = 0;
+	uint32_t cooked = 0, failed = 0;
+	printf("%-40s %12s %12s %7s %8s %10s\n", "image", "source", "cache", "format", "RMSE", "cook ms");
+	for (const Cook_Result &result : results)
+	{
+		printf("%-40s %12s %12s ", result.name.c_str(), format_bytes(result.source_bytes).c_str(), format_bytes(result.cache_bytes).c_str());
+		if (result.failed)
+			printf("%7s %8s %10s\n", "", "", "FAILED");
+		else if (result.cooked)
+			printf("%7s %8.2f %10.1f\n", Texture_Cache::format_name(result.info.format), result.info.error, result.ms);
+		else
+			printf("%7s %8s %10s\n", "", "", "up to date");
+
+		if (result.cooked && !result.failed)
+			uncompressed_total += result.info.uncompressed_bytes;
+
+		source_total += result.source_bytes;
+		cache_total += result.cache_bytes;
+		cooked += result.cooked && !result.failed;
+		failed += result.failed;
+	}
+	printf("\n%u cooked, %u failed, %u up to date in %.1f ms on %u threads\n", cooked, failed,
+		static_cast<uint32_t>(results.size()) - cooked - failed, total_ms, threads);
+	printf("Sources %s, cache %s (%s)\n", format_bytes(source_total).c_str(), format_bytes(cache_total).c_str(), TEXTURE_CACHE_DIR);
+	if (uncompressed_total)
+		printf("Cooked this run: %s of mip chains instead of %s uncompressed\n", format_bytes(cook_total(results)).c_str(),
+			format_bytes(uncompressed_total).c_str());
+	return failed ? 1 : 0;
+}
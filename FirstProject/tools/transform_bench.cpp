@@ -0,0 +1,251 @@
+/*	Author: Ben Weatherall
+	Description: Microbenchmark for Transform_Store. Builds COMPONENT_COUNT transforms twice: once the
+	way Object / Component used to hold them (heap allocated glm pointers per component, components
+	in a heap allocated std::map) and once in the structure of arrays store. Times rebuilding every
+	matrix and an AABB sweep (the collision test the player runs), and on Linux reads the hardware
+	cache miss counter around each pass.
+
+	Build with "make transform_bench" and run "./transform_bench [count]".
+*/
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "../include/Transform_Store.h"
+
+#define COMPONENT_COUNT 100000
+#define REPEATS 10
+
+// The fields Component used to carry, allocated the way it allocated them
+struct Legacy_Component {
+	std::string m_name;
+	std::string m_mesh_name;
+	void* m_Mesh;
+
+	glm::quat* m_rotation;
+	glm::vec3* m_location;
+	glm::vec3* m_scale;
+	glm::mat4 m_transform;
+
+	glm::vec3 m_lower_bounds;
+	glm::vec3 m_upper_bounds;
+};
+
+// Hardware cache miss counter for the calling thread; reports -1 where unavailable
+class Cache_Miss_Counter {
+public:
+	Cache_Miss_Counter()
+	{
+		fd = -1;
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~Cache_Miss_Counter()
+	{
+#ifdef __linux__
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+	void start()
+	{
+#ifdef __linux__
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	long long stop()
+	{
+		long long count = -1;
+#ifdef __linux__
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &count, sizeof(count)) != sizeof(count))
+				count = -1;
+		}
+#endif
+		return count;
+	}
+private:
+	int fd;
+};
+
+struct Pass_Result {
+	double best_ms;
+	long long cache_misses;
+};
+
+// Best of REPEATS; cache misses from the best run
+template <typename Pass>
+Pass_Result time_pass(Pass pass, Cache_Miss_Counter &counter)
+{
+	Pass_Result result = { 1.0e30, -1 };
+	for (int repeat = 0; repeat < REPEATS; ++repeat)
+	{
+		counter.start();
+		auto start = std::chrono::steady_clock::now();
+		pass();
+		auto end = std::chrono::steady_clock::now();
+		long long misses = counter.stop();
+
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (ms < result.best_ms)
+		{
+			result.best_ms = ms;
+			result.cache_misses = misses;
+		}
+	}
+	return result;
+}
+
+void print_result(const char* name, Pass_Result legacy, Pass_Result store, uint32_t count)
+{
+	printf("%-16s legacy %8.3f ms (%6.2f ns/item)   store %8.3f ms (%6.2f ns/item)   %.2fx\n",
+		name, legacy.best_ms, legacy.best_ms * 1.0e6 / count, store.best_ms, store.best_ms * 1.0e6 / count,
+		legacy.best_ms / store.best_ms);
+	if (legacy.cache_misses >= 0 && store.cache_misses >= 0)
+	{
+		printf("%-16s legacy %8lld misses              store %8lld misses\n", "", legacy.cache_misses, store.cache_misses);
+	}
+	else
+	{
+		printf("%-16s cache misses unavailable (perf_event_open not permitted)\n", "");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : COMPONENT_COUNT;
+	if (count == 0)
+		count = COMPONENT_COUNT;
+
+	srand(1);
+	std::vector<glm::vec3> locations(count), scales(count), rotations(count);
+	for (uint32_t idx = 0; idx < count; ++idx)
+	{
+		locations[idx] = glm::vec3(rand() % 2000 - 1000.0f, rand() % 50 * 1.0f, rand() % 2000 - 1000.0f);
+		scales[idx] = glm::vec3(1.0f + rand() % 4);
+		rotations[idx] = glm::vec3(0.0f, (rand() % 628) / 100.0f, 0.0f);
+	}
+
+	// -- Legacy: a map of heap components, each with three more heap allocations --
+	std::map<std::string, Legacy_Component*>* legacy = new std::map<std::string, Legacy_Component*>;
+	for (uint32_t idx = 0; idx < count; ++idx)
+	{
+		Legacy_Component* component = new Legacy_Component;
+		component->m_name = "Component_" + std::to_string(idx);
+		component->m_mesh_name = "./Meshes/mesh_" + std::to_string(idx % 64) + ".obj";
+		component->m_Mesh = nullptr;
+		component->m_location = new glm::vec3(locations[idx]);
+		component->m_scale = new glm::vec3(scales[idx]);
+		component->m_rotation = new glm::quat(rotations[idx]);
+		component->m_lower_bounds = locations[idx] - scales[idx];
+		component->m_upper_bounds = locations[idx] + scales[idx];
+		legacy->operator[](component->m_name) = component;
+	}
+
+	// -- Store --
+	Transform_Store store;
+	for (uint32_t idx = 0; idx < count; ++idx)
+	{
+		Transform_Handle handle = store.create(locations[idx], glm::quat(rotations[idx]), scales[idx]);
+		store.set_bounds(handle, locations[idx] - scales[idx], locations[idx] + scales[idx]);
+	}
+
+	Cache_Miss_Counter counter;
+	float checksum = 0.0f;
+
+	// Rebuild every matrix
+	Pass_Result legacy_update = time_pass([&]() {
+		for (auto &component : *legacy)
+		{
+			Legacy_Component* c = component.second;
+			c->m_transform = glm::translate(glm::mat4(), *c->m_location);
+			c->m_transform *= glm::toMat4(*c->m_rotation);
+			c->m_transform = glm::scale(c->m_transform, *c->m_scale);
+		}
+	}, counter);
+	Pass_Result store_update = time_pass([&]() {
+		store.update_all();
+	}, counter);
+
+	// AABB sweep with a player sized box
+	glm::vec3 query_lower(-50.0f, 0.0f, -50.0f), query_upper(50.0f, 10.0f, 50.0f);
+	uint32_t legacy_hits = 0, store_hits = 0;
+
+	Pass_Result legacy_query = time_pass([&]() {
+		legacy_hits = 0;
+		for (auto &component : *legacy)
+		{
+			Legacy_Component* c = component.second;
+			if (query_lower.x <= c->m_upper_bounds.x && query_upper.x >= c->m_lower_bounds.x &&
+				query_lower.y <= c->m_upper_bounds.y && query_upper.y >= c->m_lower_bounds.y &&
+				query_lower.z <= c->m_upper_bounds.z && query_upper.z >= c->m_lower_bounds.z)
+			{
+				legacy_hits++;
+			}
+		}
+	}, counter);
+	std::vector<Transform_Handle> overlapping;
+	overlapping.reserve(count);
+	Pass_Result store_query = time_pass([&]() {
+		overlapping.clear();
+		store.query(query_lower, query_upper, overlapping);
+		store_hits = static_cast<uint32_t>(overlapping.size());
+	}, counter);
+
+	for (auto &component : *legacy)
+		checksum += component.second->m_transform[3][0];
+	for (uint32_t idx = 0; idx < store.capacity(); ++idx)
+	{
+		Transform_Handle handle = { idx, 1 };
+		checksum -= store.matrix(handle)[3][0];
+	}
+
+	printf("Transform benchmark: %u components, best of %d\n", count, REPEATS);
+	print_result("update matrices", legacy_update, store_update, count);
+	print_result("aabb sweep", legacy_query, store_query, count);
+	printf("Overlaps: legacy %u, store %u (checksum %g)\n", legacy_hits, store_hits, checksum);
+
+	for (auto &component : *legacy)
+	{
+		delete component.second->m_location;
+		delete component.second->m_scale;
+		delete component.second->m_rotation;
+		delete component.second;
+	}
+	delete legacy;
+
+	return legacy_hits == store_hits ? 0 : 1;
+}